@@ -0,0 +1,153 @@
+// Aggregate.cpp
+#include "Aggregate.hpp"
+#include "Diagnostics.hpp"
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <iostream>
+
+std::string Aggregate::label() const {
+    static const char* names[] = {"COUNT", "SUM", "AVG", "MIN", "MAX"};
+    return std::string(names[static_cast<int>(func)]) + "(" + (distinct ? "DISTINCT " : "") + column + ")";
+}
+
+bool parseAggregate(const std::string& func, const std::string& arg, Aggregate& aggregate) {
+    std::string name = func;
+    std::transform(name.begin(), name.end(), name.begin(), ::toupper);
+    if (name == "COUNT") aggregate.func = AggregateFunc::Count;
+    else if (name == "SUM") aggregate.func = AggregateFunc::Sum;
+    else if (name == "AVG") aggregate.func = AggregateFunc::Avg;
+    else if (name == "MIN") aggregate.func = AggregateFunc::Min;
+    else if (name == "MAX") aggregate.func = AggregateFunc::Max;
+    else {
+        errorStream() << "Error: Unsupported aggregate function '" << name << "'.\n";
+        return false;
+    }
+    aggregate.column = arg;
+    aggregate.distinct = false;
+    std::string upper = arg.substr(0, 9);
+    std::transform(upper.begin(), upper.end(), upper.begin(), ::toupper);
+    if (upper == "DISTINCT ") {
+        if (aggregate.func != AggregateFunc::Count) {
+            errorStream() << "Error: DISTINCT is only supported in COUNT.\n";
+            return false;
+        }
+        aggregate.distinct = true;
+        aggregate.column = arg.substr(9);
+        aggregate.column.erase(0, aggregate.column.find_first_not_of(' '));
+    }
+    if (aggregate.column.empty() || (aggregate.column == "*" && (aggregate.func != AggregateFunc::Count || aggregate.distinct))) {
+        errorStream() << "Error: Invalid argument '" << arg << "' for " << name << ".\n";
+        return false;
+    }
+    return true;
+}
+
+static bool isIntegral(ColumnType type) {
+    return type == ColumnType::Int || type == ColumnType::BigInt || type == ColumnType::Bool;
+}
+
+ColumnType Aggregate::resultType(ColumnType column_type) const {
+    switch (func) {
+        case AggregateFunc::Count: return ColumnType::BigInt;
+        case AggregateFunc::Sum: return isIntegral(column_type) ? ColumnType::BigInt : ColumnType::Double;
+        case AggregateFunc::Avg: return ColumnType::Double;
+        case AggregateFunc::Min:
+        case AggregateFunc::Max: break;
+    }
+    return column_type;
+}
+
+// Integers add up in 64 bits until that would overflow, then in 128
+void Accumulator::addInt(int64_t value) {
+    int64_t sum;
+    if (__builtin_add_overflow(int_sum, value, &sum)) {
+        wide_sum += int_sum;
+        wide_sum += value;
+        int_sum = 0;
+    } else {
+        int_sum = sum;
+    }
+}
+
+static std::string formatWide(__int128 value) {
+    if (value >= INT64_MIN && value <= INT64_MAX) return std::to_string(static_cast<int64_t>(value));
+    unsigned __int128 magnitude = value < 0 ? -static_cast<unsigned __int128>(value) : value;
+    std::string digits;
+    for (; magnitude != 0; magnitude /= 10) digits.insert(digits.begin(), static_cast<char>('0' + magnitude % 10));
+    return value < 0 ? "-" + digits : digits;
+}
+
+void Accumulator::add(const Aggregate& aggregate, ColumnType type, std::string_view stored) {
+    switch (aggregate.func) {
+        case AggregateFunc::Count:
+            if (aggregate.column == "*") {
+                count++;
+            } else if (!stored.empty()) {
+                // Like COUNT(column), DISTINCT skips empty values
+                if (aggregate.distinct) distinct.emplace(stored);
+                else count++;
+            }
+            return;
+        case AggregateFunc::Sum:
+        case AggregateFunc::Avg:
+            if (stored.size() == fixedWidth(type) && isIntegral(type)) {
+                if (type == ColumnType::Int) addInt(loadValue<int32_t>(stored));
+                else if (type == ColumnType::BigInt) addInt(loadValue<int64_t>(stored));
+                else addInt(stored[0] ? 1 : 0);
+            } else if (type == ColumnType::Double && stored.size() == sizeof(double)) {
+                double_sum += loadValue<double>(stored);
+            } else {
+                // Untyped column: sum whatever parses as a number, skip the rest
+                double value;
+                auto parsed = std::from_chars(stored.data(), stored.data() + stored.size(), value);
+                if (stored.empty() || parsed.ec != std::errc() || parsed.ptr != stored.data() + stored.size()) return;
+                double_sum += value;
+            }
+            count++;
+            return;
+        case AggregateFunc::Min:
+        case AggregateFunc::Max: {
+            if (stored.empty() && type == ColumnType::Text) return;
+            int c = count == 0 ? 0 : compareValues(type, stored, extreme);
+            if (count == 0 || (aggregate.func == AggregateFunc::Min ? c < 0 : c > 0)) {
+                extreme.assign(stored);
+            }
+            count++;
+            return;
+        }
+    }
+}
+
+void Accumulator::merge(const Aggregate& aggregate, ColumnType type, const Accumulator& other) {
+    if ((aggregate.func == AggregateFunc::Min || aggregate.func == AggregateFunc::Max) && other.count > 0) {
+        int c = count == 0 ? 0 : compareValues(type, other.extreme, extreme);
+        if (count == 0 || (aggregate.func == AggregateFunc::Min ? c < 0 : c > 0)) {
+            extreme = other.extreme;
+        }
+    }
+    count += other.count;
+    addInt(other.int_sum);
+    wide_sum += other.wide_sum;
+    double_sum += other.double_sum;
+    distinct.insert(other.distinct.begin(), other.distinct.end());
+}
+
+std::string Accumulator::result(const Aggregate& aggregate, ColumnType type) const {
+    switch (aggregate.func) {
+        case AggregateFunc::Count:
+            return std::to_string(aggregate.distinct ? distinct.size() : count);
+        case AggregateFunc::Sum:
+            if (count == 0) return "NULL";
+            // A sum past the range of BIGINT is shown in full rather than wrapped
+            return isIntegral(type) ? formatWide(wide_sum + int_sum) : formatDouble(double_sum);
+        case AggregateFunc::Avg:
+            if (count == 0) return "NULL";
+            if (!isIntegral(type)) return formatDouble(double_sum / count);
+            return formatDouble(static_cast<double>(static_cast<long double>(wide_sum + int_sum) / count));
+        case AggregateFunc::Min:
+        case AggregateFunc::Max:
+            return count == 0 ? "NULL" : formatValue(type, extreme);
+    }
+    return "NULL";
+}
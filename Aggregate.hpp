@@ -0,0 +1,60 @@
+// Aggregate.hpp
+#ifndef AGGREGATE_HPP
+#define AGGREGATE_HPP
+
+#include "Value.hpp"
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+
+enum class AggregateFunc {
+    Count,
+    Sum,
+    Avg,
+    Min,
+    Max
+};
+
+// One aggregate of a SELECT list, e.g. COUNT(*), SUM(price), COUNT(DISTINCT city)
+struct Aggregate {
+    AggregateFunc func = AggregateFunc::Count;
+    std::string column; // "*" for COUNT(*)
+    bool distinct = false;
+
+    std::string label() const;
+    // Type of the aggregate's values over a column of column_type: BIGINT for
+    // COUNT and integral SUM, DOUBLE for AVG and other SUMs, MIN/MAX keep it
+    ColumnType resultType(ColumnType column_type) const;
+};
+
+// Build an aggregate from the name and argument of FUNC(arg); reports and
+// returns false for unsupported functions
+bool parseAggregate(const std::string& func, const std::string& arg, Aggregate& aggregate);
+
+// Running state of one aggregate over one group: a few counters and at most
+// one stored value, so a group costs the same however many rows it has.
+// COUNT(DISTINCT) is the exception and keeps the distinct values it has seen.
+class Accumulator {
+private:
+    uint64_t count = 0;    // rows (COUNT(*)) or values accumulated
+    int64_t int_sum = 0;   // SUM/AVG over INT, BIGINT and BOOL columns
+    __int128 wide_sum = 0; // what int_sum could not hold: the sum is wide_sum + int_sum
+    double double_sum = 0; // SUM/AVG over DOUBLE and numeric TEXT
+    std::string extreme;   // MIN/MAX so far, in stored form
+    std::unordered_set<std::string> distinct;
+
+    void addInt(int64_t value);
+
+public:
+    // Fold in one row; stored is the row's value of the aggregate's column (unused for COUNT(*))
+    void add(const Aggregate& aggregate, ColumnType type, std::string_view stored);
+    // Fold in the state of another accumulator of the same aggregate, e.g. a partial
+    // aggregate over another part of the table
+    void merge(const Aggregate& aggregate, ColumnType type, const Accumulator& other);
+    // Final value as text; NULL when SUM, AVG, MIN or MAX saw no values
+    std::string result(const Aggregate& aggregate, ColumnType type) const;
+    bool isNull(const Aggregate& aggregate) const { return aggregate.func != AggregateFunc::Count && count == 0; }
+};
+
+#endif // AGGREGATE_HPP
@@ -0,0 +1,231 @@
+// BTreeIndex.cpp
+#include "BTreeIndex.hpp"
+#include <algorithm>
+
+BTreeIndex::BTreeIndex(const std::string& name, int column, ColumnType type)
+    : Index(name, column), type(type), root(std::make_unique<Node>()) {}
+
+BTreeIndex::BTreeIndex(const BTreeIndex& other)
+    : Index(other.name, other.column), type(other.type), root(std::make_unique<Node>()) {
+    bulkLoad(other.entries());
+    built = other.isBuilt();
+}
+
+const BTreeIndex::Node* BTreeIndex::leafFor(const Entry& target) const {
+    const Node* node = root.get();
+    while (!node->leaf) {
+        auto it = std::upper_bound(node->entries.begin(), node->entries.end(), target, byEntry());
+        node = node->children[it - node->entries.begin()].get();
+    }
+    return node;
+}
+
+std::vector<BTreeIndex::Entry> BTreeIndex::entries() const {
+    std::vector<Entry> out;
+    out.reserve(count);
+    const Node* node = root.get();
+    while (!node->leaf) node = node->children.front().get();
+    for (; node; node = node->next) {
+        out.insert(out.end(), node->entries.begin(), node->entries.end());
+    }
+    return out;
+}
+
+void BTreeIndex::bulkLoad(std::vector<Entry> sorted) {
+    count = sorted.size();
+    erased_since_build = 0;
+    // Leaves are filled to three quarters so the next inserts do not split at once
+    const size_t fill = MAX_ENTRIES * 3 / 4;
+    std::vector<std::unique_ptr<Node>> level;
+    std::vector<Entry> mins; // smallest entry under each node of the level
+    Node* prev = nullptr;
+    for (size_t i = 0; i < sorted.size(); i += fill) {
+        auto leaf = std::make_unique<Node>();
+        size_t end = std::min(sorted.size(), i + fill);
+        leaf->entries.assign(std::make_move_iterator(sorted.begin() + i), std::make_move_iterator(sorted.begin() + end));
+        leaf->prev = prev;
+        if (prev) prev->next = leaf.get();
+        prev = leaf.get();
+        mins.push_back(leaf->entries.front());
+        level.push_back(std::move(leaf));
+    }
+    if (level.empty()) {
+        root = std::make_unique<Node>();
+        return;
+    }
+    while (level.size() > 1) {
+        std::vector<std::unique_ptr<Node>> parents;
+        std::vector<Entry> parent_mins;
+        for (size_t i = 0; i < level.size(); i += fill + 1) {
+            auto parent = std::make_unique<Node>();
+            parent->leaf = false;
+            size_t end = std::min(level.size(), i + fill + 1);
+            parent_mins.push_back(mins[i]);
+            for (size_t c = i; c < end; ++c) {
+                if (c > i) parent->entries.push_back(mins[c]);
+                parent->children.push_back(std::move(level[c]));
+            }
+            parents.push_back(std::move(parent));
+        }
+        level = std::move(parents);
+        mins = std::move(parent_mins);
+    }
+    root = std::move(level.front());
+}
+
+void BTreeIndex::build(size_t row_count, const std::function<std::string_view(size_t)>& key_of) {
+    std::vector<Entry> sorted;
+    sorted.reserve(row_count);
+    for (size_t row = 0; row < row_count; ++row) {
+        sorted.push_back({std::string(key_of(row)), row});
+    }
+    std::sort(sorted.begin(), sorted.end(), byEntry());
+    bulkLoad(std::move(sorted));
+    built = true;
+}
+
+bool BTreeIndex::insertInto(Node* node, Entry entry, Entry& separator, std::unique_ptr<Node>& right) {
+    if (node->leaf) {
+        auto pos = std::upper_bound(node->entries.begin(), node->entries.end(), entry, byEntry());
+        node->entries.insert(pos, std::move(entry));
+        if (node->entries.size() <= MAX_ENTRIES) return false;
+        // Split the leaf in half and link the new right sibling
+        right = std::make_unique<Node>();
+        size_t half = node->entries.size() / 2;
+        right->entries.assign(std::make_move_iterator(node->entries.begin() + half),
+                              std::make_move_iterator(node->entries.end()));
+        node->entries.resize(half);
+        right->next = node->next;
+        right->prev = node;
+        if (node->next) node->next->prev = right.get();
+        node->next = right.get();
+        separator = right->entries.front();
+        return true;
+    }
+
+    size_t child = std::upper_bound(node->entries.begin(), node->entries.end(), entry, byEntry()) - node->entries.begin();
+    Entry child_separator;
+    std::unique_ptr<Node> child_right;
+    if (!insertInto(node->children[child].get(), std::move(entry), child_separator, child_right)) {
+        return false;
+    }
+    node->entries.insert(node->entries.begin() + child, std::move(child_separator));
+    node->children.insert(node->children.begin() + child + 1, std::move(child_right));
+    if (node->entries.size() <= MAX_ENTRIES) return false;
+
+    // Split the internal node; the middle separator moves up
+    right = std::make_unique<Node>();
+    right->leaf = false;
+    size_t mid = node->entries.size() / 2;
+    separator = std::move(node->entries[mid]);
+    right->entries.assign(std::make_move_iterator(node->entries.begin() + mid + 1),
+                          std::make_move_iterator(node->entries.end()));
+    right->children.assign(std::make_move_iterator(node->children.begin() + mid + 1),
+                           std::make_move_iterator(node->children.end()));
+    node->entries.resize(mid);
+    node->children.resize(mid + 1);
+    return true;
+}
+
+void BTreeIndex::insert(std::string_view key, size_t row) {
+    Entry separator;
+    std::unique_ptr<Node> right;
+    if (insertInto(root.get(), Entry{std::string(key), row}, separator, right)) {
+        auto new_root = std::make_unique<Node>();
+        new_root->leaf = false;
+        new_root->entries.push_back(std::move(separator));
+        new_root->children.push_back(std::move(root));
+        new_root->children.push_back(std::move(right));
+        root = std::move(new_root);
+    }
+    count++;
+}
+
+void BTreeIndex::erase(std::string_view key, size_t row) {
+    Entry target{std::string(key), row};
+    Node* leaf = const_cast<Node*>(leafFor(target));
+    auto pos = std::lower_bound(leaf->entries.begin(), leaf->entries.end(), target, byEntry());
+    if (pos == leaf->entries.end() || pos->row != row || pos->key != target.key) return;
+    leaf->entries.erase(pos);
+    count--;
+    // Leaves are allowed to run underfull; once as many entries were erased as
+    // remain, repack the tree instead of merging nodes one by one
+    if (++erased_since_build > count) {
+        bulkLoad(entries());
+    }
+}
+
+void BTreeIndex::remap(const std::vector<size_t>& new_ids) {
+    // Renumbering keeps the relative order of surviving rows, so entries stay sorted
+    std::vector<Entry> kept;
+    kept.reserve(count);
+    for (auto& entry : entries()) {
+        if (new_ids[entry.row] == SIZE_MAX) continue;
+        entry.row = new_ids[entry.row];
+        kept.push_back(std::move(entry));
+    }
+    bulkLoad(std::move(kept));
+}
+
+std::vector<size_t> BTreeIndex::lookup(const std::string& key) const {
+    std::vector<size_t> rows;
+    range(&key, true, &key, true, false, [&](size_t row) {
+        rows.push_back(row);
+        return true;
+    });
+    return rows;
+}
+
+void BTreeIndex::range(const std::string* lo, bool lo_inclusive, const std::string* hi, bool hi_inclusive,
+                       bool descending, const std::function<bool(size_t)>& visit) const {
+    auto above_lo = [&](const Entry& e) {
+        if (!lo) return true;
+        int c = compareValues(type, e.key, *lo);
+        return lo_inclusive ? c >= 0 : c > 0;
+    };
+    auto below_hi = [&](const Entry& e) {
+        if (!hi) return true;
+        int c = compareValues(type, e.key, *hi);
+        return hi_inclusive ? c <= 0 : c < 0;
+    };
+
+    if (!descending) {
+        const Node* leaf;
+        size_t pos = 0;
+        if (lo) {
+            Entry target{*lo, 0};
+            leaf = leafFor(target);
+            pos = std::lower_bound(leaf->entries.begin(), leaf->entries.end(), target, byEntry()) - leaf->entries.begin();
+        } else {
+            leaf = root.get();
+            while (!leaf->leaf) leaf = leaf->children.front().get();
+        }
+        for (; leaf; leaf = leaf->next, pos = 0) {
+            for (; pos < leaf->entries.size(); ++pos) {
+                const Entry& e = leaf->entries[pos];
+                if (!above_lo(e)) continue; // equal keys skipped by an exclusive bound
+                if (!below_hi(e) || !visit(e.row)) return;
+            }
+        }
+        return;
+    }
+
+    const Node* leaf;
+    size_t pos; // one past the next entry to visit
+    if (hi) {
+        Entry target{*hi, SIZE_MAX};
+        leaf = leafFor(target);
+        pos = std::upper_bound(leaf->entries.begin(), leaf->entries.end(), target, byEntry()) - leaf->entries.begin();
+    } else {
+        leaf = root.get();
+        while (!leaf->leaf) leaf = leaf->children.back().get();
+        pos = leaf->entries.size();
+    }
+    for (; leaf; leaf = leaf->prev, pos = leaf ? leaf->entries.size() : 0) {
+        for (; pos > 0; --pos) {
+            const Entry& e = leaf->entries[pos - 1];
+            if (!below_hi(e)) continue;
+            if (!above_lo(e) || !visit(e.row)) return;
+        }
+    }
+}
@@ -0,0 +1,65 @@
+// BTreeIndex.hpp
+#ifndef BTREE_INDEX_HPP
+#define BTREE_INDEX_HPP
+
+#include "Index.hpp"
+#include "Value.hpp"
+
+// Ordered index: a B+tree of (value, row id) entries with linked leaves.
+// Range predicates seek to their first entry and walk leaves in order, and
+// ORDER BY on the column reads rows in index order instead of sorting.
+class BTreeIndex : public Index {
+private:
+    struct Entry {
+        std::string key;
+        size_t row;
+    };
+    struct Node {
+        bool leaf = true;
+        // Leaf: the entries. Internal: separators, entries[i] is the
+        // smallest entry under children[i + 1].
+        std::vector<Entry> entries;
+        std::vector<std::unique_ptr<Node>> children;
+        Node* prev = nullptr; // sibling leaves
+        Node* next = nullptr;
+    };
+
+    static const size_t MAX_ENTRIES = 64;
+
+    ColumnType type; // keys are stored values of this type
+    std::unique_ptr<Node> root;
+    size_t count = 0;
+    size_t erased_since_build = 0;
+
+    bool less(const Entry& a, const Entry& b) const {
+        int c = compareValues(type, a.key, b.key);
+        return c < 0 || (c == 0 && a.row < b.row);
+    }
+    auto byEntry() const {
+        return [this](const Entry& a, const Entry& b) { return less(a, b); };
+    }
+    const Node* leafFor(const Entry& target) const;
+    bool insertInto(Node* node, Entry entry, Entry& separator, std::unique_ptr<Node>& right);
+    void bulkLoad(std::vector<Entry> sorted);
+    std::vector<Entry> entries() const;
+
+public:
+    BTreeIndex(const std::string& name, int column, ColumnType type);
+    BTreeIndex(const BTreeIndex& other);
+
+    IndexKind kind() const override { return IndexKind::BTree; }
+    std::unique_ptr<Index> clone() const override { return std::make_unique<BTreeIndex>(*this); }
+
+    void build(size_t row_count, const std::function<std::string_view(size_t)>& key_of) override;
+    void insert(std::string_view key, size_t row) override;
+    void erase(std::string_view key, size_t row) override;
+    void remap(const std::vector<size_t>& new_ids) override;
+    std::vector<size_t> lookup(const std::string& key) const override;
+
+    // Visit the rows whose key lies between the bounds (nullptr = unbounded) in key
+    // order, or reverse key order if descending. visit returns false to stop early.
+    void range(const std::string* lo, bool lo_inclusive, const std::string* hi, bool hi_inclusive,
+               bool descending, const std::function<bool(size_t)>& visit) const;
+};
+
+#endif // BTREE_INDEX_HPP
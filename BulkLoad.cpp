@@ -0,0 +1,192 @@
+// BulkLoad.cpp
+#include "BulkLoad.hpp"
+#include "Diagnostics.hpp"
+#include "MappedFile.hpp"
+#include "ThreadPool.hpp"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+// Bytes per parallel piece of the file: big enough that a chunk's fixed costs
+// vanish, small enough that every thread gets several on a large file
+const size_t CHUNK_BYTES = 4 * 1024 * 1024;
+
+// Offset just past the first newline at or after pos that is outside quotes,
+// given whether pos itself is inside quotes; size if there is none
+static size_t recordEnd(const char* data, size_t size, size_t pos, bool in_quotes) {
+    for (; pos < size; ++pos) {
+        if (data[pos] == '"') {
+            in_quotes = !in_quotes;
+        } else if (data[pos] == '\n' && !in_quotes) {
+            return pos + 1;
+        }
+    }
+    return size;
+}
+
+namespace {
+
+// Outcome of parsing one chunk
+struct ChunkResult {
+    RowBatch batch;
+    size_t lines = 0;      // newlines in the chunk
+    size_t error_line = 0; // 1-based within the chunk, 0 if every record was valid
+    std::string error;
+};
+
+}
+
+static void parseChunk(const char* p, const char* end, const std::vector<std::string>& columns,
+                       const std::vector<ColumnType>& types, StorageKind storage, ChunkResult& result) {
+    std::vector<std::string> fields(columns.size());
+    std::string text;
+    while (p < end) {
+        size_t line = result.lines + 1;
+        if (*p == '\n' || (*p == '\r' && p + 1 < end && p[1] == '\n')) {
+            // Blank line
+            p += *p == '\r' ? 2 : 1;
+            result.lines++;
+            continue;
+        }
+        size_t count = 0;
+        bool more = true;
+        while (more) {
+            text.clear();
+            std::string_view value;
+            const char* stop = p;
+            if (p < end && *p == '"') {
+                bool closed = false;
+                for (++p; p < end; ++p) {
+                    if (*p == '"') {
+                        if (p + 1 < end && p[1] == '"') {
+                            text.push_back('"');
+                            ++p;
+                            continue;
+                        }
+                        ++p;
+                        closed = true;
+                        break;
+                    }
+                    if (*p == '\n') result.lines++;
+                    text.push_back(*p);
+                }
+                if (!closed) {
+                    result.error_line = line;
+                    result.error = "Unterminated quoted field.";
+                    return;
+                }
+                // Only the delimiter, a line end or the end of the file may follow the closing quote
+                stop = p;
+                if (stop < end && *stop == '\r' && (stop + 1 == end || stop[1] == '\n')) ++stop;
+                if (stop < end && *stop != ',' && *stop != '\n') {
+                    result.error_line = line;
+                    result.error = "Text after the closing quote of a field.";
+                    return;
+                }
+                value = text;
+            } else {
+                // Unquoted text up to the delimiter
+                while (stop < end && *stop != ',' && *stop != '\n') ++stop;
+                // The chunks were cut by counting every quote as opening or closing
+                // one, so a quote anywhere else is rejected rather than read as text
+                if (std::memchr(p, '"', stop - p)) {
+                    result.error_line = line;
+                    result.error = "A quote inside a field that is not quoted as a whole.";
+                    return;
+                }
+                const char* value_end = stop;
+                if (value_end > p && value_end[-1] == '\r' && (stop == end || *stop == '\n')) --value_end;
+                // An unquoted field is encoded straight from the file
+                value = std::string_view(p, value_end - p);
+            }
+            more = stop < end && *stop == ',';
+            p = stop < end ? stop + 1 : end;
+            if (stop < end && *stop == '\n') result.lines++;
+
+            if (count < columns.size()) {
+                if (!encodeValue(types[count], value, fields[count])) {
+                    result.error_line = line;
+                    result.error = "Invalid " + std::string(columnTypeName(types[count])) + " value '" +
+                                   std::string(value) + "' for column " + columns[count] + ".";
+                    return;
+                }
+            }
+            count++;
+        }
+        if (count != columns.size()) {
+            result.error_line = line;
+            result.error = "Expected " + std::to_string(columns.size()) + " fields, found " + std::to_string(count) + ".";
+            return;
+        }
+        if (storage == StorageKind::Column) {
+            result.batch.columns.append(fields);
+        } else {
+            result.batch.records.push_back(result.batch.arena.append(fields));
+        }
+    }
+}
+
+bool parseCsvFile(const std::string& filepath, const std::vector<std::string>& columns,
+                  const std::vector<ColumnType>& types, StorageKind storage, bool header,
+                  std::vector<RowBatch>& batches, BulkLoadStats& stats) {
+    MappedFile file;
+    if (!file.open(filepath)) {
+        errorStream() << "Error: Unable to open file " << filepath << " for reading.\n";
+        return false;
+    }
+    const char* data = file.data();
+    size_t size = file.size();
+    ThreadPool& pool = ThreadPool::shared();
+
+    // Chunks must start at a record, and a newline inside quotes does not end
+    // one. Whether a block starts inside quotes follows from the quotes counted
+    // in the blocks before it, so every block finds its first record in parallel.
+    size_t blocks = std::max<size_t>(1, (size + CHUNK_BYTES - 1) / CHUNK_BYTES);
+    std::vector<size_t> quotes(blocks);
+    pool.parallelFor(blocks, [&](size_t b) {
+        size_t end = std::min(size, (b + 1) * CHUNK_BYTES);
+        quotes[b] = static_cast<size_t>(std::count(data + b * CHUNK_BYTES, data + end, '"'));
+    });
+    std::vector<bool> quoted(blocks, false); // block b starts inside quotes
+    for (size_t b = 1; b < blocks; ++b) quoted[b] = quoted[b - 1] != (quotes[b - 1] % 2 == 1);
+    size_t first = header ? recordEnd(data, size, 0, false) : 0;
+    std::vector<size_t> starts(blocks + 1, size);
+    pool.parallelFor(blocks, [&](size_t b) {
+        if (b == 0) {
+            starts[b] = first;
+            return;
+        }
+        // Start from the block's last byte before, so a record beginning exactly at the block counts
+        size_t pos = b * CHUNK_BYTES - 1;
+        starts[b] = std::max(first, recordEnd(data, size, pos, quoted[b] != (data[pos] == '"')));
+    });
+
+    std::vector<ChunkResult> results(blocks);
+    pool.parallelFor(blocks, [&](size_t b) {
+        ChunkResult& result = results[b];
+        if (storage == StorageKind::Column) result.batch.columns = ColumnStore(types);
+        parseChunk(data + starts[b], data + std::max(starts[b], starts[b + 1]), columns, types, storage, result);
+    });
+
+    // Chunks before the first bad one were parsed completely, so their line
+    // counts place the bad record in the file
+    size_t line = 1 + static_cast<size_t>(std::count(data, data + first, '\n'));
+    for (const auto& result : results) {
+        if (result.error_line != 0) {
+            errorStream() << "Error: " << filepath << " line " << line + result.error_line - 1 << ": " << result.error
+                      << "\n";
+            return false;
+        }
+        line += result.lines;
+    }
+    batches.clear();
+    stats = BulkLoadStats();
+    stats.bytes = size;
+    for (auto& result : results) {
+        stats.rows += result.batch.size();
+        if (result.batch.size() == 0) continue;
+        stats.chunks++;
+        batches.push_back(std::move(result.batch));
+    }
+    return true;
+}
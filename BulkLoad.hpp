@@ -0,0 +1,26 @@
+// BulkLoad.hpp
+#ifndef BULK_LOAD_HPP
+#define BULK_LOAD_HPP
+
+#include "Table.hpp"
+#include <string>
+#include <vector>
+
+struct BulkLoadStats {
+    size_t rows = 0;
+    size_t bytes = 0;
+    size_t chunks = 0; // pieces parsed in parallel
+};
+
+// Parse a CSV file (RFC 4180: comma separated, fields optionally in double
+// quotes with "" for a quote, CRLF or LF line ends; a quote anywhere else, a
+// quoted field left open, or text after its closing quote is an error) into
+// batches of stored rows for a table with these columns, types and layout.
+// The file is mapped and cut at record boundaries into chunks that are
+// parsed, checked against the schema and converted on the shared thread pool.
+// On the first bad record nothing is returned and its line is reported.
+bool parseCsvFile(const std::string& filepath, const std::vector<std::string>& columns,
+                  const std::vector<ColumnType>& types, StorageKind storage, bool header,
+                  std::vector<RowBatch>& batches, BulkLoadStats& stats);
+
+#endif // BULK_LOAD_HPP
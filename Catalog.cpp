@@ -0,0 +1,140 @@
+// Catalog.cpp
+#include "Catalog.hpp"
+#include "Diagnostics.hpp"
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+
+// File layout: magic, u32 entry count, then per entry
+//   name, u64 file size, i64 file mtime, u32 storage, u64 row count, u64 checkpoint LSN,
+//   u32 column count, (name, u8 type) per column, u32 index count, (name, u32 column, u8 kind) per index
+// Strings are a u32 length and the bytes.
+static const char CATALOG_MAGIC[8] = {'M', 'D', 'B', 'C', 'A', 'T', '0', '1'};
+
+template <typename T>
+static void putRaw(std::string& buf, T value) {
+    buf.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+static void putString(std::string& buf, const std::string& s) {
+    putRaw<uint32_t>(buf, static_cast<uint32_t>(s.size()));
+    buf.append(s);
+}
+
+template <typename T>
+static bool getRaw(const char*& p, const char* end, T& value) {
+    if (static_cast<size_t>(end - p) < sizeof(T)) return false;
+    std::memcpy(&value, p, sizeof(T));
+    p += sizeof(T);
+    return true;
+}
+
+static bool getString(const char*& p, const char* end, std::string& s) {
+    uint32_t len;
+    if (!getRaw(p, end, len) || static_cast<size_t>(end - p) < len) return false;
+    s.assign(p, len);
+    p += len;
+    return true;
+}
+
+static bool readEntry(const char*& p, const char* end, CatalogEntry& entry) {
+    TableData& meta = entry.meta;
+    uint32_t storage, column_count, index_count;
+    if (!getString(p, end, entry.name) || !getRaw(p, end, entry.file_size) || !getRaw(p, end, entry.file_mtime) ||
+        !getRaw(p, end, storage) || !getRaw(p, end, meta.row_count) || !getRaw(p, end, meta.checkpoint_lsn) ||
+        !getRaw(p, end, column_count)) {
+        return false;
+    }
+    meta.storage = storage == static_cast<uint32_t>(StorageKind::Column) ? StorageKind::Column : StorageKind::Row;
+    for (uint32_t c = 0; c < column_count; ++c) {
+        std::string column;
+        uint8_t type;
+        if (!getString(p, end, column) || !getRaw(p, end, type)) return false;
+        meta.columns.push_back(std::move(column));
+        meta.types.push_back(static_cast<ColumnType>(type));
+    }
+    if (!getRaw(p, end, index_count)) return false;
+    for (uint32_t i = 0; i < index_count; ++i) {
+        IndexDefinition def;
+        uint8_t kind;
+        if (!getString(p, end, def.name) || !getRaw(p, end, def.column) || !getRaw(p, end, kind)) return false;
+        def.kind = static_cast<IndexKind>(kind);
+        meta.indexes.push_back(std::move(def));
+    }
+    return true;
+}
+
+bool readCatalog(const std::string& filepath, std::vector<CatalogEntry>& entries) {
+    std::ifstream ifs(filepath, std::ios::binary);
+    if (!ifs) return false;
+    std::string image((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+    const char* p = image.data();
+    const char* end = p + image.size();
+    uint32_t count;
+    if (image.size() < sizeof(CATALOG_MAGIC) || std::memcmp(p, CATALOG_MAGIC, sizeof(CATALOG_MAGIC)) != 0) {
+        errorStream() << "Error: " << filepath << " is not a valid catalog; reading table headers instead.\n";
+        return false;
+    }
+    p += sizeof(CATALOG_MAGIC);
+    if (!getRaw(p, end, count)) return false;
+    entries.clear();
+    entries.resize(count);
+    for (auto& entry : entries) {
+        if (!readEntry(p, end, entry)) {
+            errorStream() << "Error: " << filepath << " is truncated; reading table headers instead.\n";
+            entries.clear();
+            return false;
+        }
+    }
+    return true;
+}
+
+bool writeCatalog(const std::string& filepath, const std::vector<CatalogEntry>& entries) {
+    std::string image(CATALOG_MAGIC, sizeof(CATALOG_MAGIC));
+    putRaw<uint32_t>(image, static_cast<uint32_t>(entries.size()));
+    for (const auto& entry : entries) {
+        const TableData& meta = entry.meta;
+        putString(image, entry.name);
+        putRaw<uint64_t>(image, entry.file_size);
+        putRaw<int64_t>(image, entry.file_mtime);
+        putRaw<uint32_t>(image, static_cast<uint32_t>(meta.storage));
+        putRaw<uint64_t>(image, meta.row_count);
+        putRaw<uint64_t>(image, meta.checkpoint_lsn);
+        putRaw<uint32_t>(image, static_cast<uint32_t>(meta.columns.size()));
+        for (size_t c = 0; c < meta.columns.size(); ++c) {
+            putString(image, meta.columns[c]);
+            putRaw<uint8_t>(image, static_cast<uint8_t>(c < meta.types.size() ? meta.types[c] : ColumnType::Text));
+        }
+        putRaw<uint32_t>(image, static_cast<uint32_t>(meta.indexes.size()));
+        for (const auto& def : meta.indexes) {
+            putString(image, def.name);
+            putRaw<uint32_t>(image, def.column);
+            putRaw<uint8_t>(image, static_cast<uint8_t>(def.kind));
+        }
+    }
+
+    // A stale or lost catalog only costs a header read at startup, so it is not synced
+    std::string tmp_path = filepath + ".tmp";
+    std::ofstream ofs(tmp_path, std::ios::binary | std::ios::trunc);
+    ofs.write(image.data(), image.size());
+    ofs.close();
+    std::error_code ec;
+    if (ofs) std::filesystem::rename(tmp_path, filepath, ec);
+    if (!ofs || ec) {
+        errorStream() << "Error: Unable to write catalog " << filepath << ".\n";
+        return false;
+    }
+    return true;
+}
+
+bool tableFileStamp(const std::string& filepath, uint64_t& size, int64_t& mtime) {
+    std::error_code ec;
+    size = std::filesystem::file_size(filepath, ec);
+    if (ec) return false;
+    auto modified = std::filesystem::last_write_time(filepath, ec);
+    if (ec) return false;
+    mtime = static_cast<int64_t>(modified.time_since_epoch().count());
+    return true;
+}
@@ -0,0 +1,32 @@
+// Catalog.hpp
+#ifndef CATALOG_HPP
+#define CATALOG_HPP
+
+#include "TableFile.hpp"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// One file describing every table, so startup reads a single small file
+// instead of opening each table
+inline const std::string CATALOG_FILE = "minidb.catalog";
+
+// What startup needs to know about a table without opening its file: the
+// header fields as of the last checkpoint (schema, layout, index definitions,
+// row count, checkpoint LSN), and the size and modification time the table
+// file had then, which tell whether the entry still describes it
+struct CatalogEntry {
+    std::string name;
+    TableData meta; // records and mapping stay empty
+    uint64_t file_size = 0;
+    int64_t file_mtime = 0;
+};
+
+// Read the catalog; false if it is missing or unreadable (startup then reads table headers)
+bool readCatalog(const std::string& filepath, std::vector<CatalogEntry>& entries);
+// Replace the catalog; written to a sibling file and renamed
+bool writeCatalog(const std::string& filepath, const std::vector<CatalogEntry>& entries);
+// Size and modification time of a table file; false if it does not exist
+bool tableFileStamp(const std::string& filepath, uint64_t& size, int64_t& mtime);
+
+#endif // CATALOG_HPP
@@ -0,0 +1,278 @@
+// ColumnStore.cpp
+#include "ColumnStore.hpp"
+#include <algorithm>
+#include <cstring>
+
+ColumnStore::ColumnStore(const std::vector<uint32_t>& widths) : columns(widths.size()) {
+    for (size_t c = 0; c < widths.size(); ++c) {
+        columns[c].width = widths[c];
+    }
+}
+
+ColumnStore::ColumnStore(const std::vector<ColumnType>& types) : columns(types.size()) {
+    for (size_t c = 0; c < types.size(); ++c) {
+        columns[c].width = fixedWidth(types[c]);
+        if (types[c] == ColumnType::Text) {
+            columns[c].encoded = true;
+            columns[c].width = sizeof(uint32_t);
+        }
+    }
+}
+
+// Make room for n elements, at least doubling the capacity when it grows, so
+// reserving a little more on every append still costs amortized O(1) per element
+template <typename Buffer>
+static void reserveAtLeast(Buffer& buffer, size_t n) {
+    if (buffer.capacity() < n) buffer.reserve(std::max(n, buffer.capacity() * 2));
+}
+
+void ColumnStore::reserve(size_t row_count) {
+    for (auto& column : columns) {
+        if (column.width != 0) {
+            reserveAtLeast(column.bytes, row_count * column.width);
+            continue;
+        }
+        reserveAtLeast(column.starts, row_count);
+        reserveAtLeast(column.lengths, row_count);
+    }
+}
+
+bool ColumnStore::encode(Column& column, std::string_view value, uint32_t& code) {
+    if (column.dictionary.find(value, code)) return true;
+    if (column.dictionary.size() >= DICTIONARY_LIMIT) {
+        decodeColumn(column);
+        return false;
+    }
+    code = column.dictionary.add(value);
+    return true;
+}
+
+void ColumnStore::decodeColumn(Column& column) {
+    std::string codes;
+    codes.swap(column.bytes);
+    size_t count = codes.size() / sizeof(uint32_t);
+    column.starts.reserve(count);
+    column.lengths.reserve(count);
+    for (size_t r = 0; r < count; ++r) {
+        uint32_t code;
+        std::memcpy(&code, codes.data() + r * sizeof(code), sizeof(code));
+        const std::string& value = column.dictionary.values[code];
+        column.starts.push_back(column.bytes.size());
+        column.lengths.push_back(static_cast<uint32_t>(value.size()));
+        column.bytes.append(value);
+    }
+    column.encoded = false;
+    column.width = 0;
+    column.garbage = 0;
+    column.dictionary.clear();
+}
+
+void ColumnStore::appendValue(Column& column, std::string_view value) {
+    uint32_t code;
+    if (column.encoded && encode(column, value, code)) {
+        column.bytes.append(reinterpret_cast<const char*>(&code), sizeof(code));
+        return;
+    }
+    if (column.width != 0) {
+        // Callers store values of the declared width; anything else is cut or padded to keep the stride
+        column.bytes.append(value.data(), std::min<size_t>(value.size(), column.width));
+        column.bytes.resize((rows + 1) * column.width, '\0');
+        return;
+    }
+    column.starts.push_back(column.bytes.size());
+    column.lengths.push_back(static_cast<uint32_t>(value.size()));
+    column.bytes.append(value.data(), value.size());
+}
+
+void ColumnStore::append(const std::vector<std::string>& fields) {
+    for (size_t c = 0; c < columns.size(); ++c) {
+        appendValue(columns[c], fields[c]);
+    }
+    rows++;
+}
+
+void ColumnStore::append(const Record& record) {
+    for (size_t c = 0; c < columns.size(); ++c) {
+        appendValue(columns[c], record.field(c));
+    }
+    rows++;
+}
+
+void ColumnStore::append(const ColumnStore& other) {
+    for (size_t c = 0; c < columns.size(); ++c) {
+        Column& column = columns[c];
+        const Column& from = other.columns[c];
+        if (column.encoded && from.encoded) {
+            // Codes are renumbered into this dictionary, looking up each distinct value once
+            std::vector<uint32_t> remap(from.dictionary.size());
+            bool fits = true;
+            for (size_t code = 0; code < remap.size() && fits; ++code) {
+                fits = encode(column, from.dictionary.values[code], remap[code]);
+            }
+            if (fits) {
+                reserveAtLeast(column.bytes, column.bytes.size() + other.rows * sizeof(uint32_t));
+                for (size_t r = 0; r < other.rows; ++r) {
+                    uint32_t code = remap[from.code(r)];
+                    column.bytes.append(reinterpret_cast<const char*>(&code), sizeof(code));
+                }
+                continue;
+            }
+        }
+        if (column.encoded || from.encoded) {
+            for (size_t r = 0; r < other.rows; ++r) appendValue(column, from.value(r));
+            continue;
+        }
+        if (column.width != 0) {
+            column.bytes.append(from.bytes, 0, other.rows * column.width);
+            continue;
+        }
+        if (from.garbage != 0) {
+            for (size_t r = 0; r < other.rows; ++r) appendValue(column, from.value(r));
+            continue;
+        }
+        // Packed values copy over in one piece; only their offsets move
+        uint64_t base = column.bytes.size();
+        column.bytes.append(from.bytes);
+        for (uint64_t start : from.starts) column.starts.push_back(base + start);
+        column.lengths.insert(column.lengths.end(), from.lengths.begin(), from.lengths.end());
+    }
+    rows += other.rows;
+}
+
+void ColumnStore::set(size_t row, size_t col, const std::string& value) {
+    Column& column = columns[col];
+    uint32_t code;
+    if (column.encoded && encode(column, value, code)) {
+        std::memcpy(&column.bytes[row * sizeof(code)], &code, sizeof(code));
+        return;
+    }
+    if (column.width != 0) {
+        column.bytes.replace(row * column.width, column.width, value, 0, column.width);
+        return;
+    }
+    if (value.size() <= column.lengths[row]) {
+        // Fits in place; any tail left over becomes garbage
+        column.bytes.replace(column.starts[row], value.size(), value);
+        column.garbage += column.lengths[row] - value.size();
+    } else {
+        column.garbage += column.lengths[row];
+        column.starts[row] = column.bytes.size();
+        column.bytes.append(value);
+    }
+    column.lengths[row] = static_cast<uint32_t>(value.size());
+    if (column.garbage > column.bytes.size() / 2) {
+        compactColumn(column);
+    }
+}
+
+void ColumnStore::intern(size_t col, const std::string& value) {
+    Column& column = columns[col];
+    uint32_t code;
+    if (column.encoded) encode(column, value, code);
+}
+
+void ColumnStore::compactColumn(Column& column) {
+    std::string packed;
+    packed.reserve(column.bytes.size() - column.garbage);
+    for (size_t r = 0; r < column.starts.size(); ++r) {
+        uint64_t start = packed.size();
+        packed.append(column.bytes, column.starts[r], column.lengths[r]);
+        column.starts[r] = start;
+    }
+    column.bytes.swap(packed);
+    column.garbage = 0;
+}
+
+void ColumnStore::truncate(size_t row_count) {
+    if (row_count >= rows) return;
+    for (auto& column : columns) {
+        if (column.width != 0) {
+            column.bytes.resize(row_count * column.width);
+            continue;
+        }
+        for (size_t r = row_count; r < rows; ++r) column.garbage += column.lengths[r];
+        column.starts.resize(row_count);
+        column.lengths.resize(row_count);
+        if (column.garbage > column.bytes.size() / 2) {
+            compactColumn(column);
+        }
+    }
+    rows = row_count;
+}
+
+void ColumnStore::erase(const std::vector<bool>& remove) {
+    size_t kept = 0;
+    for (size_t r = 0; r < rows; ++r) {
+        if (remove[r]) continue;
+        for (auto& column : columns) {
+            if (column.width != 0) {
+                if (kept != r) std::memcpy(&column.bytes[kept * column.width], &column.bytes[r * column.width], column.width);
+                continue;
+            }
+            column.starts[kept] = column.starts[r];
+            column.lengths[kept] = column.lengths[r];
+        }
+        kept++;
+    }
+    // Deleted values may sit anywhere in the buffer, so recount what is live
+    for (auto& column : columns) {
+        if (column.width != 0) {
+            column.bytes.resize(kept * column.width);
+            continue;
+        }
+        column.starts.resize(kept);
+        column.lengths.resize(kept);
+        uint64_t live = 0;
+        for (uint32_t len : column.lengths) live += len;
+        column.garbage = column.bytes.size() - live;
+        if (column.garbage > column.bytes.size() / 2) {
+            compactColumn(column);
+        }
+    }
+    rows = kept;
+}
+
+Record ColumnStore::row(size_t row) const {
+    std::vector<std::string> fields;
+    fields.reserve(columns.size());
+    for (const auto& column : columns) {
+        fields.emplace_back(column.value(row));
+    }
+    return Record(std::move(fields));
+}
+
+std::string_view ColumnStore::stored(size_t row, size_t col) const {
+    const Column& column = columns[col];
+    if (column.encoded) return std::string_view(column.bytes.data() + row * sizeof(uint32_t), sizeof(uint32_t));
+    return column.value(row);
+}
+
+bool ColumnStore::load(const std::vector<Record>& records, const std::vector<std::vector<std::string>>& dictionaries) {
+    std::vector<bool> coded(columns.size(), false);
+    for (size_t c = 0; c < columns.size() && c < dictionaries.size(); ++c) {
+        if (dictionaries[c].empty()) continue;
+        Column& column = columns[c];
+        coded[c] = true;
+        column.encoded = true;
+        column.width = sizeof(uint32_t);
+        column.dictionary.clear();
+        for (const auto& value : dictionaries[c]) column.dictionary.add(value);
+    }
+    reserve(records.size());
+    for (const auto& record : records) {
+        for (size_t c = 0; c < columns.size(); ++c) {
+            std::string_view field = record.field(c);
+            if (!coded[c]) {
+                appendValue(columns[c], field);
+                continue;
+            }
+            uint32_t code;
+            if (field.size() != sizeof(code)) return false;
+            std::memcpy(&code, field.data(), sizeof(code));
+            if (code >= columns[c].dictionary.size()) return false;
+            columns[c].bytes.append(field.data(), field.size());
+        }
+        rows++;
+    }
+    return true;
+}
@@ -0,0 +1,136 @@
+// ColumnStore.hpp
+#ifndef COLUMN_STORE_HPP
+#define COLUMN_STORE_HPP
+
+#include "Record.hpp"
+#include "Value.hpp"
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Distinct values a dictionary column holds before it goes back to storing
+// its values in full: past this the codes stop paying for the dictionary
+const size_t DICTIONARY_LIMIT = 4096;
+
+// Column-major table storage. Each column keeps all of its values in one
+// contiguous buffer with per-row offsets, so a scan over one column never
+// touches the others. Fixed-width columns need no offsets: value r sits at
+// r * width, so the buffer is a plain array of native values.
+// TEXT columns start out dictionary-encoded: each distinct value is kept once
+// and the buffer is an array of u32 codes, so a filter or GROUP BY on the
+// column compares codes, not strings.
+class ColumnStore {
+public:
+    // Distinct values of an encoded column, numbered in order of first
+    // appearance; values are never dropped, so a code stays valid
+    struct Dictionary {
+        std::deque<std::string> values; // by code; a deque so views into it survive growth
+        std::unordered_map<std::string_view, uint32_t> codes; // keys view values
+
+        Dictionary() = default;
+        Dictionary(const Dictionary& other) { *this = other; }
+        Dictionary(Dictionary&&) = default; // a moved deque keeps its elements where they are
+        Dictionary& operator=(const Dictionary& other) {
+            if (this == &other) return *this;
+            clear();
+            for (const auto& value : other.values) add(value);
+            return *this;
+        }
+        Dictionary& operator=(Dictionary&&) = default;
+
+        size_t size() const { return values.size(); }
+        void clear() {
+            codes.clear();
+            values.clear();
+        }
+        // Code of value, or false if the dictionary does not hold it
+        bool find(std::string_view value, uint32_t& code) const {
+            auto it = codes.find(value);
+            if (it == codes.end()) return false;
+            code = it->second;
+            return true;
+        }
+        uint32_t add(std::string_view value) {
+            uint32_t code;
+            if (find(value, code)) return code;
+            code = static_cast<uint32_t>(values.size());
+            values.emplace_back(value);
+            codes.emplace(values.back(), code);
+            return code;
+        }
+    };
+
+    struct Column {
+        uint32_t width = 0;             // bytes per value, 0 for variable-length values
+        std::string bytes;              // values (or codes) back to back
+        std::vector<uint64_t> starts;   // offset of each row's value in bytes (variable width only)
+        std::vector<uint32_t> lengths;
+        uint64_t garbage = 0;           // bytes orphaned by updates, reclaimed by compaction
+        bool encoded = false;           // bytes holds codes into dictionary (width 4)
+        Dictionary dictionary;
+
+        uint32_t code(size_t row) const {
+            uint32_t code;
+            std::memcpy(&code, bytes.data() + row * sizeof(code), sizeof(code));
+            return code;
+        }
+        std::string_view value(size_t row) const {
+            if (encoded) return dictionary.values[code(row)];
+            if (width != 0) return std::string_view(bytes.data() + row * width, width);
+            return std::string_view(bytes.data() + starts[row], lengths[row]);
+        }
+    };
+
+private:
+    std::vector<Column> columns;
+    size_t rows = 0;
+
+    void compactColumn(Column& column);
+    void appendValue(Column& column, std::string_view value);
+    // Code of value in an encoded column, added if new; false once the
+    // dictionary is full, after which the column stores plain values
+    bool encode(Column& column, std::string_view value, uint32_t& code);
+    // Replace the codes of an encoded column with the values they stand for
+    void decodeColumn(Column& column);
+
+public:
+    explicit ColumnStore(size_t column_count = 0) : columns(column_count) {}
+    // One column per entry, with that fixed width (0 = variable)
+    explicit ColumnStore(const std::vector<uint32_t>& widths);
+    // Columns laid out for values of these types: numbers at their fixed
+    // width, TEXT dictionary-encoded
+    explicit ColumnStore(const std::vector<ColumnType>& types);
+
+    size_t size() const { return rows; }
+    size_t columnCount() const { return columns.size(); }
+    const Column& column(size_t col) const { return columns[col]; }
+    std::string_view field(size_t row, size_t col) const { return columns[col].value(row); }
+
+    void reserve(size_t row_count);
+    void append(const std::vector<std::string>& fields);
+    void append(const Record& record);
+    // Append every row of other, which has the same column layout
+    void append(const ColumnStore& other);
+    void set(size_t row, size_t col, const std::string& value);
+    // Make sure an encoded column holds value, so that set() with it changes
+    // nothing shared by other rows (and may run on many rows at once)
+    void intern(size_t col, const std::string& value);
+    // Drop the rows from row_count on
+    void truncate(size_t row_count);
+    // Drop every row whose flag in remove is set, keeping the rest in order
+    void erase(const std::vector<bool>& remove);
+    Record row(size_t row) const;
+
+    // Table files store encoded columns as their codes, with the dictionary in
+    // the header. stored() is a field as written there; load() fills an empty
+    // store with rows read back, where the columns given a non-empty dictionary
+    // hold codes into it. False (and the store unusable) on a code it lacks.
+    std::string_view stored(size_t row, size_t col) const;
+    bool load(const std::vector<Record>& records, const std::vector<std::vector<std::string>>& dictionaries);
+};
+
+#endif // COLUMN_STORE_HPP
@@ -0,0 +1,83 @@
+// Condition.hpp
+#ifndef CONDITION_HPP
+#define CONDITION_HPP
+
+#include "Value.hpp"
+#include <string>
+#include <string_view>
+#include <vector>
+
+enum class CompareOp {
+    Eq,
+    Lt,
+    Le,
+    Gt,
+    Ge,
+    Ne,
+    Between // value <= x <= value2
+};
+
+// A single-column WHERE predicate: column op value. As parsed the values are
+// literals; a table binds them to the column's type and stored form.
+struct Condition {
+    std::string column; // empty when the statement has no WHERE clause
+    CompareOp op = CompareOp::Eq;
+    std::string value;
+    std::string value2;
+    ColumnType type = ColumnType::Text;
+
+    bool empty() const { return column.empty(); }
+
+    bool matches(std::string_view field) const {
+        switch (op) {
+            case CompareOp::Eq: return compareValues(type, field, value) == 0;
+            case CompareOp::Lt: return compareValues(type, field, value) < 0;
+            case CompareOp::Le: return compareValues(type, field, value) <= 0;
+            case CompareOp::Gt: return compareValues(type, field, value) > 0;
+            case CompareOp::Ge: return compareValues(type, field, value) >= 0;
+            case CompareOp::Ne: return compareValues(type, field, value) != 0;
+            case CompareOp::Between:
+                return compareValues(type, field, value) >= 0 && compareValues(type, field, value2) <= 0;
+        }
+        return false;
+    }
+};
+
+// Maps "=", "!=", "<>", "<", "<=", ">", ">=" to an operator; returns false for anything else
+inline bool parseCompareOp(const std::string& token, CompareOp& op) {
+    if (token == "=") op = CompareOp::Eq;
+    else if (token == "<") op = CompareOp::Lt;
+    else if (token == "<=") op = CompareOp::Le;
+    else if (token == ">") op = CompareOp::Gt;
+    else if (token == ">=") op = CompareOp::Ge;
+    else if (token == "!=" || token == "<>") op = CompareOp::Ne;
+    else return false;
+    return true;
+}
+
+inline const char* compareOpName(CompareOp op) {
+    switch (op) {
+        case CompareOp::Eq: return "=";
+        case CompareOp::Lt: return "<";
+        case CompareOp::Le: return "<=";
+        case CompareOp::Gt: return ">";
+        case CompareOp::Ge: return ">=";
+        case CompareOp::Ne: return "!=";
+        case CompareOp::Between: return "BETWEEN";
+    }
+    return "=";
+}
+
+// Decode the four-argument log form (column, operator, value, second value)
+// that single-comparison WHERE clauses were logged in, starting at args[first]
+inline bool conditionFromArgs(const std::vector<std::string>& args, size_t first, Condition& cond) {
+    if (args.size() < first + 4) return false;
+    cond.column = args[first];
+    if (args[first + 1] == "BETWEEN") cond.op = CompareOp::Between;
+    else if (!parseCompareOp(args[first + 1], cond.op)) return false;
+    cond.value = args[first + 2];
+    cond.value2 = args[first + 3];
+    return true;
+}
+
+#endif // CONDITION_HPP
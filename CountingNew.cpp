@@ -0,0 +1,22 @@
+// CountingNew.cpp
+// Replacements of the global operator new and delete that count allocations
+// for MemoryStats. Linked into the programs that report allocations rather
+// than into libminidb.a, so embedding the library leaves a program's
+// allocator alone. The array and nothrow forms of new call these.
+#include "MemoryStats.hpp"
+#include <cstdlib>
+#include <new>
+
+void* operator new(std::size_t size) {
+    countAllocation(size);
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+    std::free(p);
+}
@@ -0,0 +1,185 @@
+// Cursor.cpp
+#include "Cursor.hpp"
+#include "Table.hpp"
+#include <cstdlib>
+
+Cursor::Cursor(Table& table, const SelectQuery& query, const Snapshot& snapshot)
+    : table(table), query(std::make_unique<SelectQuery>(query)), snapshot(snapshot) {}
+
+Cursor::~Cursor() {
+    close();
+}
+
+void Cursor::fetch() {
+    const std::vector<int>& agg_columns = query->agg_columns;
+    slots.assign(table.columns.size(), -1);
+    auto want = [&](int col) {
+        if (col < 0 || slots[col] >= 0) return;
+        slots[col] = static_cast<int>(fetched.size());
+        fetched.push_back(col);
+    };
+    for (int col : table_columns) want(col);
+    // Without GROUP BY each row shows the aggregate of itself alone
+    if (!flow.grouped) {
+        for (int col : agg_columns) want(col);
+    }
+
+    std::vector<std::string_view> fields(fetched.size());
+    auto copy = [&](size_t row) {
+        for (size_t i = 0; i < fetched.size(); ++i) fields[i] = table.fieldAt(row, fetched[i]);
+        rows.push_back(values.append(fields));
+    };
+    if (flow.grouped) {
+        // A group shows the values of its first row
+        rows.reserve(flow.group_order.size());
+        for (size_t group : flow.group_order) copy(flow.groups.rows[group]);
+    } else if (!flow.all) {
+        rows.reserve(flow.rows.size());
+        for (size_t row : flow.rows) copy(row);
+    } else {
+        // Walk the scan, stepping over the hidden rows
+        rows.reserve(flow.size());
+        const std::vector<size_t>& hidden = flow.hidden;
+        size_t next_hidden = 0;
+        for (size_t row = 0; row < flow.row_count; ++row) {
+            if (next_hidden < hidden.size() && hidden[next_hidden] == row) {
+                ++next_hidden;
+                continue;
+            }
+            copy(row);
+        }
+    }
+}
+
+bool Cursor::next() {
+    if (!open) return false;
+    if (position == rows.size()) {
+        close();
+        return false;
+    }
+    ++position;
+    const std::vector<Aggregate>& aggregates = query->aggregates;
+    const std::vector<int>& agg_columns = query->agg_columns;
+    auto aggregateType = [&](size_t i) {
+        return agg_columns[i] < 0 ? ColumnType::Text : table.types[agg_columns[i]];
+    };
+    aggregate_values.resize(aggregates.size());
+    aggregate_nulls.resize(aggregates.size());
+
+    if (flow.grouped) {
+        group = flow.group_order[position - 1];
+        const Accumulator* acc = &flow.groups.accumulators[group * aggregates.size()];
+        for (size_t i = 0; i < aggregates.size(); ++i) {
+            aggregate_values[i] = acc[i].result(aggregates[i], aggregateType(i));
+            aggregate_nulls[i] = acc[i].isNull(aggregates[i]);
+        }
+        return true;
+    }
+
+    // Without GROUP BY each row shows the aggregate of itself alone
+    const Record& row = rows[position - 1];
+    for (size_t i = 0; i < aggregates.size(); ++i) {
+        int idx = agg_columns[i];
+        Accumulator single;
+        single.add(aggregates[i], aggregateType(i), idx < 0 ? std::string_view() : row.field(slots[idx]));
+        aggregate_values[i] = single.result(aggregates[i], aggregateType(i));
+        aggregate_nulls[i] = single.isNull(aggregates[i]);
+    }
+    return true;
+}
+
+bool Cursor::isNull(size_t col) const {
+    return table_columns[col] < 0 && aggregate_nulls[col - first_aggregate];
+}
+
+int64_t Cursor::getInt(size_t col) const {
+    if (table_columns[col] < 0) return std::strtoll(aggregateValue(col).c_str(), nullptr, 10);
+    std::string_view value = stored(col);
+    ColumnType type = column_types[col];
+    if (value.size() == fixedWidth(type)) {
+        switch (type) {
+            case ColumnType::Int: return loadValue<int32_t>(value);
+            case ColumnType::BigInt: return loadValue<int64_t>(value);
+            case ColumnType::Double: return static_cast<int64_t>(loadValue<double>(value));
+            case ColumnType::Bool: return value[0] ? 1 : 0;
+            case ColumnType::Text: break;
+        }
+    }
+    return std::strtoll(std::string(value).c_str(), nullptr, 10);
+}
+
+double Cursor::getDouble(size_t col) const {
+    if (table_columns[col] < 0) return std::strtod(aggregateValue(col).c_str(), nullptr);
+    std::string_view value = stored(col);
+    ColumnType type = column_types[col];
+    if (type == ColumnType::Double && value.size() == sizeof(double)) return loadValue<double>(value);
+    if (type != ColumnType::Text) return static_cast<double>(getInt(col));
+    return std::strtod(std::string(value).c_str(), nullptr);
+}
+
+bool Cursor::getBool(size_t col) const {
+    if (column_types[col] == ColumnType::Text) {
+        std::string text = getText(col);
+        return text == "true" || text == "TRUE" || getInt(col) != 0;
+    }
+    return getInt(col) != 0;
+}
+
+std::string Cursor::getText(size_t col) const {
+    if (table_columns[col] < 0) return aggregateValue(col);
+    return formatValue(column_types[col], stored(col));
+}
+
+void Cursor::close() {
+    if (!open) return;
+    open = false;
+    if (close_callback) close_callback();
+}
+
+// Same text as std::left << std::setw(15) << value
+static void appendCell(std::string& out, std::string_view value) {
+    out.append(value);
+    if (value.size() < 15) out.append(15 - value.size(), ' ');
+}
+
+bool printCursor(Cursor& cursor, std::ostream& out, size_t max_bytes) {
+    size_t columns = cursor.columnCount();
+    std::string text;
+    for (size_t i = 0; i < columns; ++i) {
+        appendCell(text, cursor.columnName(i));
+        if (i != columns - 1) text += " | ";
+    }
+    text += "\n";
+    for (size_t i = 0; i < columns; ++i) {
+        text += "---------------";
+        if (i != columns - 1) text += "+";
+    }
+    text += "\n";
+    // Rows are written out in batches rather than one at a time
+    size_t batched = 0;
+    size_t written = 0;
+    while (cursor.next()) {
+        for (size_t i = 0; i < columns; ++i) {
+            appendCell(text, cursor.getText(i));
+            if (i != columns - 1) text += " | ";
+        }
+        text += "\n";
+        if (written + text.size() > max_bytes) {
+            cursor.close();
+            return false;
+        }
+        if (++batched == 1024) {
+            out << text;
+            written += text.size();
+            text.clear();
+            batched = 0;
+        }
+    }
+    if (!cursor.totals().empty()) {
+        text += "\n";
+        for (const auto& total : cursor.totals()) text += total.first + " = " + total.second + "\n";
+    }
+    if (written + text.size() > max_bytes) return false;
+    out << text;
+    return true;
+}
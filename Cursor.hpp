@@ -0,0 +1,109 @@
+// Cursor.hpp
+#ifndef CURSOR_HPP
+#define CURSOR_HPP
+
+#include "Operator.hpp"
+#include "RowArena.hpp"
+#include "Snapshot.hpp"
+#include "Value.hpp"
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+class Table;
+struct SelectQuery;
+
+// The rows of a SELECT, read one at a time. When a cursor is returned the
+// operators have run and the stored values of the rows in the LIMIT window
+// have been copied out of the table, so the cursor no longer needs the table's
+// latch and writers need not wait for the client; values are formatted only
+// as a getter asks for them. The statement's snapshot stays open until the
+// cursor is closed or destroyed.
+// The copy is the whole window, not a batch at a time: without the latch a
+// row id may come to hold another version (an update copies the old one to
+// the end) or another row (a delete compacts the table), so ids cannot be
+// read later. A SELECT without LIMIT therefore holds its shown columns of
+// every matching row until the cursor is closed.
+class Cursor {
+public:
+    ~Cursor();
+    Cursor(const Cursor&) = delete;
+    Cursor& operator=(const Cursor&) = delete;
+
+    size_t columnCount() const { return names.size(); }
+    const std::string& columnName(size_t col) const { return names[col]; }
+    // Type of a column's values; aggregates: BIGINT for COUNT and integral SUM,
+    // DOUBLE for AVG and other SUMs, the column's type for MIN and MAX. An
+    // integral SUM past BIGINT's range is shown in full; getInt() saturates it.
+    ColumnType columnType(size_t col) const { return column_types[col]; }
+
+    // Move to the next row; false (and closed) after the last one
+    bool next();
+    // Values of the current row. Only an aggregate over no values is NULL;
+    // numeric getters convert TEXT as std::strtoll/strtod would.
+    bool isNull(size_t col) const;
+    int64_t getInt(size_t col) const;
+    double getDouble(size_t col) const;
+    bool getBool(size_t col) const;
+    // Display form, as the REPL prints it
+    std::string getText(size_t col) const;
+
+    // Aggregates without GROUP BY: the label and value of each over every
+    // matching row (not only those in the LIMIT window)
+    const std::vector<std::pair<std::string, std::string>>& totals() const { return total_values; }
+
+    // Stop reading and end the statement; the destructor does this too
+    void close();
+    bool isOpen() const { return open; }
+    // Called once by close(), e.g. to end the statement's snapshot
+    void onClose(std::function<void()> callback) { close_callback = std::move(callback); }
+
+private:
+    friend class Table;
+    friend class ProjectOp;
+
+    Cursor(Table& table, const SelectQuery& query, const Snapshot& snapshot);
+
+    Table& table;
+    std::unique_ptr<SelectQuery> query; // the cursor's own copy: operators refer to it
+    Snapshot snapshot;
+    std::vector<std::unique_ptr<Operator>> operators;
+    RowFlow flow; // after the operators: the rows (or groups) in the LIMIT window
+    RowArena values;                 // copied by fetch(): per result row the fields listed in fetched
+    std::vector<Record> rows;
+    std::vector<int> fetched;        // table columns copied
+    std::vector<int> slots;          // per table column: its field in a row of rows, -1 if not copied
+
+    std::vector<std::string> names;
+    std::vector<ColumnType> column_types;
+    std::vector<int> table_columns; // per result column: its table column, -1 for an aggregate
+    size_t first_aggregate = 0;     // result column of the first aggregate
+    size_t position = 0;            // of the next row in rows
+    size_t group = SIZE_MAX;        // current group when grouped
+    std::vector<std::string> aggregate_values; // current row's aggregates as text
+    std::vector<bool> aggregate_nulls;
+    std::vector<std::pair<std::string, std::string>> total_values;
+    bool open = true;
+    std::function<void()> close_callback;
+
+    // Copy the values the result shows out of the table; run under its latch
+    // once the operators are done
+    void fetch();
+    // Stored value of a result column of the current row
+    std::string_view stored(size_t col) const { return rows[position - 1].field(slots[table_columns[col]]); }
+    // Text of an aggregate column of the current row
+    const std::string& aggregateValue(size_t col) const { return aggregate_values[col - first_aggregate]; }
+};
+
+// Write a cursor's rows as the REPL shows them: a header, a separator, one
+// line per row with 15-character columns, then any totals. Stops, closing the
+// cursor, and returns false once the text would pass max_bytes; part of it
+// may have been written by then.
+bool printCursor(Cursor& cursor, std::ostream& out, size_t max_bytes = SIZE_MAX);
+
+#endif // CURSOR_HPP
@@ -1,476 +1,943 @@
 // Database.cpp
 #include "Database.hpp"
-#include <sstream>
+#include "BulkLoad.hpp"
+#include "Diagnostics.hpp"
+#include "MemoryStats.hpp"
+#include "ThreadPool.hpp"
 #include <algorithm>
+#include <chrono>
+#include <cstdlib>
 #include <filesystem>
+#include <iomanip>
 #include <iostream>
 
 namespace fs = std::filesystem;
 
-void Database::createTable(const std::string& name, const std::vector<std::string>& columns) {
-    if (tables.find(name) != tables.end()) {
-        std::cerr << "Error: Table " << name << " already exists.\n";
-        return;
+// dir as a prefix of file names, created if it is missing
+static std::string prepareDataDir(std::string dir) {
+    if (dir.empty()) dir = ".";
+    if (dir.back() != '/') dir += '/';
+    std::error_code ec;
+    fs::create_directories(dir, ec);
+    return dir;
+}
+
+// Session of the statements a thread is executing, and the database it belongs to
+struct ActiveSession {
+    const Database* db = nullptr;
+    Session* session = nullptr;
+};
+static thread_local ActiveSession active_session;
+
+// Make client the session of this thread's statements on db until the scope ends
+class SessionScope {
+public:
+    SessionScope(const Database* db, Session* client) : saved(active_session) { active_session = {db, client}; }
+    ~SessionScope() { active_session = saved; }
+
+private:
+    ActiveSession saved;
+};
+
+// Plan statement while no one adds an index to the table
+static bool planLatched(Statement& statement, Table& table, Plan& plan) {
+    std::shared_lock<Latch> latch(table.latch());
+    return planStatement(statement, table, plan);
+}
+
+Database::Database(const std::string& dir) : data_dir(prepareDataDir(dir)), wal(data_dir + WAL_FILE) {}
+
+Session* Database::session() {
+    return active_session.db == this ? active_session.session : &local_session;
+}
+
+bool Database::addTableSlot(const std::string& name, std::unique_ptr<Table> table) {
+    auto map = std::make_shared<TableMap>(*tableMap());
+    auto slot = std::make_shared<TableSlot>();
+    slot->loaded = table.get();
+    slot->table = std::move(table);
+    if (!map->emplace(name, std::move(slot)).second) return false;
+    std::atomic_store(&table_map, std::shared_ptr<const TableMap>(std::move(map)));
+    return true;
+}
+
+void Database::createTable(const std::string& name, const std::vector<std::string>& columns,
+                           const std::vector<ColumnType>& types, StorageKind storage) {
+    {
+        std::lock_guard<std::mutex> lock(table_map_mutex);
+        if (tableMap()->count(name)) {
+            errorStream() << "Error: Table " << name << " already exists.\n";
+            return;
+        }
+        auto table = std::make_unique<Table>(name, columns, types, storage, data_dir);
+        // Frames logged before the table existed never apply to it
+        table->setCheckpointLsn(wal.nextLsn() - 1);
+        if (!session()->transaction_active) {
+            table->save();
+        }
+        addTableSlot(name, std::move(table));
     }
-    tables[name] = std::make_unique<Table>(name, columns);
-    if (!transaction_active) {
-        tables[name]->save();
+    if (!session()->transaction_active) {
+        saveCatalog();
     }
-    std::cout << "Table " << name << " created successfully.\n";
+    messageStream() << "Table " << name << " created successfully.\n";
 }
 
-void Database::loadTable(const std::string& name) {
-    if (tables.find(name) != tables.end()) {
-        std::cerr << "Error: Table " << name << " is already loaded.\n";
+void Database::createIndex(const std::string& index_name, const std::string& table_name, const std::string& column,
+                           IndexKind kind) {
+    if (session()->transaction_active) {
+        errorStream() << "Error: CREATE INDEX is not allowed inside a transaction.\n";
         return;
     }
-    // Check if file exists
-    std::string filepath = "data/" + name + ".tbl";
-    if (!fs::exists(filepath)) {
-        std::cerr << "Error: Table " << name << " does not exist.\n";
-        return;
+    Table* table = getTableForWrite(table_name);
+    if (!table) return;
+    {
+        std::shared_lock<Latch> gate;
+        std::unique_lock<Latch> latch;
+        if (!lockForWrite(*table, gate, latch) || !table->createIndex(index_name, column, kind)) {
+            return;
+        }
+        // The definition lives in the table header; the file then reflects every logged frame
+        table->setCheckpointLsn(wal.nextLsn() - 1);
+        table->save();
+    }
+    saveCatalog();
+    messageStream() << "Index " << index_name << " created on " << table_name << "(" << column << ").\n";
+}
+
+void Database::loadTable(const std::string& name) {
+    {
+        std::lock_guard<std::mutex> lock(table_map_mutex);
+        if (tableMap()->count(name)) {
+            errorStream() << "Error: Table " << name << " is already loaded.\n";
+            return;
+        }
+        // Check if file exists
+        std::string filepath = data_dir + name + ".tbl";
+        if (!fs::exists(filepath)) {
+            errorStream() << "Error: Table " << name << " does not exist.\n";
+            return;
+        }
+        addTableSlot(name, std::make_unique<Table>(name, data_dir));
     }
-    tables[name] = std::make_unique<Table>(name);
-    std::cout << "Table " << name << " loaded successfully.\n";
+    saveCatalog();
+    messageStream() << "Table " << name << " loaded successfully.\n";
 }
 
 void Database::autoLoadTables() {
-    std::string data_dir = "data";
-    if (fs::exists(data_dir) && fs::is_directory(data_dir)) {
+    // Only the catalog is read here. A table file without an entry, or changed
+    // since its entry was written, has just its header decoded instead.
+    std::vector<CatalogEntry> entries;
+    readCatalog(data_dir + CATALOG_FILE, entries);
+    std::unordered_map<std::string, CatalogEntry> known;
+    for (auto& entry : entries) {
+        std::string table_name = entry.name;
+        known.emplace(table_name, std::move(entry));
+    }
+    bool rebuilt = false;
+    auto map = std::make_shared<TableMap>(*tableMap());
+    std::unique_lock<std::mutex> catalog_lock(catalog_mutex);
+    if (fs::is_directory(data_dir)) {
         for (const auto& entry : fs::directory_iterator(data_dir)) {
             if (entry.is_regular_file() && entry.path().extension() == ".tbl") {
                 std::string filename = entry.path().stem().string();
-                if (tables.find(filename) == tables.end()) {
-                    tables[filename] = std::make_unique<Table>(filename);
-                    std::cout << "Loaded table: " << filename << "\n";
+                if (map->count(filename)) continue;
+                std::string filepath = entry.path().string();
+                CatalogEntry current;
+                current.name = filename;
+                tableFileStamp(filepath, current.file_size, current.file_mtime);
+                auto found = known.find(filename);
+                if (found != known.end() && found->second.file_size == current.file_size &&
+                    found->second.file_mtime == current.file_mtime) {
+                    current.meta = std::move(found->second.meta);
+                } else {
+                    // Legacy CSV tables have no header; they are described once loaded
+                    TableData header;
+                    if (isBinaryTableFile(filepath) && openTableFile(filepath, header)) {
+                        header.mapping.reset();
+                        header.dictionaries.clear(); // the catalog keeps the schema, not the data
+                        current.meta = std::move(header);
+                    }
+                    rebuilt = true;
                 }
+                catalog[filename] = std::move(current);
+                (*map)[filename] = std::make_shared<TableSlot>();
+                load_queue.push_back(filename);
+                messageStream() << "Loaded table: " << filename << "\n";
             }
         }
     }
+    bool stale = rebuilt || known.size() != catalog.size();
+    catalog_lock.unlock();
+    {
+        std::lock_guard<std::mutex> lock(table_map_mutex);
+        std::atomic_store(&table_map, std::shared_ptr<const TableMap>(std::move(map)));
+    }
+    if (stale) {
+        saveCatalog();
+    }
+
+    // MINIDB_LOAD_THREADS sets the background loaders; 0 loads each table on first use
+    const char* env = std::getenv("MINIDB_LOAD_THREADS");
+    size_t threads = env ? std::strtoul(env, nullptr, 10)
+                         : std::min<size_t>(4, std::max(1u, std::thread::hardware_concurrency()));
+    threads = std::min(threads, load_queue.size());
+    for (size_t i = 0; i < threads; ++i) {
+        loaders.emplace_back([this]() { loaderLoop(); });
+    }
+}
+
+void Database::loaderLoop() {
+    std::unique_lock<std::mutex> lock(load_mutex);
+    while (!stop_loading && !load_queue.empty()) {
+        std::string name = load_queue.front();
+        load_queue.pop_front();
+        lock.unlock();
+        auto table = std::make_unique<Table>(name, data_dir);
+        lock.lock();
+        TableSlot& slot = *tableMap()->at(name);
+        slot.loaded = table.get();
+        slot.table = std::move(table);
+        table_loaded.notify_all();
+    }
+}
+
+Database::~Database() {
+    close();
+    {
+        std::lock_guard<std::mutex> lock(load_mutex);
+        stop_loading = true;
+    }
+    for (auto& loader : loaders) loader.join();
 }
 
 Table* Database::getTable(const std::string& name) {
-    auto it = tables.find(name);
-    if (it != tables.end()) {
-        return it->second.get();
+    auto map = tableMap();
+    auto it = map->find(name);
+    if (it == map->end()) {
+        errorStream() << "Error: Table " << name << " not found.\n";
+        return nullptr;
+    }
+    TableSlot& slot = *it->second;
+    if (Table* table = slot.loaded) return table;
+    std::unique_lock<std::mutex> lock(load_mutex);
+    if (!slot.table) {
+        auto queued = std::find(load_queue.begin(), load_queue.end(), name);
+        if (queued != load_queue.end()) {
+            // No loader has reached it yet: load it now instead of waiting behind other tables
+            load_queue.erase(queued);
+            lock.unlock();
+            auto table = std::make_unique<Table>(name, data_dir);
+            lock.lock();
+            slot.loaded = table.get();
+            slot.table = std::move(table);
+            table_loaded.notify_all();
+        } else {
+            table_loaded.wait(lock, [&]() { return slot.table != nullptr; });
+        }
+    }
+    return slot.table.get();
+}
+
+void Database::saveCatalog() {
+    std::vector<CatalogEntry> entries;
+    for (const auto& pair : *tableMap()) {
+        CatalogEntry entry;
+        entry.name = pair.first;
+        const std::string filepath = data_dir + pair.first + ".tbl";
+        // A loaded table is read under its latch, so the file is not rewritten
+        // between its stamp and the header fields recorded with it. One not
+        // loaded cannot have been written unless it is loaded by now.
+        Table* table = pair.second->loaded;
+        std::shared_lock<Latch> latch;
+        if (table) latch = std::shared_lock<Latch>(table->latch());
+        // A table created inside a transaction has no file until it commits
+        if (!tableFileStamp(filepath, entry.file_size, entry.file_mtime)) continue;
+        if (!table && (table = pair.second->loaded)) {
+            latch = std::shared_lock<Latch>(table->latch());
+            if (!tableFileStamp(filepath, entry.file_size, entry.file_mtime)) continue;
+        }
+        if (table) {
+            entry.meta = table->metadata();
+        } else {
+            std::lock_guard<std::mutex> lock(catalog_mutex);
+            entry.meta = catalog[pair.first].meta;
+        }
+        entries.push_back(std::move(entry));
+    }
+    std::lock_guard<std::mutex> lock(catalog_mutex);
+    for (const auto& entry : entries) catalog[entry.name] = entry;
+    writeCatalog(data_dir + CATALOG_FILE, entries);
+}
+
+Table* Database::getTableForWrite(const std::string& name) {
+    Table* table = getTable(name);
+    if (!table) return nullptr;
+    // Checked again by lockForWrite(); this only fails early, before planning
+    std::lock_guard<std::mutex> lock(writers_mutex);
+    auto writer = table_writers.find(table);
+    if (writer != table_writers.end() && writer->second != session()) {
+        errorStream() << "Error: Table " << name << " has uncommitted changes of another session.\n";
+        return nullptr;
+    }
+    return table;
+}
+
+bool Database::lockForWrite(Table& table, std::shared_lock<Latch>& gate, std::unique_lock<Latch>& latch) {
+    gate = std::shared_lock<Latch>(checkpoint_gate);
+    latch = std::unique_lock<Latch>(table.latch());
+    Session* client = session();
+    std::lock_guard<std::mutex> lock(writers_mutex);
+    auto writer = table_writers.find(&table);
+    if (writer != table_writers.end() && writer->second != client) {
+        errorStream() << "Error: Table " << table.getName() << " has uncommitted changes of another session.\n";
+        latch.unlock();
+        gate.unlock();
+        return false;
+    }
+    if (client->transaction_active && writer == table_writers.end()) {
+        table.beginUndo();
+        client->transaction_tables.push_back(&table);
+        table_writers[&table] = client;
+    }
+    return true;
+}
+
+Snapshot Database::statementSnapshot(bool writer) {
+    return session()->transaction_active ? session()->transaction_snapshot : versions.begin(writer);
+}
+
+void Database::endStatement(const Snapshot& snapshot, Table* written) {
+    if (session()->transaction_active) return;
+    if (written) {
+        uint64_t commit_ts = versions.commitTimestamp();
+        written->commitVersions(snapshot, commit_ts);
+        versions.publish(commit_ts);
     }
-    std::cerr << "Error: Table " << name << " not found.\n";
-    return nullptr;
+    versions.end(snapshot);
+    if (written) written->collectGarbage(versions.horizon());
 }
 
 void Database::showTables() {
-    std::cout << "Tables:\n";
-    for (const auto& pair : tables) {
-        std::cout << "- " << pair.first << "\n";
+    messageStream() << "Tables:\n";
+    for (const auto& pair : *tableMap()) {
+        messageStream() << "- " << pair.first << "\n";
     }
 }
 
 void Database::showTable(const std::string& name) {
     Table* table = getTable(name);
-    if (table) {
+    if (table && table->ensureRowIndex()) {
         std::vector<std::string> all_columns; // Empty vector indicates all columns
-        std::vector<std::pair<std::string, std::string>> aggregates;
-        table->select(all_columns, aggregates, "", "", {}, {});
+        std::vector<Aggregate> aggregates;
+        Snapshot snapshot = statementSnapshot(false);
+        std::unique_ptr<Cursor> cursor;
+        {
+            std::shared_lock<Latch> latch(table->latch());
+            cursor = table->select(all_columns, aggregates, {}, {}, {}, SIZE_MAX, 0, snapshot);
+        }
+        returnCursor(std::move(cursor), snapshot);
     }
 }
 
 void Database::describeTable(const std::string& name) {
-    Table* table = getTable(name);
-    if (table) {
-        std::cout << "Table: " << name << "\n";
-        std::cout << "Columns:\n";
-        for (const auto& col : table->getColumns()) {
-            std::cout << "- " << col << "\n";
+    // The catalog describes a table that is not loaded yet without loading it
+    TableData meta;
+    bool from_catalog = false;
+    {
+        auto map = tableMap();
+        auto it = map->find(name);
+        std::lock_guard<std::mutex> lock(catalog_mutex);
+        auto entry = catalog.find(name);
+        if (it != map->end() && !it->second->loaded && entry != catalog.end() &&
+            !entry->second.meta.columns.empty()) {
+            meta = entry->second.meta;
+            from_catalog = true;
+        }
+    }
+    std::vector<std::string> encodings; // of each column, when the table is loaded
+    if (!from_catalog) {
+        Table* table = getTable(name);
+        if (!table) return;
+        std::shared_lock<Latch> latch(table->latch());
+        meta = table->metadata();
+        for (size_t i = 0; i < meta.columns.size(); ++i) {
+            const ColumnStore::Dictionary* dictionary = table->dictionary(i);
+            encodings.push_back(dictionary ? " (dictionary, " + std::to_string(dictionary->size()) + " values)" : "");
+        }
+    }
+    messageStream() << "Table: " << name << "\n";
+    messageStream() << "Storage: " << (meta.storage == StorageKind::Column ? "columnar" : "row") << "\n";
+    messageStream() << "Columns:\n";
+    for (size_t i = 0; i < meta.columns.size(); ++i) {
+        ColumnType type = i < meta.types.size() ? meta.types[i] : ColumnType::Text;
+        messageStream() << "- " << meta.columns[i] << " " << columnTypeName(type)
+                        << (i < encodings.size() ? encodings[i] : "") << "\n";
+    }
+    if (!meta.indexes.empty()) {
+        messageStream() << "Indexes:\n";
+        for (const auto& index : meta.indexes) {
+            if (index.column >= meta.columns.size()) continue;
+            messageStream() << "- " << index.name << " (" << meta.columns[index.column] << ", "
+                      << (index.kind == IndexKind::BTree ? "btree" : "hash") << ")\n";
         }
     }
 }
 
-void Database::beginTransaction() {
-    if (transaction_active) {
-        std::cerr << "Error: Transaction already in progress.\n";
-        return;
+void Database::showStats() {
+    WalStats stats = wal.statistics();
+    messageStream() << "Durability: " << durabilityName(session()->durability) << "\n";
+    messageStream() << "Commit window: " << wal.commitWindow().count() << " us\n";
+    messageStream() << "Commits logged: " << stats.commits << "\n";
+    messageStream() << "Log writes: " << stats.batches << " (" << stats.syncs << " synced)\n";
+    double average = stats.batches ? static_cast<double>(stats.commits) / stats.batches : 0.0;
+    messageStream() << "Commits per write: " << std::fixed << std::setprecision(2) << average
+              << std::defaultfloat << " average, " << stats.largest_batch << " largest\n";
+    if (allocationsCounted()) {
+        messageStream() << "Heap allocations (process-wide): " << allocationCount() << " (" << allocatedBytes()
+                        << " bytes)\n";
     }
-    // Backup current tables
-    for (auto& pair : tables) {
-        table_backups[pair.first] = std::make_unique<Table>(*pair.second);
+    // Row storage of the loaded tables; the others have none yet
+    RowArena::Stats rows;
+    for (const auto& entry : *tableMap()) {
+        Table* table = entry.second->loaded.load();
+        if (!table) continue;
+        std::shared_lock<Latch> latch(table->latch());
+        const RowArena::Stats& arena = table->arenaStats();
+        rows.slabs += arena.slabs;
+        rows.reserved += arena.reserved;
+        rows.used += arena.used;
+        rows.garbage += arena.garbage;
     }
-    transaction_active = true;
-    std::cout << "Transaction started.\n";
+    messageStream() << "Row arenas: " << rows.slabs << " slabs, " << rows.reserved << " bytes reserved, "
+                    << rows.used << " used, " << rows.garbage << " garbage\n";
 }
 
-void Database::commitTransaction() {
-    if (!transaction_active) {
-        std::cerr << "Error: No active transaction to commit.\n";
+void Database::copyFrom(const std::string& table_name, const std::string& filepath, bool header) {
+    if (session()->transaction_active) {
+        errorStream() << "Error: COPY is not allowed inside a transaction.\n";
         return;
     }
-    // Save all tables
-    for (auto& pair : tables) {
-        pair.second->save();
+    Table* table = getTableForWrite(table_name);
+    if (!table || !table->ensureRowIndex()) return;
+    auto start = std::chrono::steady_clock::now();
+    std::vector<RowBatch> batches;
+    BulkLoadStats stats;
+    if (!parseCsvFile(filepath, table->getColumns(), table->getTypes(), table->getStorage(), header, batches,
+                      stats)) {
+        return;
+    }
+    {
+        std::shared_lock<Latch> gate;
+        std::unique_lock<Latch> latch;
+        if (!lockForWrite(*table, gate, latch)) return;
+        // With no snapshot open, no reader can see the rows before they are all
+        // there (a later one waits for the latch), so they go in without a
+        // version per row
+        bool versioned = versions.openCount() > 0;
+        Snapshot snapshot = versioned ? versions.begin(true) : Snapshot();
+        table->appendRows(batches, snapshot);
+        if (versioned) endStatement(snapshot, table);
+        // The rows are persisted by one write of the table file rather than a log entry each
+        table->setCheckpointLsn(wal.nextLsn() - 1);
+        table->save();
     }
-    table_backups.clear();
-    transaction_active = false;
-    std::cout << "Transaction committed.\n";
+    saveCatalog();
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    double seconds = std::max(elapsed.count(), 1e-9);
+    messageStream() << "Copied " << stats.rows << " row(s) into " << table_name << " in " << std::fixed
+              << std::setprecision(3) << seconds << " s (" << std::setprecision(0) << stats.rows / seconds
+              << " rows/s, " << std::setprecision(1) << stats.bytes / seconds / (1024 * 1024) << " MiB/s)"
+              << std::defaultfloat << ".\n";
 }
 
-void Database::rollbackTransaction() {
-    if (!transaction_active) {
-        std::cerr << "Error: No active transaction to rollback.\n";
-        return;
+uint64_t Database::logMutation(WalOp op, Table& table, const std::vector<std::string>& args) {
+    return logMutations({WalEntry(op, table.getName(), args)}, table);
+}
+
+uint64_t Database::logMutations(std::vector<WalEntry> entries, Table& table) {
+    if (entries.empty()) return 0;
+    Session* client = session();
+    if (client->transaction_active) {
+        // Written as a single frame at COMMIT, dropped on ROLLBACK
+        client->pending_log.insert(client->pending_log.end(), std::make_move_iterator(entries.begin()),
+                                   std::make_move_iterator(entries.end()));
+        return 0;
     }
-    // Restore tables from backups
-    for (auto& pair : table_backups) {
-        if (tables.find(pair.first) != tables.end()) {
-            tables[pair.first] = std::move(pair.second);
-        }
+    uint64_t lsn = wal.queue(entries, client->durability);
+    if (lsn == 0) {
+        // Fall back to a full rewrite so the statement is not lost
+        table.setCheckpointLsn(wal.nextLsn() - 1);
+        table.save();
     }
-    table_backups.clear();
-    transaction_active = false;
-    std::cout << "Transaction rolled back.\n";
+    return lsn;
 }
 
-void Database::run() {
-    // Auto load existing tables
-    autoLoadTables();
+void Database::awaitLog(uint64_t lsn, Table& table) {
+    if (lsn == 0 || session()->durability != Durability::Sync || wal.waitFor(lsn)) return;
+    // The frame never reached the disk: rewrite the table instead
+    std::shared_lock<Latch> gate(checkpoint_gate);
+    std::unique_lock<Latch> latch(table.latch());
+    table.setCheckpointLsn(wal.nextLsn() - 1);
+    table.save();
+}
 
-    std::string input;
-    std::cout << "Welcome to MiniDB! Enter SQL commands or 'exit' to quit.\n";
-    while (true) {
-        std::cout << "MiniDB> ";
-        std::getline(std::cin, input);
-        if (input.empty()) continue;
-
-        // Exit condition
-        if (input == "exit") break;
-
-        // Convert input to uppercase for command identification
-        std::stringstream ss(input);
-        std::string command;
-        ss >> command;
-        std::string original_command = command; // Preserve original for case-sensitive parts
-        std::transform(command.begin(), command.end(), command.begin(), ::toupper);
-
-        if (command == "CREATE") {
-            std::string table_keyword, table_name;
-            ss >> table_keyword >> table_name;
-            std::transform(table_keyword.begin(), table_keyword.end(), table_keyword.begin(), ::toupper);
-            if (table_keyword != "TABLE") {
-                std::cerr << "Error: Invalid syntax. Did you mean 'CREATE TABLE'? \n";
-                continue;
+bool Database::checkpoint() {
+    // Writers share the gate, so holding it alone waits for those running and
+    // keeps new ones out until the log is reset.
+    // Each table file records the last frame it contains, so a crash before
+    // the reset below cannot make load() apply a frame twice. Tables without
+    // changes already match their file and are left alone.
+    // A table not loaded yet may have frames in the log from before startup;
+    // loading it replays them, so it is loaded before the log goes away.
+    std::unique_lock<Latch> gate(checkpoint_gate);
+    std::vector<Table*> loaded;
+    for (const auto& pair : *tableMap()) {
+        Table* table = pair.second->loaded;
+        if (!table) {
+            uint64_t folded = 0;
+            {
+                std::lock_guard<std::mutex> lock(catalog_mutex);
+                auto entry = catalog.find(pair.first);
+                if (entry != catalog.end()) folded = entry->second.meta.checkpoint_lsn;
             }
-            // Parse columns
-            size_t pos1 = input.find('(');
-            size_t pos2 = input.find(')');
-            if (pos1 == std::string::npos || pos2 == std::string::npos || pos2 <= pos1 + 1) {
-                std::cerr << "Error: Invalid syntax for CREATE TABLE.\n";
-                continue;
-            }
-            std::string cols = input.substr(pos1 + 1, pos2 - pos1 - 1);
-            std::vector<std::string> columns;
-            std::stringstream cols_ss(cols);
-            std::string col;
-            while (std::getline(cols_ss, col, ',')) {
-                // Trim whitespace
-                col.erase(col.begin(), std::find_if(col.begin(), col.end(), [](unsigned char ch) {
-                    return !std::isspace(ch);
-                }));
-                col.erase(std::find_if(col.rbegin(), col.rend(), [](unsigned char ch) {
-                    return !std::isspace(ch);
-                }).base(), col.end());
-                columns.push_back(col);
-            }
-            createTable(table_name, columns);
+            if (wal.lastLsnAtOpen(pair.first) > folded) table = getTable(pair.first);
         }
-        else if (command == "INSERT") {
-            std::string into_keyword, table_name, values_keyword;
-            ss >> into_keyword >> table_name >> values_keyword;
-            std::transform(into_keyword.begin(), into_keyword.end(), into_keyword.begin(), ::toupper);
-            std::transform(values_keyword.begin(), values_keyword.end(), values_keyword.begin(), ::toupper);
-            if (into_keyword != "INTO" || values_keyword != "VALUES") {
-                std::cerr << "Error: Invalid syntax. Use 'INSERT INTO table_name VALUES (...)'\n";
-                continue;
-            }
-            size_t pos1 = input.find('(');
-            size_t pos2 = input.find(')');
-            if (pos1 == std::string::npos || pos2 == std::string::npos || pos2 <= pos1 + 1) {
-                std::cerr << "Error: Invalid syntax for INSERT.\n";
-                continue;
-            }
-            std::string vals = input.substr(pos1 + 1, pos2 - pos1 - 1);
-            std::vector<std::string> values;
-            std::stringstream vals_ss(vals);
-            std::string val;
-            while (std::getline(vals_ss, val, ',')) {
-                // Trim whitespace
-                val.erase(val.begin(), std::find_if(val.begin(), val.end(), [](unsigned char ch) {
-                    return !std::isspace(ch);
-                }));
-                val.erase(std::find_if(val.rbegin(), val.rend(), [](unsigned char ch) {
-                    return !std::isspace(ch);
-                }).base(), val.end());
-                // Remove quotes if present
-                if (!val.empty() && val.front() == '\'' && val.back() == '\'') {
-                    val = val.substr(1, val.size() - 2);
-                }
-                values.push_back(val);
-            }
-            Table* table = getTable(table_name);
-            if (table) {
-                table->insert(values);
-                if (!transaction_active) {
-                    table->save();
-                }
-                std::cout << "Record inserted into " << table_name << ".\n";
-            }
+        if (table) loaded.push_back(table);
+    }
+    bool saved = false;
+    const Table* unreadable = nullptr;
+    for (Table* table : loaded) {
+        // Its logged frames may be all that is left of it
+        if (table->isUnreadable()) unreadable = table;
+        // Only writers, kept out by the gate, make a table dirty
+        if (!table->isDirty()) continue;
+        std::unique_lock<Latch> latch(table->latch());
+        table->setCheckpointLsn(wal.nextLsn() - 1);
+        table->save();
+        saved = true;
+    }
+    if (unreadable) {
+        errorStream() << "Error: Table " << unreadable->getName() << " could not be read; the log is kept.\n";
+    } else {
+        wal.reset();
+    }
+    if (saved) {
+        saveCatalog();
+    }
+    return !unreadable;
+}
+
+void Database::beginTransaction() {
+    Session* client = session();
+    if (client->transaction_active) {
+        errorStream() << "Error: Transaction already in progress.\n";
+        return;
+    }
+    // Nothing is copied: tables record what they change as it happens, and
+    // every statement until COMMIT or ROLLBACK reads this snapshot
+    client->transaction_snapshot = versions.begin(true);
+    client->transaction_active = true;
+    ++open_transactions;
+    messageStream() << "Transaction started.\n";
+}
+
+void Database::commitTransaction() {
+    Session* client = session();
+    if (!client->transaction_active) {
+        errorStream() << "Error: No active transaction to commit.\n";
+        return;
+    }
+    // The tables are the session's until endTransaction(), so no other frame
+    // for them can come between the transaction's changes and its frame
+    std::shared_lock<Latch> gate(checkpoint_gate);
+    // Persist the whole transaction as one log frame
+    // Only the tables the transaction changed can be affected by the frame
+    bool logged = wal.append(client->pending_log, client->durability);
+    std::vector<std::unique_lock<Latch>> latches = lockTables(client->transaction_tables);
+    // The transaction's versions become visible to new snapshots all at once
+    uint64_t commit_ts = versions.commitTimestamp();
+    for (Table* table : client->transaction_tables) {
+        table->commitVersions(client->transaction_snapshot, commit_ts);
+        table->commitUndo();
+    }
+    versions.publish(commit_ts);
+    versions.end(client->transaction_snapshot);
+    for (Table* table : client->transaction_tables) {
+        table->collectGarbage(versions.horizon());
+        if (!logged && table->isDirty()) {
+            table->setCheckpointLsn(wal.nextLsn() - 1);
+            table->save();
         }
-        else if (command == "SELECT") {
-            // Extract selected columns until 'FROM' is found
-            std::vector<std::string> selected_columns;
-            std::vector<std::pair<std::string, std::string>> aggregates; // aggregate function and column
-            std::string token;
-
-            while (ss >> token &&
-                   token != "FROM" &&
-                   token != "from" &&
-                   token != "From") {
-                // Handle cases where columns are separated by commas
-                if (token.back() == ',') {
-                    token.pop_back(); // Remove trailing comma
-                }
-                // Check for aggregate functions
-                size_t pos = token.find('(');
-                if (pos != std::string::npos && token.back() == ')') {
-                    std::string func = token.substr(0, pos);
-                    std::string arg = token.substr(pos + 1, token.size() - pos - 2);
-                    std::transform(func.begin(), func.end(), func.begin(), ::toupper);
-                    if (func == "COUNT") {
-                        aggregates.emplace_back("COUNT", arg);
-                    }
-                    else {
-                        std::cerr << "Error: Unsupported aggregate function '" << func << "'.\n";
-                        aggregates.clear();
-                        break;
-                    }
-                }
-                else {
-                    selected_columns.push_back(token);
-                }
-            }
+    }
+    endTransaction();
+    messageStream() << "Transaction committed.\n";
+}
 
-            // Check if 'FROM' keyword was found
-            if (!(token == "FROM" || token == "from" || token == "From")) {
-                std::cerr << "Error: Invalid syntax. Missing 'FROM'.\n";
-                continue;
-            }
+void Database::endTransaction() {
+    Session* client = session();
+    {
+        std::lock_guard<std::mutex> lock(writers_mutex);
+        for (Table* table : client->transaction_tables) table_writers.erase(table);
+    }
+    client->transaction_tables.clear();
+    client->pending_log.clear();
+    client->transaction_active = false;
+    --open_transactions;
+}
 
-            // Extract table name
-            std::string table_name;
-            ss >> table_name;
-            if (table_name.empty()) {
-                std::cerr << "Error: Missing table name after 'FROM'.\n";
-                continue;
-            }
+std::vector<std::unique_lock<Latch>> Database::lockTables(std::vector<Table*> tables) {
+    // Always in the same order, so two sessions latching several tables cannot deadlock
+    std::sort(tables.begin(), tables.end(), std::less<Table*>());
+    std::vector<std::unique_lock<Latch>> latches;
+    latches.reserve(tables.size());
+    for (Table* table : tables) latches.emplace_back(table->latch());
+    return latches;
+}
 
-            // Initialize variables for WHERE, ORDER BY, GROUP BY clauses
-            std::string clause;
-            std::string where_column, where_value;
-            std::vector<std::pair<std::string, std::string>> order_by; // column and direction
-            std::vector<std::string> group_by;
-
-            while (ss >> clause) {
-                std::string upper_clause = clause;
-                std::transform(upper_clause.begin(), upper_clause.end(), upper_clause.begin(), ::toupper);
-                if (upper_clause == "WHERE") {
-                    ss >> where_column >> where_value;
-                    // Remove potential semicolon at the end of where_value
-                    if (!where_value.empty() && where_value.back() == ';') {
-                        where_value.pop_back();
-                    }
-                    // Remove quotes if present
-                    if (!where_value.empty() && where_value.front() == '\'' && where_value.back() == '\'') {
-                        where_value = where_value.substr(1, where_value.size() - 2);
-                    }
-                }
-                else if (upper_clause == "ORDER") {
-                    std::string by;
-                    ss >> by;
-                    std::transform(by.begin(), by.end(), by.begin(), ::toupper);
-                    if (by != "BY") {
-                        std::cerr << "Error: Invalid syntax after 'ORDER'. Did you mean 'ORDER BY'? \n";
-                        break;
-                    }
-                    std::string order_col, direction = "ASC";
-                    ss >> order_col;
-                    if (!(ss >> direction)) {
-                        direction = "ASC";
-                    }
-                    else {
-                        std::transform(direction.begin(), direction.end(), direction.begin(), ::toupper);
-                        if (direction != "ASC" && direction != "DESC") {
-                            ss.unget(); // Put back the non-direction token if it's not direction
-                            direction = "ASC";
-                        }
-                    }
-                    order_by.emplace_back(order_col, direction);
-                }
-                else if (upper_clause == "GROUP") {
-                    std::string by;
-                    ss >> by;
-                    std::transform(by.begin(), by.end(), by.begin(), ::toupper);
-                    if (by != "BY") {
-                        std::cerr << "Error: Invalid syntax after 'GROUP'. Did you mean 'GROUP BY'? \n";
-                        break;
-                    }
-                    std::string group_col;
-                    ss >> group_col;
-                    group_by.emplace_back(group_col);
-                }
-                else {
-                    std::cerr << "Error: Unrecognized clause '" << clause << "'.\n";
-                    break;
-                }
-            }
+void Database::rollbackTransaction() {
+    Session* client = session();
+    if (!client->transaction_active) {
+        errorStream() << "Error: No active transaction to rollback.\n";
+        return;
+    }
+    std::shared_lock<Latch> gate(checkpoint_gate);
+    std::vector<std::unique_lock<Latch>> latches = lockTables(client->transaction_tables);
+    // Each table reverses its own changes; untouched tables cost nothing
+    for (Table* table : client->transaction_tables) {
+        table->rollbackUndo();
+    }
+    versions.end(client->transaction_snapshot);
+    for (Table* table : client->transaction_tables) {
+        table->collectGarbage(versions.horizon());
+    }
+    endTransaction();
+    messageStream() << "Transaction rolled back.\n";
+}
 
-            // Handle '*' to select all columns
-            if (selected_columns.size() == 1 && selected_columns[0] == "*") {
-                selected_columns.clear(); // Passing an empty vector will indicate selecting all columns
-            }
+void Database::returnCursor(std::unique_ptr<Cursor> cursor, const Snapshot& snapshot) {
+    if (!cursor) {
+        endStatement(snapshot);
+        return;
+    }
+    // The cursor may be closed while another session runs: it ends the
+    // snapshot only if the statement had its own
+    Session* owner = session();
+    bool own_snapshot = !owner->transaction_active;
+    owner->open_cursor = cursor.get();
+    cursor->onClose([this, owner, own_snapshot, snapshot]() {
+        owner->open_cursor = nullptr;
+        if (own_snapshot) versions.end(snapshot);
+    });
+    owner->result_cursor = std::move(cursor);
+}
 
-            // Retrieve the table and perform the select operation
-            Table* table = getTable(table_name);
-            if (table) {
-                table->select(selected_columns, aggregates, where_column, where_value, order_by, group_by);
-            }
+void Database::runPlan(Plan& plan, Table& table, const std::vector<std::string>& params, bool explain,
+                       bool analyze) {
+    if (!table.ensureRowIndex() || !bindParameters(plan, table, params)) return;
+    const std::string& table_name = plan.table;
+    if (plan.kind == StatementKind::Select) {
+        Snapshot snapshot = statementSnapshot(false);
+        if (explain) {
+            std::shared_lock<Latch> latch(table.latch());
+            table.explain(plan.select, analyze, snapshot);
+            latch.unlock();
+            endStatement(snapshot);
+            return;
         }
-        else if (command == "UPDATE") {
-            std::string table_name, set_keyword;
-            ss >> table_name >> set_keyword;
-            std::transform(set_keyword.begin(), set_keyword.end(), set_keyword.begin(), ::toupper);
-            if (set_keyword != "SET") {
-                std::cerr << "Error: Invalid syntax. Did you mean 'SET'? \n";
-                continue;
-            }
-            std::string set_column, equal_sign, set_value;
-            ss >> set_column >> equal_sign >> set_value;
-            if (equal_sign != "=") {
-                std::cerr << "Error: Invalid syntax for SET. Expected '='.\n";
-                continue;
-            }
-
-            // Remove quotes if present
-            if (!set_value.empty() && set_value.front() == '\'' && set_value.back() == '\'') {
-                set_value = set_value.substr(1, set_value.size() - 2);
+        // The cursor holds copies of its rows, so the latch goes before the client reads them
+        std::unique_ptr<Cursor> cursor;
+        {
+            std::shared_lock<Latch> latch(table.latch());
+            cursor = table.select(plan.select, snapshot);
+        }
+        returnCursor(std::move(cursor), snapshot);
+        return;
+    }
+    // A write holds the table alone until its frame is queued, and waits for
+    // the disk after letting go, so writers of a table still share log syncs
+    std::shared_lock<Latch> gate;
+    std::unique_lock<Latch> latch;
+    if (!lockForWrite(table, gate, latch)) return;
+    uint64_t lsn = 0;
+    switch (plan.kind) {
+        case StatementKind::Insert: {
+            std::vector<std::vector<std::string>> rows = planRows(plan, params);
+            Snapshot snapshot = statementSnapshot(true);
+            bool inserted = table.insertRows(rows, snapshot);
+            // Committed before it is logged, so a checkpoint folding the frame writes it
+            endStatement(snapshot, &table);
+            if (inserted) {
+                // One frame, and so one log write, for the whole statement
+                std::vector<WalEntry> entries;
+                entries.reserve(rows.size());
+                for (const auto& row : rows) entries.emplace_back(WalOp::Insert, table_name, row);
+                lsn = logMutations(std::move(entries), table);
+                latch.unlock();
+                gate.unlock();
+                awaitLog(lsn, table);
+                if (rows.size() == 1) {
+                    messageStream() << "Record inserted into " << table_name << ".\n";
+                } else {
+                    messageStream() << rows.size() << " records inserted into " << table_name << ".\n";
+                }
             }
-
-            // Handle optional WHERE clause
-            std::string clause;
-            std::string where_column, where_value;
-            if (ss >> clause) {
-                std::string upper_clause = clause;
-                std::transform(upper_clause.begin(), upper_clause.end(), upper_clause.begin(), ::toupper);
-                if (upper_clause == "WHERE") {
-                    ss >> where_column >> where_value;
-                    // Remove potential semicolon at the end of where_value
-                    if (!where_value.empty() && where_value.back() == ';') {
-                        where_value.pop_back();
-                    }
-                    // Remove quotes if present
-                    if (!where_value.empty() && where_value.front() == '\'' && where_value.back() == '\'') {
-                        where_value = where_value.substr(1, where_value.size() - 2);
+            break;
+        }
+        case StatementKind::Update: {
+            Snapshot snapshot = statementSnapshot(true);
+            // A transaction logs the rows it changes (see WalOp::UpdateRows)
+            bool in_transaction = session()->transaction_active;
+            std::vector<std::string> images;
+            int updated_count = table.update(plan.update, snapshot, in_transaction ? &images : nullptr);
+            endStatement(snapshot, &table);
+            if (updated_count >= 0) {
+                if (updated_count > 0) {
+                    std::string set_value = plan.set_param < 0 ? formatValue(table.getTypes()[plan.update.column],
+                                                                             plan.update.value)
+                                                               : params[plan.set_param];
+                    std::vector<std::string> args = {table.getColumns()[plan.update.column], set_value};
+                    if (in_transaction) {
+                        args.insert(args.end(), std::make_move_iterator(images.begin()),
+                                    std::make_move_iterator(images.end()));
+                    } else {
+                        // The WHERE clause is logged as text, empty when there is none
+                        args.push_back(plan.where_expr ? exprToString(*plan.where_expr, params) : "");
                     }
+                    lsn = logMutation(in_transaction ? WalOp::UpdateRows : WalOp::Update, table, args);
                 }
-                else {
-                    std::cerr << "Error: Unrecognized clause '" << clause << "' in UPDATE.\n";
-                    continue;
-                }
+                latch.unlock();
+                gate.unlock();
+                awaitLog(lsn, table);
+                messageStream() << "Updated " << updated_count << " record(s) in " << table_name << ".\n";
             }
-
-            Table* table = getTable(table_name);
-            if (table) {
-                table->update(set_column, set_value, where_column, where_value);
-                if (!transaction_active) {
-                    table->save();
+            break;
+        }
+        case StatementKind::Delete: {
+            Snapshot snapshot = statementSnapshot(true);
+            bool in_transaction = session()->transaction_active;
+            std::vector<std::string> images;
+            int deleted_count = table.deleteRecords(plan.where, snapshot, in_transaction ? &images : nullptr);
+            endStatement(snapshot, &table);
+            if (deleted_count >= 0) {
+                if (deleted_count > 0 && in_transaction) {
+                    lsn = logMutation(WalOp::DeleteRows, table, images);
+                } else if (deleted_count > 0) {
+                    lsn = logMutation(WalOp::Delete, table,
+                                      {plan.where_expr ? exprToString(*plan.where_expr, params) : ""});
                 }
+                latch.unlock();
+                gate.unlock();
+                awaitLog(lsn, table);
+                messageStream() << "Deleted " << deleted_count << " record(s) from " << table_name << ".\n";
             }
+            break;
         }
-        else if (command == "DELETE") {
-            std::string from_keyword, table_name;
-            ss >> from_keyword >> table_name;
-            std::transform(from_keyword.begin(), from_keyword.end(), from_keyword.begin(), ::toupper);
-            if (from_keyword != "FROM") {
-                std::cerr << "Error: Invalid syntax. Did you mean 'DELETE FROM'? \n";
-                continue;
-            }
+        default:
+            break;
+    }
+}
 
-            // Handle optional WHERE clause
-            std::string clause;
-            std::string where_column, where_value;
-            if (ss >> clause) {
-                std::string upper_clause = clause;
-                std::transform(upper_clause.begin(), upper_clause.end(), upper_clause.begin(), ::toupper);
-                if (upper_clause == "WHERE") {
-                    ss >> where_column >> where_value;
-                    // Remove potential semicolon at the end of where_value
-                    if (!where_value.empty() && where_value.back() == ';') {
-                        where_value.pop_back();
-                    }
-                    // Remove quotes if present
-                    if (!where_value.empty() && where_value.front() == '\'' && where_value.back() == '\'') {
-                        where_value = where_value.substr(1, where_value.size() - 2);
-                    }
-                }
-                else {
-                    std::cerr << "Error: Unrecognized clause '" << clause << "' in DELETE.\n";
-                    continue;
-                }
-            }
+Plan* Database::preparedPlan(const std::string& name, const std::vector<std::string>& args) {
+    auto it = session()->prepared.find(name);
+    if (it == session()->prepared.end()) {
+        errorStream() << "Error: Prepared statement " << name << " does not exist.\n";
+        return nullptr;
+    }
+    Plan& plan = it->second;
+    if (args.size() != plan.param_count) {
+        errorStream() << "Error: Statement " << name << " expects " << plan.param_count << " parameter(s), got "
+                  << args.size() << ".\n";
+        return nullptr;
+    }
+    return &plan;
+}
 
-            Table* table = getTable(table_name);
-            if (table) {
-                table->deleteRecords(where_column, where_value);
-                if (!transaction_active) {
-                    table->save();
-                }
-            }
+void Database::execute(Statement& statement) {
+    switch (statement.kind) {
+        case StatementKind::CreateTable:
+            createTable(statement.table, statement.columns, statement.types, statement.storage);
+            break;
+        case StatementKind::CreateIndex:
+            createIndex(statement.name, statement.table, statement.column, statement.index_kind);
+            break;
+        case StatementKind::Select:
+        case StatementKind::Insert:
+        case StatementKind::Update:
+        case StatementKind::Delete: {
+            bool writes = statement.kind != StatementKind::Select;
+            Table* table = writes ? getTableForWrite(statement.table) : getTable(statement.table);
+            Plan plan;
+            if (table && planLatched(statement, *table, plan)) runPlan(plan, *table, {});
+            break;
         }
-        else if (command == "SHOW") {
-            std::string target;
-            ss >> target;
+        case StatementKind::Copy:
+            copyFrom(statement.table, statement.value.text, statement.header);
+            break;
+        case StatementKind::Show: {
+            std::string target = statement.name;
             std::transform(target.begin(), target.end(), target.begin(), ::toupper);
             if (target == "TABLES") {
                 showTables();
             }
+            else if (target == "STATS") {
+                showStats();
+            }
             else {
-                // Assume it's a table name
-                showTable(target);
+                showTable(statement.name);
             }
+            break;
         }
-        else if (command == "DESCRIBE") {
-            std::string table_name;
-            ss >> table_name;
-            if (table_name.empty()) {
-                std::cerr << "Error: Missing table name for DESCRIBE.\n";
-                continue;
+        case StatementKind::Describe:
+            describeTable(statement.table);
+            break;
+        case StatementKind::Begin:
+            beginTransaction();
+            break;
+        case StatementKind::Commit:
+            commitTransaction();
+            break;
+        case StatementKind::Rollback:
+            rollbackTransaction();
+            break;
+        case StatementKind::Checkpoint:
+            if (session()->transaction_active) {
+                errorStream() << "Error: Cannot checkpoint inside a transaction.\n";
+                break;
+            }
+            if (open_transactions > 0) {
+                errorStream() << "Error: Cannot checkpoint while another session has a transaction open.\n";
+                break;
+            }
+            if (checkpoint()) messageStream() << "Checkpoint complete.\n";
+            break;
+        case StatementKind::Set: {
+            // SET PARALLELISM n caps the threads one statement may use (0 = all)
+            // SET DURABILITY SYNC|ASYNC|OFF picks when this session's commits return
+            // SET COMMIT_WINDOW n makes the log wait n microseconds for more commits per write
+            std::string setting = statement.name;
+            const std::string& value = statement.value.text;
+            std::transform(setting.begin(), setting.end(), setting.begin(), ::toupper);
+            if (setting == "DURABILITY") {
+                if (!parseDurability(value, session()->durability)) {
+                    errorStream() << "Error: Invalid syntax. Use 'SET DURABILITY SYNC|ASYNC|OFF'.\n";
+                    break;
+                }
+                messageStream() << "Durability set to " << durabilityName(session()->durability) << ".\n";
+                break;
             }
-            describeTable(table_name);
+            bool numeric = !value.empty() && value.size() <= 9 &&
+                           value.find_first_not_of("0123456789") == std::string::npos;
+            if (setting == "COMMIT_WINDOW" && numeric) {
+                wal.setCommitWindow(std::chrono::microseconds(std::stoul(value)));
+                messageStream() << "Commit window set to " << wal.commitWindow().count() << " us.\n";
+                break;
+            }
+            if (setting != "PARALLELISM" || !numeric) {
+                errorStream() << "Error: Invalid syntax. Use 'SET PARALLELISM n', 'SET DURABILITY SYNC|ASYNC|OFF' "
+                             "or 'SET COMMIT_WINDOW n'.\n";
+                break;
+            }
+            ThreadPool& pool = ThreadPool::shared();
+            pool.setMaxParallelism(std::stoul(value));
+            messageStream() << "Parallelism set to " << pool.maxParallelism() << " of " << pool.threadCount()
+                      << " thread(s).\n";
+            break;
         }
-        else if (command == "BEGIN") {
-            std::string transaction_keyword;
-            ss >> transaction_keyword;
-            std::transform(transaction_keyword.begin(), transaction_keyword.end(), transaction_keyword.begin(), ::toupper);
-            if (transaction_keyword != "TRANSACTION" && transaction_keyword != "TRANSACTION;") {
-                std::cerr << "Error: Invalid syntax. Use 'BEGIN TRANSACTION'.\n";
-                continue;
+        case StatementKind::Prepare: {
+            if (session()->prepared.count(statement.name)) {
+                errorStream() << "Error: Prepared statement " << statement.name << " already exists.\n";
+                break;
             }
-            beginTransaction();
+            Statement& body = *statement.body;
+            Table* table = getTable(body.table);
+            Plan plan;
+            if (!table || !planLatched(body, *table, plan)) break;
+            session()->prepared.emplace(statement.name, std::move(plan));
+            messageStream() << "Statement " << statement.name << " prepared.\n";
+            break;
         }
-        else if (command == "COMMIT") {
-            commitTransaction();
+        case StatementKind::Execute: {
+            Plan* plan = preparedPlan(statement.name, statement.args);
+            if (!plan) break;
+            Table* table = plan->kind == StatementKind::Select ? getTable(plan->table) : getTableForWrite(plan->table);
+            if (table) runPlan(*plan, *table, statement.args);
+            break;
         }
-        else if (command == "ROLLBACK") {
-            rollbackTransaction();
+        case StatementKind::Explain: {
+            Statement& body = *statement.body;
+            if (body.kind == StatementKind::Execute) {
+                Plan* plan = preparedPlan(body.name, body.args);
+                if (!plan) break;
+                if (plan->kind != StatementKind::Select) {
+                    errorStream() << "Error: Only SELECT statements can be explained.\n";
+                    break;
+                }
+                Table* table = getTable(plan->table);
+                if (table) runPlan(*plan, *table, body.args, true, statement.analyze);
+                break;
+            }
+            Table* table = getTable(body.table);
+            Plan plan;
+            if (table && planLatched(body, *table, plan)) runPlan(plan, *table, {}, true, statement.analyze);
+            break;
         }
-        else {
-            std::cerr << "Error: Unrecognized command.\n";
+        case StatementKind::Deallocate:
+            if (session()->prepared.erase(statement.name) == 0) {
+                errorStream() << "Error: Prepared statement " << statement.name << " does not exist.\n";
+                break;
+            }
+            messageStream() << "Statement " << statement.name << " deallocated.\n";
+            break;
+    }
+}
+
+void Database::open() {
+    if (opened) return;
+    opened = true;
+    autoLoadTables();
+}
+
+QueryResult Database::execute(const std::string& sql) {
+    return execute(sql, local_session);
+}
+
+QueryResult Database::execute(const std::string& sql, Session& client) {
+    SessionScope scope(this, &client);
+    // Statements may change the rows an earlier cursor has yet to read
+    if (client.open_cursor) client.open_cursor->close();
+    QueryResult result;
+    {
+        OutputCapture capture;
+        Statement statement;
+        if (parseStatement(sql, statement)) execute(statement);
+        // Once the log has grown too long it is folded into the tables, by a
+        // statement holding no latch: a checkpoint may need any table alone
+        if (wal.sizeBytes() >= WAL_CHECKPOINT_BYTES && open_transactions == 0) {
+            checkpoint();
         }
+        result.error = capture.errors();
+        result.message = capture.messages();
+    }
+    result.ok = result.error.empty();
+    result.cursor = std::move(client.result_cursor);
+    return result;
+}
+
+void Database::endSession(Session& client) {
+    SessionScope scope(this, &client);
+    if (client.open_cursor) client.open_cursor->close();
+    if (client.transaction_active) {
+        rollbackTransaction();
+    }
+}
+
+void Database::close() {
+    endSession(local_session);
+    if (!opened) return;
+    opened = false;
+    // Uncommitted work is discarded, everything committed is folded into the tables
+    if (open_transactions == 0) {
+        checkpoint();
     }
-}
\ No newline at end of file
+}
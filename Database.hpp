@@ -2,37 +2,192 @@
 #ifndef DATABASE_HPP
 #define DATABASE_HPP
 
+#include "Catalog.hpp"
+#include "Latch.hpp"
+#include "Planner.hpp"
+#include "Statement.hpp"
 #include "Table.hpp"
+#include "TransactionManager.hpp"
+#include "WriteAheadLog.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
 #include <unordered_map>
 #include <memory>
+#include <utility>
 #include <vector>
 #include <string>
 
+// One client's state: its transaction, prepared statements, durability
+// setting and the cursor it is reading. The REPL uses the database's own
+// session; a server keeps one per connection.
+struct Session {
+    // Transaction support: BEGIN only sets the flag; each table records undo
+    // entries from the first statement that changes it
+    bool transaction_active = false;
+    std::vector<Table*> transaction_tables; // tables changed by the open transaction
+    Snapshot transaction_snapshot;
+    std::vector<WalEntry> pending_log; // entries of the open transaction
+    Durability durability = Durability::Sync; // this session's commits (SET DURABILITY)
+    // Plans of PREPAREd statements by name: EXECUTE binds parameters and runs
+    std::unordered_map<std::string, Plan> prepared;
+    // The cursor of the statement being executed, for execute() to return, and
+    // the last one returned until it is closed
+    std::unique_ptr<Cursor> result_cursor;
+    Cursor* open_cursor = nullptr;
+};
+
+// What one statement did: the errors and messages it reported, as the REPL
+// prints them, and for SELECT or SHOW <table> a cursor over the rows
+struct QueryResult {
+    bool ok = true; // no errors
+    std::string error;
+    std::string message;
+    std::unique_ptr<Cursor> cursor;
+};
+
 class Database {
 private:
-    std::unordered_map<std::string, std::unique_ptr<Table>> tables;
-    // Transaction support
-    bool transaction_active = false;
-    std::unordered_map<std::string, std::unique_ptr<Table>> table_backups;
+    // A table of the catalog; it is never removed, so the Table it holds once
+    // loaded lives as long as the database
+    struct TableSlot {
+        std::unique_ptr<Table> table; // null until loaded; set under load_mutex
+        std::atomic<Table*> loaded{nullptr}; // table.get() once set, read without a lock
+    };
+    using TableMap = std::unordered_map<std::string, std::shared_ptr<TableSlot>>;
+
+    std::string data_dir; // with a trailing '/'
+    // Read-copy-update: statements look tables up in the current map without
+    // a lock (std::atomic_load), and CREATE TABLE publishes a copy with the new
+    // slot under table_map_mutex, so lookups never wait for it
+    std::shared_ptr<const TableMap> table_map = std::make_shared<TableMap>();
+    std::mutex table_map_mutex;
+    // Startup registers the tables of the catalog without opening them. Loader
+    // threads then load them in the background, and a statement that needs one
+    // loads it itself, or waits for the loader that has it, so it waits only
+    // for the tables it touches.
+    std::unordered_map<std::string, CatalogEntry> catalog; // last written entry of each table
+    std::mutex catalog_mutex; // guards catalog and writing the catalog file
+    std::mutex load_mutex; // guards the slots' tables and load_queue
+    std::condition_variable table_loaded;
+    std::deque<std::string> load_queue; // tables no one has started loading
+    std::vector<std::thread> loaders;
+    bool stop_loading = false;
+    // Every statement reads a snapshot: its session's transaction's, taken at
+    // BEGIN, or its own. Writes create row versions that no other snapshot sees
+    // until they commit, so readers never wait for a writer or see its changes early.
+    TransactionManager versions;
+    // Durability: autocommit statements append here instead of rewriting tables
+    WriteAheadLog wal;
+    bool opened = false;
+    Session local_session;
+    // Sessions run statements concurrently. A statement holds the latch of
+    // each table it uses for as long as it runs (a SELECT until its rows are
+    // copied into its cursor): shared to read, alone to write, so SELECTs share tables and
+    // writers wait only for those on the tables they touch. Writes also share
+    // the checkpoint gate, which a checkpoint takes alone to fold the log into
+    // quiet tables. The gate comes before table latches, and several tables
+    // are latched in address order.
+    Latch checkpoint_gate;
+    // A table records the undo entries of one transaction at a time: its session's
+    std::unordered_map<Table*, Session*> table_writers;
+    std::mutex writers_mutex; // guards table_writers
+    std::atomic<size_t> open_transactions{0}; // in any session; checkpoints wait for none
 
+    // The session of the statement this thread is executing, else local_session
+    Session* session();
+    // The current table map; its slots stay valid after a newer map replaces it
+    std::shared_ptr<const TableMap> tableMap() const { return std::atomic_load(&table_map); }
+    // Add a slot for name to the map; false if the table already exists
+    bool addTableSlot(const std::string& name, std::unique_ptr<Table> table);
     void autoLoadTables(); // Added for auto-loading tables on start
+    void loaderLoop();
+    // Record every table file's current header fields in the catalog
+    void saveCatalog();
+    uint64_t logMutation(WalOp op, Table& table, const std::vector<std::string>& args);
+    // Log the entries of one statement on table as a single frame, with the
+    // table held alone so frames are in the order the changes were made; the
+    // frame's LSN is returned for awaitLog() once the latch is released
+    uint64_t logMutations(std::vector<WalEntry> entries, Table& table);
+    // Return once the frame at lsn (0: none) is as durable as the session
+    // asked; if it could not be written, table is rewritten instead
+    void awaitLog(uint64_t lsn, Table& table);
+    // Take the gate shared and table alone for a statement that changes it.
+    // Inside a transaction the table becomes the session's and records undo
+    // entries; false, reported, if it is another session's.
+    bool lockForWrite(Table& table, std::shared_lock<Latch>& gate, std::unique_lock<Latch>& latch);
+    // Hold each of tables alone, latched in address order
+    std::vector<std::unique_lock<Latch>> lockTables(std::vector<Table*> tables);
+    // Forget the session's finished transaction
+    void endTransaction();
+    // Snapshot for one statement: the transaction's if one is open, otherwise a new one
+    Snapshot statementSnapshot(bool writer);
+    // Ends a statement's own snapshot; a write is committed first and its
+    // superseded versions collected
+    void endStatement(const Snapshot& snapshot, Table* written = nullptr);
+    // Make cursor (null after an error) the statement's result; its snapshot
+    // ends when the cursor is closed
+    void returnCursor(std::unique_ptr<Cursor> cursor, const Snapshot& snapshot);
+    // Bind params into a SELECT, INSERT, UPDATE or DELETE plan and run it on
+    // table; explain prints a SELECT's operators instead (running them with analyze)
+    void runPlan(Plan& plan, Table& table, const std::vector<std::string>& params, bool explain = false,
+                 bool analyze = false);
+    // The plan of a prepared statement, checked against the number of args; reports a problem and returns nullptr
+    Plan* preparedPlan(const std::string& name, const std::vector<std::string>& args);
+
+    void execute(Statement& statement);
 
 public:
-    Database() = default;
+    // Tables, log and catalog live in dir, which is created if it does not exist
+    explicit Database(const std::string& dir = DATA_DIR);
+    ~Database();
+    Database(const Database&) = delete;
+    Database& operator=(const Database&) = delete;
+
+    // Find the tables in the data directory and start loading them in the background
+    void open();
+    // Run one SQL statement. What it reports is returned rather than printed,
+    // and a SELECT's rows are read from the returned cursor, which holds the
+    // statement's snapshot until it is closed; the next execute() closes it.
+    QueryResult execute(const std::string& sql);
+    // execute() for another client's session. Each session may be used by one
+    // thread at a time, and different sessions run concurrently. An open
+    // cursor holds no latch, so statements of other sessions do not wait for it.
+    QueryResult execute(const std::string& sql, Session& client);
+    // Close the session's cursor and roll back its open transaction
+    void endSession(Session& client);
+    // Close any open cursor, roll back an open transaction and checkpoint;
+    // the destructor does this if it was not called
+    void close();
 
-    void createTable(const std::string& name, const std::vector<std::string>& columns);
+    void createTable(const std::string& name, const std::vector<std::string>& columns,
+                     const std::vector<ColumnType>& types, StorageKind storage = StorageKind::Row);
+    void createIndex(const std::string& index_name, const std::string& table_name, const std::string& column,
+                     IndexKind kind = IndexKind::Hash);
     void loadTable(const std::string& name);
     Table* getTable(const std::string& name);
+    // getTable() for a statement that changes the table; reports a table with
+    // uncommitted changes of another session
+    Table* getTableForWrite(const std::string& name);
     void showTables();
     void showTable(const std::string& name);
     void describeTable(const std::string& name);
+    void showStats();
+    // COPY table FROM 'file' [HEADER]: bulk load a CSV file, persisted with one table write
+    void copyFrom(const std::string& table_name, const std::string& filepath, bool header);
 
     // Transaction methods
     void beginTransaction();
     void commitTransaction();
     void rollbackTransaction();
 
-    void run();
+    // Fold the log into the table files and truncate it; waits for running
+    // writes to finish and holds off new ones meanwhile. False, with the log
+    // kept, if a table could not be read
+    bool checkpoint();
 };
 
-#endif // DATABASE_HPP
\ No newline at end of file
+#endif // DATABASE_HPP
@@ -0,0 +1,24 @@
+// Diagnostics.cpp
+#include "Diagnostics.hpp"
+#include <iostream>
+
+static thread_local std::ostream* error_stream = nullptr;
+static thread_local std::ostream* message_stream = nullptr;
+
+std::ostream& errorStream() {
+    return error_stream ? *error_stream : std::cerr;
+}
+
+std::ostream& messageStream() {
+    return message_stream ? *message_stream : std::cout;
+}
+
+OutputCapture::OutputCapture() : saved_errors(error_stream), saved_messages(message_stream) {
+    error_stream = &error_text;
+    message_stream = &message_text;
+}
+
+OutputCapture::~OutputCapture() {
+    error_stream = saved_errors;
+    message_stream = saved_messages;
+}
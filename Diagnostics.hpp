@@ -0,0 +1,34 @@
+// Diagnostics.hpp
+#ifndef DIAGNOSTICS_HPP
+#define DIAGNOSTICS_HPP
+
+#include <ostream>
+#include <sstream>
+#include <string>
+
+// Statements report errors ("Error: ...") and what they did through these
+// streams: std::cerr and std::cout, unless the calling thread is capturing
+// them with an OutputCapture
+std::ostream& errorStream();
+std::ostream& messageStream();
+
+// While it exists, errorStream() and messageStream() of the thread that made
+// it write into it instead. Captures nest; the innermost one wins.
+class OutputCapture {
+private:
+    std::ostringstream error_text;
+    std::ostringstream message_text;
+    std::ostream* saved_errors;
+    std::ostream* saved_messages;
+
+public:
+    OutputCapture();
+    ~OutputCapture();
+    OutputCapture(const OutputCapture&) = delete;
+    OutputCapture& operator=(const OutputCapture&) = delete;
+
+    std::string errors() const { return error_text.str(); }
+    std::string messages() const { return message_text.str(); }
+};
+
+#endif // DIAGNOSTICS_HPP
@@ -0,0 +1,275 @@
+// Expression.cpp
+#include "Expression.hpp"
+#include "Diagnostics.hpp"
+#include <algorithm>
+#include <cctype>
+#include <iostream>
+
+namespace {
+
+class Parser {
+private:
+    Lexer& lexer;
+    bool failed = false;
+
+    const Token& current() const { return lexer.peek(); }
+    void advance() { lexer.advance(); }
+    bool isKeyword(const char* keyword) const { return lexer.is(keyword); }
+
+    bool atClauseEnd() const {
+        return current().type == TokenType::End || isKeyword("ORDER") || isKeyword("GROUP") ||
+               isKeyword("LIMIT") || isKeyword("OFFSET");
+    }
+
+    void error(const std::string& message) {
+        if (!failed) errorStream() << "Error: " << message << ".\n";
+        failed = true;
+    }
+
+    // A literal, or a ? parameter (recorded in expr.params)
+    bool literal(Expr& expr, size_t slot) {
+        if (current().type == TokenType::Invalid) {
+            error("Unterminated string in WHERE clause");
+            return false;
+        }
+        if (current().type == TokenType::Param) {
+            expr.params.resize(expr.values.size(), -1);
+            expr.params[slot] = static_cast<int>(current().param);
+            advance();
+            return true;
+        }
+        if (current().type != TokenType::Word && current().type != TokenType::String) {
+            error("Expected a value in WHERE clause" + (current().text.empty() ? "" : " near '" + current().text + "'"));
+            return false;
+        }
+        expr.values[slot] = current().text;
+        advance();
+        return true;
+    }
+
+    ExprPtr orExpr() {
+        ExprPtr left = andExpr();
+        while (left && isKeyword("OR")) {
+            advance();
+            ExprPtr right = andExpr();
+            if (!right) return nullptr;
+            left = combine(ExprKind::Or, std::move(left), std::move(right));
+        }
+        return left;
+    }
+
+    ExprPtr andExpr() {
+        ExprPtr left = notExpr();
+        while (left && isKeyword("AND")) {
+            advance();
+            ExprPtr right = notExpr();
+            if (!right) return nullptr;
+            left = combine(ExprKind::And, std::move(left), std::move(right));
+        }
+        return left;
+    }
+
+    // a AND b AND c becomes one node with three children
+    static ExprPtr combine(ExprKind kind, ExprPtr left, ExprPtr right) {
+        if (left->kind != kind) {
+            auto node = std::make_unique<Expr>();
+            node->kind = kind;
+            node->children.push_back(std::move(left));
+            left = std::move(node);
+        }
+        left->children.push_back(std::move(right));
+        return left;
+    }
+
+    ExprPtr notExpr() {
+        if (isKeyword("NOT")) {
+            advance();
+            ExprPtr child = notExpr();
+            if (!child) return nullptr;
+            auto node = std::make_unique<Expr>();
+            node->kind = ExprKind::Not;
+            node->children.push_back(std::move(child));
+            return node;
+        }
+        return primary();
+    }
+
+    ExprPtr primary() {
+        if (current().type == TokenType::LParen) {
+            advance();
+            ExprPtr inner = orExpr();
+            if (!inner) return nullptr;
+            if (current().type != TokenType::RParen) {
+                error("Missing ')' in WHERE clause");
+                return nullptr;
+            }
+            advance();
+            return inner;
+        }
+        if (current().type != TokenType::Word || atClauseEnd()) {
+            error("Expected a column name in WHERE clause");
+            return nullptr;
+        }
+        auto node = std::make_unique<Expr>();
+        node->column = current().text;
+        advance();
+
+        if (isKeyword("NOT")) {
+            node->negated = true;
+            advance();
+            if (!isKeyword("IN") && !isKeyword("LIKE")) {
+                error("Expected IN or LIKE after NOT");
+                return nullptr;
+            }
+        }
+        if (isKeyword("IN")) {
+            node->kind = ExprKind::In;
+            advance();
+            if (current().type != TokenType::LParen) {
+                error("Expected '(' after IN");
+                return nullptr;
+            }
+            advance();
+            while (true) {
+                node->values.emplace_back();
+                if (!literal(*node, node->values.size() - 1)) return nullptr;
+                if (current().type == TokenType::Comma) {
+                    advance();
+                    continue;
+                }
+                if (current().type != TokenType::RParen) {
+                    error("Expected ',' or ')' in IN list");
+                    return nullptr;
+                }
+                advance();
+                return node;
+            }
+        }
+        if (isKeyword("LIKE")) {
+            node->kind = ExprKind::Like;
+            advance();
+            node->values.resize(1);
+            if (!literal(*node, 0)) return nullptr;
+            return node;
+        }
+        if (isKeyword("BETWEEN")) {
+            node->op = CompareOp::Between;
+            advance();
+            node->values.resize(2);
+            if (!literal(*node, 0)) return nullptr;
+            if (!isKeyword("AND")) {
+                error("Expected AND in BETWEEN");
+                return nullptr;
+            }
+            advance();
+            if (!literal(*node, 1)) return nullptr;
+            return node;
+        }
+        if (current().type == TokenType::Op) {
+            if (!parseCompareOp(current().text, node->op)) {
+                error("Unknown operator '" + current().text + "' in WHERE clause");
+                return nullptr;
+            }
+            advance();
+        }
+        // Without an operator this is the legacy "column value" equality
+        node->values.resize(1);
+        if (!literal(*node, 0)) return nullptr;
+        return node;
+    }
+
+public:
+    explicit Parser(Lexer& lexer) : lexer(lexer) {}
+
+    ExprPtr parse() {
+        ExprPtr expr = orExpr();
+        if (expr && !atClauseEnd()) {
+            error("Unexpected '" + current().text + "' in WHERE clause");
+        }
+        if (failed) return nullptr;
+        return expr;
+    }
+};
+
+std::string quote(const std::string& value) {
+    std::string out = "'";
+    for (char c : value) {
+        out += c;
+        if (c == '\'') out += '\'';
+    }
+    return out + "'";
+}
+
+} // namespace
+
+ExprPtr parseWhere(Lexer& lexer) {
+    Parser parser(lexer);
+    return parser.parse();
+}
+
+ExprPtr parseWhere(const std::string& text, size_t& pos) {
+    Lexer lexer(text, pos);
+    ExprPtr expr = parseWhere(lexer);
+    const Token& next = lexer.peek();
+    pos = next.type == TokenType::End ? next.end : next.start;
+    return expr;
+}
+
+ExprPtr parseWhere(const std::string& text) {
+    size_t pos = 0;
+    ExprPtr expr = parseWhere(text, pos);
+    if (expr && text.find_first_not_of(" \t\r\n", pos) != std::string::npos) {
+        errorStream() << "Error: Unexpected text after WHERE clause.\n";
+        return nullptr;
+    }
+    return expr;
+}
+
+std::string exprToString(const Expr& expr, const std::vector<std::string>& params) {
+    // Value i as text: numbers as they are, the rest quoted, with a parameter
+    // filled in if there is one for it
+    auto literal = [](const std::string& text) { return isNumericLiteral(text) ? text : quote(text); };
+    auto value = [&](size_t i) -> std::string {
+        int param = i < expr.params.size() ? expr.params[i] : -1;
+        if (param < 0) return literal(expr.values[i]);
+        return static_cast<size_t>(param) < params.size() ? literal(params[param]) : "?";
+    };
+    switch (expr.kind) {
+        case ExprKind::And:
+        case ExprKind::Or: {
+            std::string out = "(";
+            for (size_t i = 0; i < expr.children.size(); ++i) {
+                if (i > 0) out += expr.kind == ExprKind::And ? " AND " : " OR ";
+                out += exprToString(*expr.children[i], params);
+            }
+            return out + ")";
+        }
+        case ExprKind::Not:
+            return "NOT " + exprToString(*expr.children[0], params);
+        case ExprKind::Compare:
+            if (expr.op == CompareOp::Between) {
+                return expr.column + " BETWEEN " + value(0) + " AND " + value(1);
+            }
+            return expr.column + " " + compareOpName(expr.op) + " " + value(0);
+        case ExprKind::In: {
+            std::string out = expr.column + (expr.negated ? " NOT IN (" : " IN (");
+            for (size_t i = 0; i < expr.values.size(); ++i) {
+                if (i > 0) out += ", ";
+                out += value(i);
+            }
+            return out + ")";
+        }
+        case ExprKind::Like:
+            return expr.column + (expr.negated ? " NOT LIKE " : " LIKE ") + value(0);
+    }
+    return "";
+}
+
+ExprPtr makeComparison(const std::string& column, CompareOp op, const std::string& value, const std::string& value2) {
+    auto expr = std::make_unique<Expr>();
+    expr->column = column;
+    expr->op = op;
+    expr->values.push_back(value);
+    if (op == CompareOp::Between) expr->values.push_back(value2);
+    return expr;
+}
@@ -0,0 +1,53 @@
+// Expression.hpp
+#ifndef EXPRESSION_HPP
+#define EXPRESSION_HPP
+
+#include "Condition.hpp"
+#include "Lexer.hpp"
+#include <memory>
+#include <string>
+#include <vector>
+
+enum class ExprKind : uint8_t {
+    And,
+    Or,
+    Not,
+    Compare, // column op value, or column BETWEEN value AND value
+    In,      // column [NOT] IN (value, ...)
+    Like     // column [NOT] LIKE pattern, with % and _ wildcards
+};
+
+// A WHERE clause as parsed: AND/OR/NOT over single-column predicates. Values
+// are the literals as written (unquoted); Predicate binds them to a schema.
+struct Expr {
+    ExprKind kind = ExprKind::Compare;
+    std::vector<std::unique_ptr<Expr>> children; // And/Or: two or more, Not: one
+    std::string column;
+    CompareOp op = CompareOp::Eq;
+    std::vector<std::string> values; // Compare: one (two for BETWEEN), In: the list, Like: the pattern
+    bool negated = false;            // NOT IN, NOT LIKE
+    // Parallel to values when the clause has ? placeholders: the parameter
+    // each value stands for, or -1 for a literal
+    std::vector<int> params;
+};
+
+using ExprPtr = std::unique_ptr<Expr>;
+
+// Parse a WHERE clause starting at text[pos]. Parsing stops at the end of the
+// text, after a ';', or before a clause keyword (ORDER, GROUP, LIMIT, OFFSET),
+// leaving pos there. Reports the problem and returns nullptr on a syntax error.
+// Besides the SQL forms, the legacy "column value" means column = value.
+ExprPtr parseWhere(const std::string& text, size_t& pos);
+// The same from the lexer's current token, leaving it at the token after the clause
+ExprPtr parseWhere(Lexer& lexer);
+// Parse a whole string as a WHERE clause
+ExprPtr parseWhere(const std::string& text);
+
+// Text that parseWhere() reads back as the same expression, with ? parameters
+// replaced by the given values (left as ? if there are none)
+std::string exprToString(const Expr& expr, const std::vector<std::string>& params = {});
+
+ExprPtr makeComparison(const std::string& column, CompareOp op, const std::string& value,
+                       const std::string& value2 = "");
+
+#endif // EXPRESSION_HPP
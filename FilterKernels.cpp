@@ -0,0 +1,288 @@
+// FilterKernels.cpp
+#include "FilterKernels.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <type_traits>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define MINIDB_X86_KERNELS 1
+#include <immintrin.h>
+#endif
+
+// Every comparison is turned into lo <= value <= hi, inverted for !=, so one
+// kernel per type and instruction set covers all of them
+template <typename T>
+struct Range {
+    T lo;
+    T hi;
+    bool empty = false;
+    bool invert = false;
+};
+
+template <typename T>
+static T above(T value, bool& overflow) {
+    if constexpr (std::is_floating_point<T>::value) {
+        return std::nextafter(value, std::numeric_limits<T>::infinity());
+    } else {
+        overflow = value == std::numeric_limits<T>::max();
+        return overflow ? value : value + 1;
+    }
+}
+
+template <typename T>
+static T below(T value, bool& overflow) {
+    if constexpr (std::is_floating_point<T>::value) {
+        return std::nextafter(value, -std::numeric_limits<T>::infinity());
+    } else {
+        overflow = value == std::numeric_limits<T>::lowest();
+        return overflow ? value : value - 1;
+    }
+}
+
+template <typename T>
+static Range<T> toRange(const Condition& cond) {
+    // Stored doubles are finite, so the infinities bound every value
+    const T min = std::is_floating_point<T>::value ? -std::numeric_limits<T>::infinity() : std::numeric_limits<T>::lowest();
+    const T max = std::is_floating_point<T>::value ? std::numeric_limits<T>::infinity() : std::numeric_limits<T>::max();
+    T value = loadValue<T>(cond.value);
+    Range<T> range{min, max};
+    switch (cond.op) {
+        case CompareOp::Ne: range.invert = true; // fall through
+        case CompareOp::Eq: range.lo = range.hi = value; break;
+        case CompareOp::Lt: range.hi = below(value, range.empty); break;
+        case CompareOp::Le: range.hi = value; break;
+        case CompareOp::Gt: range.lo = above(value, range.empty); break;
+        case CompareOp::Ge: range.lo = value; break;
+        case CompareOp::Between:
+            range.lo = value;
+            range.hi = loadValue<T>(cond.value2);
+            break;
+    }
+    if (range.lo > range.hi) range.empty = true;
+    return range;
+}
+
+// Finish a bitmap: apply the inversion and clear bits past count
+static void finishBitmap(uint64_t* bits, size_t count, bool invert) {
+    size_t words = bitmapWords(count);
+    if (invert) {
+        for (size_t w = 0; w < words; ++w) bits[w] = ~bits[w];
+    }
+    if (count % 64 != 0) bits[words - 1] &= (uint64_t(1) << (count % 64)) - 1;
+}
+
+// Scalar kernel, also used for the values after the last full vector block
+template <typename T>
+static void rangeScalar(const char* values, size_t begin, size_t count, T lo, T hi, uint64_t* bits) {
+    for (size_t i = begin; i < count; ++i) {
+        T value;
+        std::memcpy(&value, values + i * sizeof(T), sizeof(T));
+        if (lo <= value && value <= hi) bits[i / 64] |= uint64_t(1) << (i % 64);
+    }
+}
+
+#ifdef MINIDB_X86_KERNELS
+
+// Each kernel builds whole 64-bit words from vector compare masks and leaves
+// the rest of the values to the scalar loop
+
+__attribute__((target("avx2")))
+static size_t rangeAvx2(const int32_t* values, size_t count, int32_t lo, int32_t hi, uint64_t* bits) {
+    const __m256i vlo = _mm256_set1_epi32(lo), vhi = _mm256_set1_epi32(hi);
+    size_t i = 0;
+    for (; i + 64 <= count; i += 64) {
+        uint64_t word = 0;
+        for (int k = 0; k < 8; ++k) {
+            __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(values + i + k * 8));
+            __m256i out = _mm256_or_si256(_mm256_cmpgt_epi32(vlo, v), _mm256_cmpgt_epi32(v, vhi));
+            uint64_t in = ~static_cast<unsigned>(_mm256_movemask_ps(_mm256_castsi256_ps(out))) & 0xFFu;
+            word |= in << (k * 8);
+        }
+        bits[i / 64] = word;
+    }
+    return i;
+}
+
+__attribute__((target("avx2")))
+static size_t rangeAvx2(const int64_t* values, size_t count, int64_t lo, int64_t hi, uint64_t* bits) {
+    const __m256i vlo = _mm256_set1_epi64x(lo), vhi = _mm256_set1_epi64x(hi);
+    size_t i = 0;
+    for (; i + 64 <= count; i += 64) {
+        uint64_t word = 0;
+        for (int k = 0; k < 16; ++k) {
+            __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(values + i + k * 4));
+            __m256i out = _mm256_or_si256(_mm256_cmpgt_epi64(vlo, v), _mm256_cmpgt_epi64(v, vhi));
+            uint64_t in = ~static_cast<unsigned>(_mm256_movemask_pd(_mm256_castsi256_pd(out))) & 0xFu;
+            word |= in << (k * 4);
+        }
+        bits[i / 64] = word;
+    }
+    return i;
+}
+
+__attribute__((target("avx2")))
+static size_t rangeAvx2(const double* values, size_t count, double lo, double hi, uint64_t* bits) {
+    const __m256d vlo = _mm256_set1_pd(lo), vhi = _mm256_set1_pd(hi);
+    size_t i = 0;
+    for (; i + 64 <= count; i += 64) {
+        uint64_t word = 0;
+        for (int k = 0; k < 16; ++k) {
+            __m256d v = _mm256_loadu_pd(values + i + k * 4);
+            __m256d in = _mm256_and_pd(_mm256_cmp_pd(v, vlo, _CMP_GE_OQ), _mm256_cmp_pd(v, vhi, _CMP_LE_OQ));
+            word |= static_cast<uint64_t>(_mm256_movemask_pd(in)) << (k * 4);
+        }
+        bits[i / 64] = word;
+    }
+    return i;
+}
+
+__attribute__((target("sse4.2")))
+static size_t rangeSse42(const int32_t* values, size_t count, int32_t lo, int32_t hi, uint64_t* bits) {
+    const __m128i vlo = _mm_set1_epi32(lo), vhi = _mm_set1_epi32(hi);
+    size_t i = 0;
+    for (; i + 64 <= count; i += 64) {
+        uint64_t word = 0;
+        for (int k = 0; k < 16; ++k) {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(values + i + k * 4));
+            __m128i out = _mm_or_si128(_mm_cmpgt_epi32(vlo, v), _mm_cmpgt_epi32(v, vhi));
+            uint64_t in = ~static_cast<unsigned>(_mm_movemask_ps(_mm_castsi128_ps(out))) & 0xFu;
+            word |= in << (k * 4);
+        }
+        bits[i / 64] = word;
+    }
+    return i;
+}
+
+__attribute__((target("sse4.2")))
+static size_t rangeSse42(const int64_t* values, size_t count, int64_t lo, int64_t hi, uint64_t* bits) {
+    // pcmpgtq is the SSE4.2 instruction this level exists for
+    const __m128i vlo = _mm_set1_epi64x(lo), vhi = _mm_set1_epi64x(hi);
+    size_t i = 0;
+    for (; i + 64 <= count; i += 64) {
+        uint64_t word = 0;
+        for (int k = 0; k < 32; ++k) {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(values + i + k * 2));
+            __m128i out = _mm_or_si128(_mm_cmpgt_epi64(vlo, v), _mm_cmpgt_epi64(v, vhi));
+            uint64_t in = ~static_cast<unsigned>(_mm_movemask_pd(_mm_castsi128_pd(out))) & 0x3u;
+            word |= in << (k * 2);
+        }
+        bits[i / 64] = word;
+    }
+    return i;
+}
+
+__attribute__((target("sse4.2")))
+static size_t rangeSse42(const double* values, size_t count, double lo, double hi, uint64_t* bits) {
+    const __m128d vlo = _mm_set1_pd(lo), vhi = _mm_set1_pd(hi);
+    size_t i = 0;
+    for (; i + 64 <= count; i += 64) {
+        uint64_t word = 0;
+        for (int k = 0; k < 32; ++k) {
+            __m128d v = _mm_loadu_pd(values + i + k * 2);
+            __m128d in = _mm_and_pd(_mm_cmpge_pd(v, vlo), _mm_cmple_pd(v, vhi));
+            word |= static_cast<uint64_t>(_mm_movemask_pd(in)) << (k * 2);
+        }
+        bits[i / 64] = word;
+    }
+    return i;
+}
+
+#endif // MINIDB_X86_KERNELS
+
+SimdLevel detectSimdLevel() {
+#ifdef MINIDB_X86_KERNELS
+    static const SimdLevel detected = []() {
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2")) return SimdLevel::Avx2;
+        if (__builtin_cpu_supports("sse4.2")) return SimdLevel::Sse42;
+        return SimdLevel::Scalar;
+    }();
+    return detected;
+#else
+    return SimdLevel::Scalar;
+#endif
+}
+
+static std::atomic<SimdLevel>& currentLevel() {
+    static std::atomic<SimdLevel> level([]() {
+        SimdLevel cap = SimdLevel::Avx2;
+        if (const char* env = std::getenv("MINIDB_SIMD")) {
+            std::string name = env;
+            if (name == "scalar") cap = SimdLevel::Scalar;
+            else if (name == "sse4.2") cap = SimdLevel::Sse42;
+        }
+        return std::min(cap, detectSimdLevel());
+    }());
+    return level;
+}
+
+SimdLevel simdLevel() {
+    return currentLevel().load(std::memory_order_relaxed);
+}
+
+void setSimdLevel(SimdLevel level) {
+    currentLevel().store(std::min(level, detectSimdLevel()), std::memory_order_relaxed);
+}
+
+const char* simdLevelName(SimdLevel level) {
+    switch (level) {
+        case SimdLevel::Scalar: return "scalar";
+        case SimdLevel::Sse42: return "sse4.2";
+        case SimdLevel::Avx2: return "avx2";
+    }
+    return "scalar";
+}
+
+bool hasFilterKernel(ColumnType type) {
+    return type == ColumnType::Int || type == ColumnType::BigInt || type == ColumnType::Double;
+}
+
+template <typename T>
+static void filterTyped(const Condition& cond, const char* values, size_t count, uint64_t* bits) {
+    std::memset(bits, 0, bitmapWords(count) * sizeof(uint64_t));
+    Range<T> range = toRange<T>(cond);
+    if (!range.empty) {
+        size_t done = 0;
+#ifdef MINIDB_X86_KERNELS
+        // Column buffers hold native values back to back, so they can be read as an array
+        const T* typed = reinterpret_cast<const T*>(values);
+        switch (simdLevel()) {
+            case SimdLevel::Avx2: done = rangeAvx2(typed, count, range.lo, range.hi, bits); break;
+            case SimdLevel::Sse42: done = rangeSse42(typed, count, range.lo, range.hi, bits); break;
+            case SimdLevel::Scalar: break;
+        }
+#endif
+        rangeScalar<T>(values, done, count, range.lo, range.hi, bits);
+    }
+    finishBitmap(bits, count, range.invert);
+}
+
+void filterFixed(const Condition& cond, const char* values, size_t count, uint64_t* bits) {
+    if (count == 0) return;
+    switch (cond.type) {
+        case ColumnType::Int: filterTyped<int32_t>(cond, values, count, bits); break;
+        case ColumnType::BigInt: filterTyped<int64_t>(cond, values, count, bits); break;
+        case ColumnType::Double: filterTyped<double>(cond, values, count, bits); break;
+        default: break;
+    }
+}
+
+void appendSelectedRows(const uint64_t* bits, size_t count, size_t first_row, std::vector<size_t>& rows) {
+    for (size_t w = 0; w < bitmapWords(count); ++w) {
+        // Visit set bits only, lowest first
+        for (uint64_t word = bits[w]; word != 0; word &= word - 1) {
+#ifdef __GNUC__
+            size_t bit = static_cast<size_t>(__builtin_ctzll(word));
+#else
+            size_t bit = 0;
+            while (!(word >> bit & 1)) bit++;
+#endif
+            rows.push_back(first_row + w * 64 + bit);
+        }
+    }
+}
@@ -0,0 +1,39 @@
+// FilterKernels.hpp
+#ifndef FILTER_KERNELS_HPP
+#define FILTER_KERNELS_HPP
+
+#include "Condition.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Instruction sets the filter kernels can use, in increasing order
+enum class SimdLevel {
+    Scalar = 0,
+    Sse42 = 1,
+    Avx2 = 2
+};
+
+// Best level this CPU supports
+SimdLevel detectSimdLevel();
+// Level the kernels run at: the detected one, capped by MINIDB_SIMD
+// (scalar, sse4.2 or avx2) when that is set
+SimdLevel simdLevel();
+// Change the level, e.g. to compare them; capped at detectSimdLevel()
+void setSimdLevel(SimdLevel level);
+const char* simdLevelName(SimdLevel level);
+
+// True for the column types filterFixed() handles: INT, BIGINT and DOUBLE
+bool hasFilterKernel(ColumnType type);
+
+// Selection bitmap of count fixed-width values of cond.type stored back to
+// back: bit i of bits (64 per word) is set when value i satisfies cond. Bits
+// past count in the last word are cleared.
+void filterFixed(const Condition& cond, const char* values, size_t count, uint64_t* bits);
+
+inline size_t bitmapWords(size_t count) { return (count + 63) / 64; }
+
+// Append first_row + i for every set bit i of a bitmap over count rows
+void appendSelectedRows(const uint64_t* bits, size_t count, size_t first_row, std::vector<size_t>& rows);
+
+#endif // FILTER_KERNELS_HPP
@@ -0,0 +1,52 @@
+// HashIndex.cpp
+#include "HashIndex.hpp"
+#include <algorithm>
+#include <cstdint>
+
+void HashIndex::build(size_t row_count, const std::function<std::string_view(size_t)>& key_of) {
+    postings.clear();
+    postings.reserve(row_count);
+    for (size_t row = 0; row < row_count; ++row) {
+        postings[std::string(key_of(row))].push_back(row);
+    }
+    built = true;
+}
+
+void HashIndex::insert(std::string_view key, size_t row) {
+    std::vector<size_t>& rows = postings[std::string(key)];
+    if (rows.empty() || rows.back() < row) {
+        rows.push_back(row); // appends, the common case
+    } else {
+        rows.insert(std::lower_bound(rows.begin(), rows.end(), row), row);
+    }
+}
+
+void HashIndex::erase(std::string_view key, size_t row) {
+    auto it = postings.find(std::string(key));
+    if (it == postings.end()) return;
+    std::vector<size_t>& rows = it->second;
+    auto pos = std::lower_bound(rows.begin(), rows.end(), row);
+    if (pos != rows.end() && *pos == row) {
+        rows.erase(pos);
+    }
+    if (rows.empty()) {
+        postings.erase(it);
+    }
+}
+
+void HashIndex::remap(const std::vector<size_t>& new_ids) {
+    for (auto it = postings.begin(); it != postings.end();) {
+        std::vector<size_t>& rows = it->second;
+        size_t kept = 0;
+        for (size_t row : rows) {
+            if (new_ids[row] != SIZE_MAX) rows[kept++] = new_ids[row];
+        }
+        rows.resize(kept);
+        it = rows.empty() ? postings.erase(it) : std::next(it);
+    }
+}
+
+std::vector<size_t> HashIndex::lookup(const std::string& key) const {
+    auto it = postings.find(key);
+    return it == postings.end() ? std::vector<size_t>() : it->second;
+}
@@ -0,0 +1,27 @@
+// HashIndex.hpp
+#ifndef HASH_INDEX_HPP
+#define HASH_INDEX_HPP
+
+#include "Index.hpp"
+#include <unordered_map>
+
+// Equality index: value -> ids of the rows holding it, kept in ascending
+// order so lookups return rows in the same order as a scan.
+class HashIndex : public Index {
+private:
+    std::unordered_map<std::string, std::vector<size_t>> postings;
+
+public:
+    HashIndex(const std::string& name, int column) : Index(name, column) {}
+
+    IndexKind kind() const override { return IndexKind::Hash; }
+    std::unique_ptr<Index> clone() const override { return std::make_unique<HashIndex>(*this); }
+
+    void build(size_t row_count, const std::function<std::string_view(size_t)>& key_of) override;
+    void insert(std::string_view key, size_t row) override;
+    void erase(std::string_view key, size_t row) override;
+    void remap(const std::vector<size_t>& new_ids) override;
+    std::vector<size_t> lookup(const std::string& key) const override;
+};
+
+#endif // HASH_INDEX_HPP
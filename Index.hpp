@@ -0,0 +1,48 @@
+// Index.hpp
+#ifndef INDEX_HPP
+#define INDEX_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+enum class IndexKind : uint8_t {
+    Hash = 0,
+    BTree = 1
+};
+
+// Secondary index on one column of a table, mapping values to row ids.
+// Indexes are filled on first use, so opening a table never scans it.
+class Index {
+protected:
+    std::string name;
+    int column;
+    std::atomic<bool> built{false}; // read without the table's lazy_mutex
+
+public:
+    Index(const std::string& name, int column) : name(name), column(column) {}
+    Index(const Index& other) : name(other.name), column(other.column), built(other.isBuilt()) {}
+    virtual ~Index() = default;
+
+    const std::string& getName() const { return name; }
+    int getColumn() const { return column; }
+    bool isBuilt() const { return built; }
+
+    virtual IndexKind kind() const = 0;
+    virtual std::unique_ptr<Index> clone() const = 0;
+
+    virtual void build(size_t row_count, const std::function<std::string_view(size_t)>& key_of) = 0;
+    virtual void insert(std::string_view key, size_t row) = 0;
+    virtual void erase(std::string_view key, size_t row) = 0;
+    // Renumber after rows were removed; new_ids[old] is the new id or SIZE_MAX if deleted
+    virtual void remap(const std::vector<size_t>& new_ids) = 0;
+    // Ascending ids of the rows holding key
+    virtual std::vector<size_t> lookup(const std::string& key) const = 0;
+};
+
+#endif // INDEX_HPP
@@ -0,0 +1,35 @@
+// Latch.cpp
+#include "Latch.hpp"
+
+void Latch::lock() {
+    std::unique_lock<std::mutex> lock(mutex);
+    ++waiting_writers;
+    writer_ready.wait(lock, [this]() { return !writer && readers == 0; });
+    --waiting_writers;
+    writer = true;
+}
+
+void Latch::unlock() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        writer = false;
+    }
+    // The next writer goes first; readers wake to wait again if one does
+    writer_ready.notify_one();
+    readers_ready.notify_all();
+}
+
+void Latch::lock_shared() {
+    std::unique_lock<std::mutex> lock(mutex);
+    readers_ready.wait(lock, [this]() { return !writer && waiting_writers == 0; });
+    ++readers;
+}
+
+void Latch::unlock_shared() {
+    bool last;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        last = --readers == 0;
+    }
+    if (last) writer_ready.notify_one();
+}
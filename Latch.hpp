@@ -0,0 +1,35 @@
+// Latch.hpp
+#ifndef LATCH_HPP
+#define LATCH_HPP
+
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+
+// Reader/writer latch held for a whole statement: readers share it, a writer
+// holds it alone. Once a writer waits, new readers queue behind it, so a
+// steady stream of SELECTs cannot starve an INSERT (std::shared_mutex on Linux
+// lets readers overtake). A SELECT holds it only while its operators run and
+// its rows are copied into the cursor, never while the client reads them. Not
+// recursive: a thread holding it must not take it again. Works with std::unique_lock and std::shared_lock.
+class Latch {
+private:
+    std::mutex mutex;
+    std::condition_variable readers_ready;
+    std::condition_variable writer_ready;
+    size_t readers = 0;         // holding it shared
+    size_t waiting_writers = 0;
+    bool writer = false;        // holding it alone
+
+public:
+    Latch() = default;
+    Latch(const Latch&) = delete;
+    Latch& operator=(const Latch&) = delete;
+
+    void lock();
+    void unlock();
+    void lock_shared();
+    void unlock_shared();
+};
+
+#endif // LATCH_HPP
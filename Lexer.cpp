@@ -0,0 +1,84 @@
+// Lexer.cpp
+#include "Lexer.hpp"
+#include <cctype>
+#include <cstring>
+
+static bool isWordChar(char c) {
+    return !std::isspace(static_cast<unsigned char>(c)) && c != '(' && c != ')' && c != ',' && c != ';' &&
+           c != '\'' && c != '?' && c != '=' && c != '<' && c != '>' && c != '!';
+}
+
+Lexer::Lexer(const std::string& text, size_t pos) : text(text), pos(pos) {
+    advance();
+}
+
+void Lexer::advance() {
+    while (pos < text.size() && std::isspace(static_cast<unsigned char>(text[pos]))) pos++;
+    current = Token();
+    current.start = pos;
+    if (pos >= text.size()) {
+        current.end = pos;
+        return;
+    }
+    char c = text[pos];
+    if (c == ';') {
+        // Stays at the ';': everything after it is ignored
+        current.end = pos + 1;
+        return;
+    }
+    if (c == '(' || c == ')' || c == ',') {
+        current.type = c == '(' ? TokenType::LParen : c == ')' ? TokenType::RParen : TokenType::Comma;
+        current.text = c;
+        pos++;
+    } else if (c == '?') {
+        current.type = TokenType::Param;
+        current.text = c;
+        current.param = params++;
+        pos++;
+    } else if (c == '\'') {
+        // Quoted literal; '' stands for one quote
+        current.type = TokenType::String;
+        pos++;
+        while (true) {
+            if (pos >= text.size()) {
+                current.type = TokenType::Invalid;
+                break;
+            }
+            if (text[pos] == '\'') {
+                if (pos + 1 < text.size() && text[pos + 1] == '\'') {
+                    current.text += '\'';
+                    pos += 2;
+                    continue;
+                }
+                pos++;
+                break;
+            }
+            current.text += text[pos++];
+        }
+    } else if (c == '=' || c == '<' || c == '>' || c == '!') {
+        current.type = TokenType::Op;
+        current.text = c;
+        pos++;
+        if (pos < text.size() && (text[pos] == '=' || (c == '<' && text[pos] == '>'))) {
+            current.text += text[pos++];
+        }
+    } else {
+        current.type = TokenType::Word;
+        while (pos < text.size() && isWordChar(text[pos])) current.text += text[pos++];
+    }
+    current.end = pos;
+}
+
+bool Lexer::is(const char* keyword) const {
+    if (current.type != TokenType::Word || current.text.size() != std::strlen(keyword)) return false;
+    for (size_t i = 0; i < current.text.size(); ++i) {
+        if (std::toupper(static_cast<unsigned char>(current.text[i])) != keyword[i]) return false;
+    }
+    return true;
+}
+
+bool Lexer::accept(const char* keyword) {
+    if (!is(keyword)) return false;
+    advance();
+    return true;
+}
@@ -0,0 +1,53 @@
+// Lexer.hpp
+#ifndef LEXER_HPP
+#define LEXER_HPP
+
+#include <cstddef>
+#include <string>
+
+enum class TokenType {
+    Word,    // identifier, keyword or unquoted literal
+    String,  // quoted literal
+    Op,      // = != <> < <= > >=
+    LParen,
+    RParen,
+    Comma,
+    Param,   // ? placeholder of a prepared statement
+    Invalid, // unterminated string
+    End      // end of text or ';'
+};
+
+struct Token {
+    TokenType type = TokenType::End;
+    std::string text;
+    size_t start = 0; // offsets of the token in the text
+    size_t end = 0;
+    size_t param = 0; // Param: 0-based number of the placeholder in the statement
+};
+
+// Splits SQL text into tokens with one token of lookahead. A word is any run
+// of characters other than whitespace and ( ) , ; ' ? = < > !, so numbers,
+// identifiers, keywords, * and other unquoted literals are all words. A
+// quoted string uses '' for a quote inside it. ';' ends the text.
+class Lexer {
+private:
+    const std::string& text;
+    size_t pos;
+    size_t params = 0;
+    Token current;
+
+public:
+    Lexer(const std::string& text, size_t pos = 0);
+
+    const Token& peek() const { return current; }
+    void advance();
+    // Case-insensitive keyword test on the current token
+    bool is(const char* keyword) const;
+    // Advance past the keyword if it is the current token
+    bool accept(const char* keyword);
+    // ? placeholders read so far
+    size_t parameterCount() const { return params; }
+    const std::string& source() const { return text; }
+};
+
+#endif // LEXER_HPP
@@ -0,0 +1,57 @@
+// MappedFile.cpp
+#include "MappedFile.hpp"
+
+#if defined(_WIN32)
+#define MINIDB_NO_MMAP 1
+#include <fstream>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::~MappedFile() {
+#ifndef MINIDB_NO_MMAP
+    if (mapped) {
+        munmap(const_cast<char*>(bytes), length);
+        return;
+    }
+#endif
+    delete[] bytes;
+}
+
+bool MappedFile::open(const std::string& filepath) {
+#ifndef MINIDB_NO_MMAP
+    int fd = ::open(filepath.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return false;
+    }
+    length = static_cast<size_t>(st.st_size);
+    if (length > 0) {
+        void* addr = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (addr == MAP_FAILED) {
+            close(fd);
+            length = 0;
+            return false;
+        }
+        bytes = static_cast<const char*>(addr);
+        mapped = true;
+    }
+    // The mapping stays valid after close, and after the file is replaced by rename
+    close(fd);
+    return true;
+#else
+    std::ifstream ifs(filepath, std::ios::binary | std::ios::ate);
+    if (!ifs) return false;
+    length = static_cast<size_t>(ifs.tellg());
+    char* buffer = new char[length > 0 ? length : 1];
+    ifs.seekg(0);
+    ifs.read(buffer, length);
+    bytes = buffer;
+    return true;
+#endif
+}
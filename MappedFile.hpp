@@ -0,0 +1,30 @@
+// MappedFile.hpp
+#ifndef MAPPED_FILE_HPP
+#define MAPPED_FILE_HPP
+
+#include <cstddef>
+#include <string>
+
+// Read-only view of a whole file. On POSIX systems the file is mmapped, so
+// pages are only read from disk when something touches them; elsewhere it
+// falls back to reading the file into memory.
+class MappedFile {
+private:
+    const char* bytes = nullptr;
+    size_t length = 0;
+    bool mapped = false;
+
+public:
+    MappedFile() = default;
+    ~MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // Returns false (and leaves the object empty) if the file cannot be opened
+    bool open(const std::string& filepath);
+
+    const char* data() const { return bytes; }
+    size_t size() const { return length; }
+};
+
+#endif // MAPPED_FILE_HPP
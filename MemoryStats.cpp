@@ -0,0 +1,47 @@
+// MemoryStats.cpp
+#include "MemoryStats.hpp"
+#include <atomic>
+
+namespace {
+
+// One counter per thread, on its own cache line; threads beyond the slot count
+// share slots, which only costs them contention
+const size_t SLOTS = 256;
+
+struct alignas(64) Slot {
+    std::atomic<uint64_t> bytes{0};
+    std::atomic<uint64_t> calls{0};
+};
+
+Slot slots[SLOTS];
+std::atomic<size_t> next_slot{0};
+std::atomic<bool> counted{false};
+// Trivially initialized, so allocating cannot recurse into thread-local setup
+thread_local size_t slot = SIZE_MAX;
+
+} // namespace
+
+void countAllocation(std::size_t size) {
+    if (slot == SIZE_MAX) {
+        slot = next_slot.fetch_add(1, std::memory_order_relaxed) % SLOTS;
+        counted.store(true, std::memory_order_relaxed);
+    }
+    slots[slot].bytes.fetch_add(size, std::memory_order_relaxed);
+    slots[slot].calls.fetch_add(1, std::memory_order_relaxed);
+}
+
+bool allocationsCounted() {
+    return counted.load(std::memory_order_relaxed);
+}
+
+uint64_t allocatedBytes() {
+    uint64_t total = 0;
+    for (const Slot& s : slots) total += s.bytes.load(std::memory_order_relaxed);
+    return total;
+}
+
+uint64_t allocationCount() {
+    uint64_t total = 0;
+    for (const Slot& s : slots) total += s.calls.load(std::memory_order_relaxed);
+    return total;
+}
@@ -0,0 +1,21 @@
+// MemoryStats.hpp
+#ifndef MEMORY_STATS_HPP
+#define MEMORY_STATS_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+// Bytes requested from operator new so far by every thread of the process,
+// other sessions' included. Each thread counts into its own slot, so counting
+// adds no contention; the difference between two readings is what was
+// allocated in between. Only a program linked with CountingNew.cpp (minidb
+// and bench_arena), whose operator new calls countAllocation(), counts;
+// elsewhere, e.g. a program embedding libminidb.a, both stay 0.
+uint64_t allocatedBytes();
+// Calls to operator new so far, counted the same way
+uint64_t allocationCount();
+// Whether this program counts allocations at all
+bool allocationsCounted();
+void countAllocation(std::size_t size);
+
+#endif // MEMORY_STATS_HPP
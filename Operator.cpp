@@ -0,0 +1,397 @@
+// Operator.cpp
+#include "Operator.hpp"
+#include "Cursor.hpp"
+#include "MemoryStats.hpp"
+#include "Table.hpp"
+#include "ThreadPool.hpp"
+#include "Value.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <iterator>
+
+void dropHidden(const std::vector<size_t>& hidden, std::vector<size_t>& rows, size_t from) {
+    if (hidden.empty() || from == rows.size()) return;
+    auto h = std::lower_bound(hidden.begin(), hidden.end(), rows[from]);
+    if (h == hidden.end() || *h > rows.back()) return;
+    size_t kept = from;
+    for (size_t i = from; i < rows.size(); ++i) {
+        while (h != hidden.end() && *h < rows[i]) ++h;
+        if (h != hidden.end() && *h == rows[i]) continue;
+        rows[kept++] = rows[i];
+    }
+    rows.resize(kept);
+}
+
+// Split the flow's rows into morsels, in order, run work on the morsels in
+// parallel and hand the results to consume in that order
+template <typename Result>
+static void forEachMorsel(const RowFlow& flow, const std::function<Result(const std::vector<size_t>& rows)>& work,
+                          const std::function<void(Result&)>& consume) {
+    size_t count = flow.all ? flow.row_count : flow.rows.size();
+    ThreadPool::shared().parallelForOrdered<Result>(morselCount(count), [&](size_t morsel) {
+        size_t begin = morsel * MORSEL_ROWS;
+        size_t end = std::min(count, begin + MORSEL_ROWS);
+        std::vector<size_t> rows;
+        if (flow.all) {
+            rows.reserve(end - begin);
+            for (size_t r = begin; r < end; ++r) rows.push_back(r);
+            dropHidden(flow.hidden, rows, 0);
+        } else {
+            rows.assign(flow.rows.begin() + begin, flow.rows.begin() + end);
+        }
+        return work(rows);
+    }, consume);
+}
+
+// List the rows of a sequential scan, up to limit of them
+static void listRows(RowFlow& flow, size_t limit = SIZE_MAX) {
+    if (!flow.all) return;
+    flow.rows.clear();
+    flow.rows.reserve(std::min(limit, flow.size()));
+    auto h = flow.hidden.begin();
+    for (size_t r = 0; r < flow.row_count && flow.rows.size() < limit; ++r) {
+        while (h != flow.hidden.end() && *h < r) ++h;
+        if (h == flow.hidden.end() || *h != r) flow.rows.push_back(r);
+    }
+    flow.all = false;
+    flow.hidden.clear();
+}
+
+void Operator::execute(RowFlow& flow, bool profile) {
+    if (!profile) {
+        run(flow);
+        return;
+    }
+    size_t rows_in = flow.size();
+    uint64_t bytes = allocatedBytes();
+    auto start = std::chrono::steady_clock::now();
+    run(flow);
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    op_stats.seconds += elapsed.count();
+    op_stats.bytes += allocatedBytes() - bytes;
+    op_stats.rows_in += rows_in;
+    op_stats.rows_out += flow.size();
+}
+
+ScanOp::ScanOp(Table& table, const Snapshot& snapshot, Mode mode) : table(table), snapshot(snapshot), mode(mode) {}
+
+void ScanOp::useOrder(int column, bool descending, const Predicate::Term* bound, size_t limit) {
+    order_column = column;
+    this->descending = descending;
+    index_term = bound;
+    this->limit = limit;
+}
+
+std::string ScanOp::describe() const {
+    std::string text = mode == Mode::Sequential ? "Seq Scan" : mode == Mode::Index ? "Index Scan" : "Index Order Scan";
+    text += " on " + table.name;
+    int column = mode == Mode::IndexOrder ? order_column : mode == Mode::Index ? index_term->column : -1;
+    if (column >= 0) {
+        IndexKind kind = mode == Mode::IndexOrder ? IndexKind::BTree : index_kind;
+        text += std::string(" using ") + (kind == IndexKind::BTree ? "btree" : "hash") + " index " +
+                table.findIndex(column, kind)->getName() + " on " + table.columns[column];
+    }
+    if (mode == Mode::IndexOrder) {
+        if (descending) text += " DESC";
+        if (index_term) text += ", range of the WHERE";
+        if (limit != SIZE_MAX) text += ", first " + std::to_string(limit);
+    }
+    return text;
+}
+
+void ScanOp::run(RowFlow& flow) {
+    table.ensureRowIndex();
+    flow = RowFlow();
+    flow.row_count = table.rowCount();
+    flow.hidden = table.hiddenRows(snapshot);
+    if (mode == Mode::Sequential) return;
+    if (mode == Mode::Index) {
+        table.indexLookup(*index_term, index_kind, flow.rows);
+        dropHidden(flow.hidden, flow.rows, 0);
+    } else {
+        table.indexOrder(order_column, descending, index_term, flow.hidden, limit, flow.rows);
+    }
+    flow.all = false;
+    flow.hidden.clear();
+}
+
+std::string FilterOp::describe() const {
+    std::string described = "Filter: " + text;
+    if (limit != SIZE_MAX) described += ", first " + std::to_string(limit);
+    return described;
+}
+
+void FilterOp::run(RowFlow& flow) {
+    std::vector<size_t> matched;
+    // Once the rows in hand reach the limit, morsels not yet started are skipped
+    std::atomic<bool> enough{false};
+    auto consume = [&](std::vector<size_t>& part) {
+        if (matched.size() >= limit) return;
+        matched.insert(matched.end(), part.begin(), part.end());
+        if (matched.size() >= limit) enough = true;
+    };
+    if (flow.all) {
+        // Each morsel is filtered on its own thread, reading only the columns the
+        // WHERE references; concatenating in row order keeps ids ascending
+        Table::Scan scan;
+        scan.where = &where;
+        scan.hidden = std::move(flow.hidden);
+        ThreadPool::shared().parallelForOrdered<std::vector<size_t>>(morselCount(flow.row_count), [&](size_t morsel) {
+            std::vector<size_t> part;
+            if (enough.load(std::memory_order_relaxed)) return part;
+            size_t begin = morsel * MORSEL_ROWS;
+            table.filterRange(scan, begin, std::min(flow.row_count, begin + MORSEL_ROWS), part);
+            return part;
+        }, consume);
+    } else {
+        ThreadPool::shared().parallelForOrdered<std::vector<size_t>>(morselCount(flow.rows.size()), [&](size_t morsel) {
+            std::vector<size_t> part;
+            if (enough.load(std::memory_order_relaxed)) return part;
+            size_t end = std::min(flow.rows.size(), (morsel + 1) * MORSEL_ROWS);
+            for (size_t i = morsel * MORSEL_ROWS; i < end; ++i) {
+                size_t row = flow.rows[i];
+                if (where.matches([&](int col) { return table.fieldAt(row, col); })) part.push_back(row);
+            }
+            return part;
+        }, consume);
+    }
+    if (matched.size() > limit) matched.resize(limit);
+    flow.all = false;
+    flow.hidden.clear();
+    flow.rows = std::move(matched);
+}
+
+std::string AggregateOp::describe() const {
+    std::string text = "Hash Aggregate by ";
+    for (size_t i = 0; i < group_by.size(); ++i) text += (i ? ", " : "") + table.columns[group_by[i]];
+    for (size_t i = 0; i < aggregates.size(); ++i) text += (i ? ", " : ": ") + aggregates[i].label();
+    return text;
+}
+
+void AggregateOp::run(RowFlow& flow) {
+    auto aggregateType = [&](size_t i) {
+        return agg_columns[i] < 0 ? ColumnType::Text : table.types[agg_columns[i]];
+    };
+    // Dictionary-encoded group columns are keyed by their codes
+    std::vector<const ColumnStore::Column*> encoded;
+    for (int idx : group_by) {
+        const ColumnStore::Column* column = table.dictionary(idx) ? &table.column_store.column(idx) : nullptr;
+        encoded.push_back(column);
+    }
+    const ColumnStore::Column* only_codes = group_by.size() == 1 ? encoded[0] : nullptr;
+    Groups total;
+    forEachMorsel<Groups>(flow, [&](const std::vector<size_t>& rows) {
+        // Partial aggregate of one morsel: running accumulators per group, never the rows
+        Groups partial;
+        std::string key;
+        // Grouped by one encoded column, a code indexes its group directly
+        std::vector<size_t> by_code(only_codes ? only_codes->dictionary.size() : 0, SIZE_MAX);
+        for (size_t row : rows) {
+            size_t id;
+            if (only_codes) {
+                size_t& slot = by_code[only_codes->code(row)];
+                if (slot == SIZE_MAX) slot = partial.rows.size();
+                id = slot;
+            } else {
+                // Values are length-prefixed and codes fixed-size, so no value can make two keys collide
+                key.clear();
+                for (size_t g = 0; g < group_by.size(); ++g) {
+                    if (encoded[g]) {
+                        uint32_t code = encoded[g]->code(row);
+                        key.append(reinterpret_cast<const char*>(&code), sizeof(code));
+                        continue;
+                    }
+                    std::string_view value = table.fieldAt(row, group_by[g]);
+                    uint32_t len = static_cast<uint32_t>(value.size());
+                    key.append(reinterpret_cast<const char*>(&len), sizeof(len));
+                    key.append(value);
+                }
+                id = partial.ids.try_emplace(key, partial.rows.size()).first->second;
+            }
+            if (id == partial.rows.size()) {
+                partial.rows.push_back(row);
+                partial.accumulators.resize(partial.accumulators.size() + aggregates.size());
+            }
+            Accumulator* acc = &partial.accumulators[id * aggregates.size()];
+            for (size_t i = 0; i < aggregates.size(); ++i) {
+                int idx = agg_columns[i];
+                acc[i].add(aggregates[i], aggregateType(i), idx < 0 ? std::string_view() : table.fieldAt(row, idx));
+            }
+        }
+        for (size_t code = 0; code < by_code.size(); ++code) {
+            if (by_code[code] == SIZE_MAX) continue;
+            uint32_t code32 = static_cast<uint32_t>(code);
+            partial.ids.emplace(std::string(reinterpret_cast<const char*>(&code32), sizeof(code32)), by_code[code]);
+        }
+        return partial;
+    }, [&](Groups& partial) {
+        // Partials arrive in row order, so each group keeps its first row in the table
+        for (auto& entry : partial.ids) {
+            auto group = total.ids.try_emplace(entry.first, total.rows.size()).first;
+            if (group->second == total.rows.size()) {
+                total.rows.push_back(partial.rows[entry.second]);
+                total.accumulators.resize(total.accumulators.size() + aggregates.size());
+            }
+            Accumulator* acc = &total.accumulators[group->second * aggregates.size()];
+            const Accumulator* part = &partial.accumulators[entry.second * aggregates.size()];
+            for (size_t i = 0; i < aggregates.size(); ++i) {
+                acc[i].merge(aggregates[i], aggregateType(i), part[i]);
+            }
+        }
+    });
+    flow.all = false;
+    flow.hidden.clear();
+    flow.rows.clear();
+    flow.grouped = true;
+    flow.groups = std::move(total);
+    flow.group_order.resize(flow.groups.rows.size());
+    for (size_t g = 0; g < flow.group_order.size(); ++g) flow.group_order[g] = g;
+}
+
+std::string SortOp::describe() const {
+    std::string text = limit == SIZE_MAX ? "Sort by " : "Top-" + std::to_string(limit) + " Sort by ";
+    for (size_t i = 0; i < order_by.size(); ++i) {
+        text += (i ? ", " : "") + table.columns[order_by[i].first] + (order_by[i].second ? " DESC" : "");
+    }
+    return text;
+}
+
+void SortOp::run(RowFlow& flow) {
+    if (flow.grouped) {
+        // Groups are listed in order of their values; with a limit only the
+        // groups up to it are put in order
+        const std::vector<size_t>& group_rows = flow.groups.rows;
+        std::vector<size_t>& group_order = flow.group_order;
+        auto group_less = [&](size_t a, size_t b) {
+            for (const auto& [idx, descending] : order_by) {
+                int c = compareValues(table.types[idx], table.fieldAt(group_rows[a], idx),
+                                      table.fieldAt(group_rows[b], idx));
+                if (c != 0) return (c < 0) != descending;
+            }
+            return a < b;
+        };
+        if (limit < group_order.size()) {
+            std::partial_sort(group_order.begin(), group_order.begin() + limit, group_order.end(), group_less);
+            group_order.resize(limit);
+        } else {
+            std::sort(group_order.begin(), group_order.end(), group_less);
+        }
+        return;
+    }
+
+    // Ties keep row order, so the output does not depend on how rows were gathered
+    auto less = [&](size_t a, size_t b) -> bool {
+        for (const auto& [idx, descending] : order_by) {
+            int c = compareValues(table.types[idx], table.fieldAt(a, idx), table.fieldAt(b, idx));
+            if (c < 0) {
+                return !descending;
+            }
+            else if (c > 0) {
+                return descending;
+            }
+        }
+        return a < b;
+    };
+    if (limit == SIZE_MAX) {
+        listRows(flow);
+        std::sort(flow.rows.begin(), flow.rows.end(), less);
+        return;
+    }
+    // Each morsel keeps only its own best limit rows, merged in as they arrive
+    std::vector<size_t> top;
+    if (limit > 0) {
+        forEachMorsel<std::vector<size_t>>(flow, [&](const std::vector<size_t>& rows) {
+            std::vector<size_t> best(rows);
+            if (best.size() > limit) {
+                std::partial_sort(best.begin(), best.begin() + limit, best.end(), less);
+                best.resize(limit);
+            } else {
+                std::sort(best.begin(), best.end(), less);
+            }
+            return best;
+        }, [&](std::vector<size_t>& best) {
+            std::vector<size_t> merged;
+            merged.reserve(std::min(limit, top.size() + best.size()));
+            std::merge(top.begin(), top.end(), best.begin(), best.end(), std::back_inserter(merged), less);
+            if (merged.size() > limit) merged.resize(limit);
+            top = std::move(merged);
+        });
+    }
+    flow.all = false;
+    flow.hidden.clear();
+    flow.rows = std::move(top);
+}
+
+std::string ProjectOp::describe() const {
+    const std::vector<int>& columns = query.group_by.empty() ? query.columns : query.group_by;
+    std::string text = "Project ";
+    for (size_t i = 0; i < columns.size(); ++i) text += (i ? ", " : "") + table.columns[columns[i]];
+    const std::vector<Aggregate>& aggregates = query.aggregates;
+    for (size_t i = 0; i < aggregates.size(); ++i) text += (i || !columns.empty() ? ", " : "") + aggregates[i].label();
+    if (query.limit != SIZE_MAX) text += " LIMIT " + std::to_string(query.limit);
+    if (query.offset != 0) text += " OFFSET " + std::to_string(query.offset);
+    return text;
+}
+
+void ProjectOp::run(RowFlow& flow) {
+    const std::vector<Aggregate>& aggregates = query.aggregates;
+    const std::vector<int>& agg_columns = query.agg_columns;
+    auto aggregateType = [&](size_t i) {
+        return agg_columns[i] < 0 ? ColumnType::Text : table.types[agg_columns[i]];
+    };
+    bool grouped = flow.grouped;
+    const std::vector<int>& columns = grouped ? query.group_by : query.columns;
+    for (int col : columns) {
+        cursor.names.push_back(table.columns[col]);
+        cursor.column_types.push_back(table.types[col]);
+        cursor.table_columns.push_back(col);
+    }
+    cursor.first_aggregate = columns.size();
+    for (size_t i = 0; i < aggregates.size(); ++i) {
+        cursor.names.push_back(aggregates[i].label());
+        cursor.column_types.push_back(aggregates[i].resultType(aggregateType(i)));
+        cursor.table_columns.push_back(-1);
+    }
+
+    // Result rows up to the end of the LIMIT window (SIZE_MAX without one)
+    size_t offset = query.offset;
+    size_t wanted = query.limit > SIZE_MAX - offset ? SIZE_MAX : offset + query.limit;
+    if (grouped) {
+        std::vector<size_t>& group_order = flow.group_order;
+        if (wanted < group_order.size()) group_order.resize(wanted);
+        group_order.erase(group_order.begin(), group_order.begin() + std::min(offset, group_order.size()));
+        return;
+    }
+
+    if (!aggregates.empty()) {
+        // Totals cover every input row, inside the window or not, and are
+        // added up per morsel in parallel
+        std::vector<Accumulator> totals(aggregates.size());
+        forEachMorsel<std::vector<Accumulator>>(flow, [&](const std::vector<size_t>& rows) {
+            std::vector<Accumulator> partial(aggregates.size());
+            for (size_t row : rows) {
+                for (size_t i = 0; i < aggregates.size(); ++i) {
+                    int idx = agg_columns[i];
+                    partial[i].add(aggregates[i], aggregateType(i),
+                                   idx < 0 ? std::string_view() : table.fieldAt(row, idx));
+                }
+            }
+            return partial;
+        }, [&](std::vector<Accumulator>& partial) {
+            for (size_t i = 0; i < aggregates.size(); ++i) {
+                totals[i].merge(aggregates[i], aggregateType(i), partial[i]);
+            }
+        });
+        for (size_t i = 0; i < aggregates.size(); ++i) {
+            cursor.total_values.emplace_back(aggregates[i].label(), totals[i].result(aggregates[i], aggregateType(i)));
+        }
+    }
+    // Without a window the cursor walks a sequential scan itself
+    if (flow.all && offset == 0 && wanted == SIZE_MAX) return;
+    listRows(flow, wanted);
+    std::vector<size_t>& rows = flow.rows;
+    if (wanted < rows.size()) rows.resize(wanted);
+    rows.erase(rows.begin(), rows.begin() + std::min(offset, rows.size()));
+}
@@ -0,0 +1,195 @@
+// Operator.hpp
+#ifndef OPERATOR_HPP
+#define OPERATOR_HPP
+
+#include "Aggregate.hpp"
+#include "Index.hpp"
+#include "Predicate.hpp"
+#include "Snapshot.hpp"
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+class Cursor;
+class Table;
+struct SelectQuery;
+
+// Rows per unit of parallel work: large enough to amortize scheduling, small
+// enough that every thread gets several on a big table
+const size_t MORSEL_ROWS = 16384;
+
+inline size_t morselCount(size_t rows) {
+    return (rows + MORSEL_ROWS - 1) / MORSEL_ROWS;
+}
+
+// Remove the ids in hidden (ascending) from rows[from...], which are ascending
+void dropHidden(const std::vector<size_t>& hidden, std::vector<size_t>& rows, size_t from);
+
+// Groups of a hash aggregation: each group's first row and aggregates.size() accumulators
+struct Groups {
+    std::unordered_map<std::string, size_t> ids; // length-prefixed group values -> group
+    std::vector<size_t> rows;
+    std::vector<Accumulator> accumulators;
+};
+
+// Rows passed from one operator of a SELECT to the next
+struct RowFlow {
+    // A sequential scan does not list its rows: they are every row below
+    // row_count except the hidden ones (ascending), until an operator needs ids
+    bool all = true;
+    size_t row_count = 0;
+    std::vector<size_t> hidden;
+    std::vector<size_t> rows; // ascending ids, or in output order after a Sort
+    // After Aggregate: groups, listed in group_order, take the place of rows
+    bool grouped = false;
+    Groups groups;
+    std::vector<size_t> group_order;
+
+    size_t size() const {
+        if (grouped) return group_order.size();
+        return all ? row_count - hidden.size() : rows.size();
+    }
+};
+
+// What one operator did in a run, for EXPLAIN ANALYZE
+struct OperatorStats {
+    double seconds = 0;
+    size_t rows_in = 0;
+    size_t rows_out = 0;
+    uint64_t bytes = 0; // allocated by any thread of the process while it ran
+};
+
+// One step of a SELECT. A query is a chain of operators run one after another,
+// each taking the rows the one before produced; most split their work into
+// morsels for the thread pool.
+class Operator {
+public:
+    virtual ~Operator() = default;
+    // One line for EXPLAIN: the operator and what it works on
+    virtual std::string describe() const = 0;
+    // Run on flow; with profile, add the time, rows and allocations to stats()
+    void execute(RowFlow& flow, bool profile);
+    const OperatorStats& stats() const { return op_stats; }
+
+protected:
+    OperatorStats op_stats;
+    virtual void run(RowFlow& flow) = 0;
+};
+
+// Produce the rows the snapshot sees: all of them (sequential), those an index
+// finds for one comparison of the WHERE, or all in the order of a B+tree on
+// the single ORDER BY column
+class ScanOp : public Operator {
+public:
+    enum class Mode { Sequential, Index, IndexOrder };
+    ScanOp(Table& table, const Snapshot& snapshot, Mode mode);
+    // Index: look up term with the index of the given kind on its column
+    void useIndex(const Predicate::Term* term, IndexKind kind) { index_term = term, index_kind = kind; }
+    // IndexOrder: walk the B+tree on column, limited to bound's range when it is
+    // set, stopping after limit rows
+    void useOrder(int column, bool descending, const Predicate::Term* bound, size_t limit);
+    std::string describe() const override;
+
+protected:
+    void run(RowFlow& flow) override;
+
+private:
+    Table& table;
+    const Snapshot& snapshot;
+    Mode mode;
+    const Predicate::Term* index_term = nullptr;
+    IndexKind index_kind = IndexKind::Hash;
+    int order_column = -1;
+    bool descending = false;
+    size_t limit = SIZE_MAX;
+};
+
+// Keep the rows that match the WHERE, in the order they came, stopping once
+// limit rows have matched. Columnar tables filter a sequential scan through
+// the SIMD kernels.
+class FilterOp : public Operator {
+public:
+    FilterOp(const Table& table, const Predicate& where, const std::string& text, size_t limit)
+        : table(table), where(where), text(text), limit(limit) {}
+    std::string describe() const override;
+
+protected:
+    void run(RowFlow& flow) override;
+
+private:
+    const Table& table;
+    const Predicate& where;
+    std::string text;
+    size_t limit;
+};
+
+// Hash aggregation: partial groups per morsel, merged in row order so each
+// group keeps its first row
+class AggregateOp : public Operator {
+public:
+    AggregateOp(const Table& table, const std::vector<int>& group_by, const std::vector<Aggregate>& aggregates,
+                const std::vector<int>& agg_columns)
+        : table(table), group_by(group_by), aggregates(aggregates), agg_columns(agg_columns) {}
+    std::string describe() const override;
+
+protected:
+    void run(RowFlow& flow) override;
+
+private:
+    const Table& table;
+    const std::vector<int>& group_by;
+    const std::vector<Aggregate>& aggregates;
+    const std::vector<int>& agg_columns;
+};
+
+// Order rows by the ORDER BY columns (ties keep row order), or groups by their
+// values. With limit, only the first limit come out: each morsel keeps its best
+// limit rows and those are merged, so the full input is never sorted.
+class SortOp : public Operator {
+public:
+    SortOp(const Table& table, std::vector<std::pair<int, bool>> order_by, size_t limit)
+        : table(table), order_by(std::move(order_by)), limit(limit) {}
+    std::string describe() const override;
+
+protected:
+    void run(RowFlow& flow) override;
+
+private:
+    const Table& table;
+    std::vector<std::pair<int, bool>> order_by; // column, descending; groups: each group column ascending
+    size_t limit;
+};
+
+// The client reading the result through a Cursor. It runs after the other
+// operators, at the client's pace, so only EXPLAIN ANALYZE measures it: by
+// reading every value of every row as text, as the REPL does.
+class OutputOp : public Operator {
+public:
+    std::string describe() const override { return "Output"; }
+    void record(const OperatorStats& stats) { op_stats = stats; }
+
+protected:
+    void run(RowFlow&) override {}
+};
+
+// Leave the cursor the rows (or groups) in the LIMIT window and describe its
+// columns. Aggregates without GROUP BY are totalled over every input row; a
+// plain sequential scan is left for the cursor to walk without listing it.
+class ProjectOp : public Operator {
+public:
+    ProjectOp(const Table& table, const SelectQuery& query, Cursor& cursor)
+        : table(table), query(query), cursor(cursor) {}
+    std::string describe() const override;
+
+protected:
+    void run(RowFlow& flow) override;
+
+private:
+    const Table& table;
+    const SelectQuery& query;
+    Cursor& cursor;
+};
+
+#endif // OPERATOR_HPP
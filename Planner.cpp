@@ -0,0 +1,62 @@
+// Planner.cpp
+#include "Planner.hpp"
+
+bool planStatement(Statement& statement, const Table& table, Plan& plan) {
+    plan = Plan();
+    plan.kind = statement.kind;
+    plan.table = statement.table;
+    plan.param_count = statement.param_count;
+    switch (statement.kind) {
+        case StatementKind::Select:
+            return table.planSelect(statement.columns, statement.aggregates, statement.where.get(),
+                                    statement.order_by, statement.group_by, statement.limit, statement.offset,
+                                    plan.select);
+        case StatementKind::Insert:
+            plan.rows = std::move(statement.rows);
+            return true;
+        case StatementKind::Update: {
+            plan.set_param = statement.value.param;
+            const std::string* value = plan.set_param < 0 ? &statement.value.text : nullptr;
+            if (!table.planUpdate(statement.column, value, statement.where.get(), plan.update)) return false;
+            plan.where_expr = std::move(statement.where);
+            return true;
+        }
+        case StatementKind::Delete:
+            if (!table.compileWhere(statement.where.get(), plan.where)) return false;
+            plan.where_expr = std::move(statement.where);
+            return true;
+        default:
+            return false;
+    }
+}
+
+bool bindParameters(Plan& plan, const Table& table, const std::vector<std::string>& params) {
+    if (plan.param_count == 0) return true;
+    const std::vector<std::string>& columns = table.getColumns();
+    const std::vector<ColumnType>& types = table.getTypes();
+    switch (plan.kind) {
+        case StatementKind::Select:
+            return plan.select.where.bind(params, columns, types);
+        case StatementKind::Update:
+            if (plan.set_param >= 0 && !table.encodeField(plan.update.column, params[plan.set_param], plan.update.value)) {
+                return false;
+            }
+            return plan.update.where.bind(params, columns, types);
+        case StatementKind::Delete:
+            return plan.where.bind(params, columns, types);
+        default:
+            return true; // INSERT values are converted by Table::insertRows()
+    }
+}
+
+std::vector<std::vector<std::string>> planRows(const Plan& plan, const std::vector<std::string>& params) {
+    std::vector<std::vector<std::string>> rows;
+    rows.reserve(plan.rows.size());
+    for (const auto& literals : plan.rows) {
+        std::vector<std::string> row;
+        row.reserve(literals.size());
+        for (const Literal& literal : literals) row.push_back(literal.param < 0 ? literal.text : params[literal.param]);
+        rows.push_back(std::move(row));
+    }
+    return rows;
+}
@@ -0,0 +1,34 @@
+// Planner.hpp
+#ifndef PLANNER_HPP
+#define PLANNER_HPP
+
+#include "Statement.hpp"
+#include "Table.hpp"
+#include <string>
+#include <vector>
+
+// A SELECT, INSERT, UPDATE or DELETE resolved against its table's schema:
+// column names are positions and the WHERE is compiled. A prepared statement
+// keeps its plan, so each EXECUTE only converts its parameters before running.
+struct Plan {
+    StatementKind kind = StatementKind::Select;
+    std::string table;
+    size_t param_count = 0;
+    SelectQuery select; // Select
+    UpdateQuery update; // Update
+    Predicate where;    // Delete
+    int set_param = -1; // Update: parameter holding the SET value, -1 for a literal
+    ExprPtr where_expr; // Update, Delete: logged as text with the parameters filled in
+    std::vector<std::vector<Literal>> rows; // Insert: converted as the rows are inserted
+};
+
+// Plan statement against table's schema, taking over its WHERE clause; reports
+// an unknown column or an invalid literal and returns false
+bool planStatement(Statement& statement, const Table& table, Plan& plan);
+// Convert the parameters of plan for the columns they are compared with or
+// assigned to; reports a value that is not valid for its column
+bool bindParameters(Plan& plan, const Table& table, const std::vector<std::string>& params);
+// The rows of an Insert plan with its parameters filled in
+std::vector<std::vector<std::string>> planRows(const Plan& plan, const std::vector<std::string>& params);
+
+#endif // PLANNER_HPP
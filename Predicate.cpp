@@ -0,0 +1,431 @@
+// Predicate.cpp
+#include "Predicate.hpp"
+#include "Diagnostics.hpp"
+#include "FilterKernels.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+LikePattern::LikePattern(const std::string& text) : pattern(text) {
+    if (text.find('_') != std::string::npos) return;
+    size_t first = text.find('%');
+    if (first == std::string::npos) {
+        shape = Shape::Exact;
+        return;
+    }
+    size_t last = text.find_last_not_of('%');
+    if (last == std::string::npos) {
+        // Only wildcards: matches everything
+        shape = Shape::Prefix;
+        pattern.clear();
+        return;
+    }
+    size_t begin = text.find_first_not_of('%');
+    std::string middle = text.substr(begin, last + 1 - begin);
+    if (middle.find('%') != std::string::npos) return;
+    bool leading = begin > 0, trailing = last + 1 < text.size();
+    pattern = middle;
+    shape = leading && trailing ? Shape::Contains : leading ? Shape::Suffix : Shape::Prefix;
+}
+
+bool LikePattern::matches(std::string_view text) const {
+    switch (shape) {
+        case Shape::Exact:
+            return text == pattern;
+        case Shape::Prefix:
+            return text.substr(0, pattern.size()) == pattern;
+        case Shape::Suffix:
+            return text.size() >= pattern.size() && text.substr(text.size() - pattern.size()) == pattern;
+        case Shape::Contains:
+            return text.find(pattern) != std::string_view::npos;
+        case Shape::General:
+            break;
+    }
+    // Greedy match that backtracks only to the most recent %
+    size_t t = 0, p = 0, star = std::string::npos, resume = 0;
+    while (t < text.size()) {
+        if (p < pattern.size() && (pattern[p] == '_' || pattern[p] == text[t])) {
+            t++;
+            p++;
+        } else if (p < pattern.size() && pattern[p] == '%') {
+            star = p++;
+            resume = t;
+        } else if (star != std::string::npos) {
+            p = star + 1;
+            t = ++resume;
+        } else {
+            return false;
+        }
+    }
+    while (p < pattern.size() && pattern[p] == '%') p++;
+    return p == pattern.size();
+}
+
+// How a number that is no value of an integer column becomes one
+enum class Rounding { Exact, Down, Up };
+
+// Rows above a bound rounded down, or below one rounded up, are the same rows:
+// id > 1.5 is id > 1 and id < 1.5 is id < 2
+static Rounding roundingFor(CompareOp op, size_t item) {
+    switch (op) {
+        case CompareOp::Gt:
+        case CompareOp::Le: return Rounding::Down;
+        case CompareOp::Ge:
+        case CompareOp::Lt: return Rounding::Up;
+        case CompareOp::Between: return item == 0 ? Rounding::Up : Rounding::Down;
+        case CompareOp::Eq:
+        case CompareOp::Ne: break;
+    }
+    return Rounding::Exact;
+}
+
+static void integerRange(ColumnType type, long double& low, long double& high) {
+    if (type == ColumnType::Int) {
+        low = INT32_MIN;
+        high = INT32_MAX;
+    } else {
+        low = INT64_MIN;
+        high = INT64_MAX;
+    }
+}
+
+static std::string storeInteger(ColumnType type, long double value) {
+    std::string out;
+    encodeValue(type, std::to_string(static_cast<long long>(value)), out);
+    return out;
+}
+
+// Literal in the column's stored form. An INT or BIGINT column also takes any
+// finite number: rounded as asked, with side set to where it fell (see
+// Term::sides) and out left empty unless it is a value of the type.
+static bool encodeLiteral(const std::string& column, ColumnType type, const std::string& text, Rounding rounding,
+                          std::string& out, int& side) {
+    side = 0;
+    if (encodeValue(type, text, out)) return true;
+    if ((type == ColumnType::Int || type == ColumnType::BigInt) && isNumericLiteral(text)) {
+        long double number = std::strtold(text.c_str(), nullptr);
+        if (std::isfinite(number)) {
+            long double bound = rounding == Rounding::Down ? std::floor(number)
+                                : rounding == Rounding::Up ? std::ceil(number) : number;
+            long double low, high;
+            integerRange(type, low, high);
+            if (bound != std::floor(bound)) side = 2;
+            else if (bound < low) side = -1;
+            else if (bound > high) side = 1;
+            out = side == 0 ? storeInteger(type, bound) : std::string();
+            return true;
+        }
+    }
+    errorStream() << "Error: Invalid " << columnTypeName(type) << " value '" << text << "' for column " << column << ".\n";
+    return false;
+}
+
+// Condition of a comparison from its bounds. One past the type's range either
+// leaves no row (id > 1e30, id = 1.5) or every row (id != 1.5), which become
+// id < MIN and id >= MIN.
+static void settle(Predicate::Term& term) {
+    Condition& condition = term.condition;
+    condition.op = term.written;
+    condition.value = term.bounds[0];
+    condition.value2 = term.bounds[1];
+    int lower = term.sides[0], upper = term.sides[1];
+    if (lower == 0 && upper == 0) return;
+    long double low, high;
+    integerRange(condition.type, low, high);
+    bool none = false, all = false;
+    switch (term.written) {
+        case CompareOp::Eq: none = true; break;
+        case CompareOp::Ne: all = true; break;
+        case CompareOp::Gt:
+        case CompareOp::Ge:
+            none = lower > 0;
+            all = lower < 0;
+            break;
+        case CompareOp::Lt:
+        case CompareOp::Le:
+            none = lower < 0;
+            all = lower > 0;
+            break;
+        case CompareOp::Between:
+            none = lower > 0 || upper < 0;
+            if (lower < 0) condition.value = storeInteger(condition.type, low);
+            if (upper > 0) condition.value2 = storeInteger(condition.type, high);
+            break;
+    }
+    if (none || all) {
+        condition.op = none ? CompareOp::Lt : CompareOp::Ge;
+        condition.value = storeInteger(condition.type, low);
+    }
+}
+
+int Predicate::add(const Expr& expr, const std::vector<std::string>& columns, const std::vector<ColumnType>& types) {
+    int id = static_cast<int>(nodes.size());
+    nodes.emplace_back();
+    nodes[id].kind = expr.kind;
+    nodes[id].negated = expr.negated;
+
+    if (expr.kind == ExprKind::And || expr.kind == ExprKind::Or || expr.kind == ExprKind::Not) {
+        // Children are added first so their ids can sit side by side in child_ids
+        std::vector<uint32_t> children;
+        for (const auto& child : expr.children) {
+            int child_id = add(*child, columns, types);
+            if (child_id < 0) return -1;
+            children.push_back(static_cast<uint32_t>(child_id));
+        }
+        nodes[id].arg = static_cast<uint32_t>(child_ids.size());
+        nodes[id].count = static_cast<uint32_t>(children.size());
+        child_ids.insert(child_ids.end(), children.begin(), children.end());
+        return id;
+    }
+
+    auto it = std::find(columns.begin(), columns.end(), expr.column);
+    if (it == columns.end()) {
+        errorStream() << "Error: WHERE column " << expr.column << " does not exist.\n";
+        return -1;
+    }
+    int column = static_cast<int>(it - columns.begin());
+    ColumnType type = types[column];
+    nodes[id].column = column;
+
+    // Parameters are converted by bind(); until then their values stay empty
+    auto param = [&](size_t i) { return i < expr.params.size() ? expr.params[i] : -1; };
+    auto encode = [&](size_t i, Rounding rounding, std::string& out, int& side) {
+        if (param(i) < 0) return encodeLiteral(expr.column, type, expr.values[i], rounding, out, side);
+        slots.push_back({static_cast<uint32_t>(id), static_cast<uint32_t>(i), static_cast<uint32_t>(param(i))});
+        return true;
+    };
+    switch (expr.kind) {
+        case ExprKind::Compare: {
+            Term term;
+            term.column = column;
+            term.condition.column = expr.column;
+            term.condition.type = type;
+            term.written = expr.op;
+            if (!encode(0, roundingFor(expr.op, 0), term.bounds[0], term.sides[0])) return -1;
+            if (expr.op == CompareOp::Between &&
+                !encode(1, roundingFor(expr.op, 1), term.bounds[1], term.sides[1])) {
+                return -1;
+            }
+            settle(term);
+            nodes[id].arg = static_cast<uint32_t>(terms.size());
+            terms.push_back(std::move(term));
+            break;
+        }
+        case ExprKind::In: {
+            // Stored values are canonical, so set membership is byte equality;
+            // a number that is no value of the column stays empty and matches no row
+            std::vector<std::string> values(expr.values.size());
+            size_t bound_later = slots.size();
+            int side;
+            for (size_t i = 0; i < values.size(); ++i) {
+                if (!encode(i, Rounding::Exact, values[i], side)) return -1;
+            }
+            in_sources.resize(in_lists.size() + 1);
+            if (slots.size() > bound_later) in_sources.back() = values;
+            std::sort(values.begin(), values.end());
+            values.erase(std::unique(values.begin(), values.end()), values.end());
+            nodes[id].arg = static_cast<uint32_t>(in_lists.size());
+            in_lists.push_back(std::move(values));
+            break;
+        }
+        case ExprKind::Like:
+            nodes[id].arg = static_cast<uint32_t>(likes.size());
+            likes.emplace_back(expr.values[0]);
+            if (param(0) >= 0) slots.push_back({static_cast<uint32_t>(id), 0, static_cast<uint32_t>(param(0))});
+            like_types.push_back(type);
+            break;
+        default:
+            break;
+    }
+    return id;
+}
+
+bool Predicate::compile(const Expr& expr, const std::vector<std::string>& columns,
+                        const std::vector<ColumnType>& types) {
+    *this = Predicate();
+    if (add(expr, columns, types) < 0) {
+        *this = Predicate();
+        return false;
+    }
+    return true;
+}
+
+bool Predicate::bind(const std::vector<std::string>& params, const std::vector<std::string>& columns,
+                     const std::vector<ColumnType>& types) {
+    std::vector<bool> lists_changed(in_lists.size(), false);
+    for (const Slot& slot : slots) {
+        const Node& node = nodes[slot.node];
+        const std::string& text = params[slot.param];
+        const std::string& column = columns[node.column];
+        ColumnType type = types[node.column];
+        switch (node.kind) {
+            case ExprKind::Compare: {
+                Term& term = terms[node.arg];
+                if (!encodeLiteral(column, type, text, roundingFor(term.written, slot.item), term.bounds[slot.item],
+                                   term.sides[slot.item])) {
+                    return false;
+                }
+                settle(term);
+                break;
+            }
+            case ExprKind::In: {
+                int side;
+                if (!encodeLiteral(column, type, text, Rounding::Exact, in_sources[node.arg][slot.item], side)) {
+                    return false;
+                }
+                lists_changed[node.arg] = true;
+                break;
+            }
+            case ExprKind::Like:
+                likes[node.arg] = LikePattern(text);
+                break;
+            default:
+                break;
+        }
+    }
+    for (size_t list = 0; list < in_lists.size(); ++list) {
+        if (!lists_changed[list]) continue;
+        std::vector<std::string> values = in_sources[list];
+        std::sort(values.begin(), values.end());
+        values.erase(std::unique(values.begin(), values.end()), values.end());
+        in_lists[list] = std::move(values);
+    }
+    return true;
+}
+
+bool Predicate::inList(uint32_t list, std::string_view value) const {
+    const std::vector<std::string>& values = in_lists[list];
+    auto it = std::lower_bound(values.begin(), values.end(), value,
+        [](const std::string& a, std::string_view b) { return std::string_view(a) < b; });
+    return it != values.end() && *it == value;
+}
+
+bool Predicate::likeMatches(uint32_t like, std::string_view value) const {
+    if (like_types[like] == ColumnType::Text) return likes[like].matches(value);
+    return likes[like].matches(formatValue(like_types[like], value));
+}
+
+void Predicate::selectNode(uint32_t id, const ColumnStore& store, size_t begin, size_t end, uint64_t* bits) const {
+    const Node& node = nodes[id];
+    size_t count = end - begin;
+    size_t words = bitmapWords(count);
+    switch (node.kind) {
+        case ExprKind::And:
+        case ExprKind::Or: {
+            bool is_and = node.kind == ExprKind::And;
+            selectNode(child_ids[node.arg], store, begin, end, bits);
+            std::vector<uint64_t> other(words);
+            for (uint32_t i = 1; i < node.count; ++i) {
+                // Stop once the AND has no rows left (or the OR has them all)
+                bool settled = true;
+                for (size_t w = 0; w < words && settled; ++w) {
+                    settled = is_and ? bits[w] == 0 : ~bits[w] == 0;
+                }
+                if (settled) break;
+                selectNode(child_ids[node.arg + i], store, begin, end, other.data());
+                for (size_t w = 0; w < words; ++w) {
+                    bits[w] = is_and ? bits[w] & other[w] : bits[w] | other[w];
+                }
+            }
+            break;
+        }
+        case ExprKind::Not:
+            selectNode(child_ids[node.arg], store, begin, end, bits);
+            for (size_t w = 0; w < words; ++w) bits[w] = ~bits[w];
+            break;
+        default: {
+            const ColumnStore::Column& column = store.column(node.column);
+            if (node.kind == ExprKind::Compare && column.width != 0 && hasFilterKernel(terms[node.arg].condition.type)) {
+                filterFixed(terms[node.arg].condition, column.bytes.data() + begin * column.width, count, bits);
+                return;
+            }
+            if (column.encoded) {
+                selectEncoded(id, column, begin, count, bits);
+                break;
+            }
+            std::fill(bits, bits + words, 0);
+            for (size_t i = 0; i < count; ++i) {
+                if (eval(id, [&](int) { return column.value(begin + i); })) bits[i / 64] |= uint64_t(1) << (i % 64);
+            }
+            return;
+        }
+    }
+    // NOT may have set bits past the last row
+    if (count % 64 != 0) bits[words - 1] &= (uint64_t(1) << (count % 64)) - 1;
+}
+
+void Predicate::selectEncoded(uint32_t id, const ColumnStore::Column& column, size_t begin, size_t count,
+                              uint64_t* bits) const {
+    const Node& node = nodes[id];
+    const ColumnStore::Dictionary& dictionary = column.dictionary;
+    const char* codes = column.bytes.data() + begin * sizeof(uint32_t);
+    CompareOp op = node.kind == ExprKind::Compare ? terms[node.arg].condition.op : CompareOp::Eq;
+    if (node.kind == ExprKind::Compare && (op == CompareOp::Eq || op == CompareOp::Ne)) {
+        // = and != compare codes: the literal is looked up once, then an INT kernel runs over the codes
+        uint32_t code;
+        if (!dictionary.find(terms[node.arg].condition.value, code)) {
+            std::fill(bits, bits + bitmapWords(count), op == CompareOp::Ne ? ~uint64_t(0) : 0);
+            return;
+        }
+        Condition on_codes;
+        on_codes.op = op;
+        on_codes.type = ColumnType::Int;
+        int32_t stored = static_cast<int32_t>(code);
+        on_codes.value.assign(reinterpret_cast<const char*>(&stored), sizeof(stored));
+        filterFixed(on_codes, codes, count, bits);
+        return;
+    }
+    std::fill(bits, bits + bitmapWords(count), 0);
+    auto set = [&](size_t i) { bits[i / 64] |= uint64_t(1) << (i % 64); };
+    if (dictionary.size() > count) {
+        for (size_t i = 0; i < count; ++i) {
+            if (eval(id, [&](int) { return column.value(begin + i); })) set(i);
+        }
+        return;
+    }
+    // Other tests run once per distinct value, then each row looks up its code
+    std::vector<uint8_t> matching(dictionary.size());
+    for (size_t code = 0; code < matching.size(); ++code) {
+        matching[code] = eval(id, [&](int) { return std::string_view(dictionary.values[code]); });
+    }
+    for (size_t i = 0; i < count; ++i) {
+        uint32_t code;
+        std::memcpy(&code, codes + i * sizeof(code), sizeof(code));
+        if (matching[code]) set(i);
+    }
+}
+
+void Predicate::select(const ColumnStore& store, size_t begin, size_t end, uint64_t* bits) const {
+    if (end <= begin) return;
+    if (nodes.empty()) {
+        size_t count = end - begin;
+        std::fill(bits, bits + bitmapWords(count), ~uint64_t(0));
+        if (count % 64 != 0) bits[bitmapWords(count) - 1] = (uint64_t(1) << (count % 64)) - 1;
+        return;
+    }
+    selectNode(0, store, begin, end, bits);
+}
+
+const Predicate::Term* Predicate::single() const {
+    if (nodes.size() != 1 || nodes[0].kind != ExprKind::Compare) return nullptr;
+    return &terms[nodes[0].arg];
+}
+
+std::vector<const Predicate::Term*> Predicate::conjuncts() const {
+    std::vector<const Term*> result;
+    auto consider = [&](const Node& node) {
+        if (node.kind == ExprKind::Compare && terms[node.arg].condition.op != CompareOp::Ne) {
+            result.push_back(&terms[node.arg]);
+        }
+    };
+    if (nodes.empty()) return result;
+    if (nodes[0].kind == ExprKind::And) {
+        for (uint32_t i = 0; i < nodes[0].count; ++i) consider(nodes[child_ids[nodes[0].arg + i]]);
+    } else {
+        consider(nodes[0]);
+    }
+    return result;
+}
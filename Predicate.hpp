@@ -0,0 +1,132 @@
+// Predicate.hpp
+#ifndef PREDICATE_HPP
+#define PREDICATE_HPP
+
+#include "ColumnStore.hpp"
+#include "Condition.hpp"
+#include "Expression.hpp"
+#include <string>
+#include <string_view>
+#include <vector>
+
+// LIKE pattern with % (any run) and _ (any one character). Patterns that are
+// plain text around a single % run are matched with one comparison.
+class LikePattern {
+private:
+    enum class Shape { Exact, Prefix, Suffix, Contains, General };
+    Shape shape = Shape::General;
+    std::string pattern; // the text to compare for the fast shapes
+public:
+    explicit LikePattern(const std::string& pattern = "");
+    bool matches(std::string_view text) const;
+};
+
+// A WHERE expression compiled against one table's schema: column names are
+// resolved to indices and literals converted to stored values once, so
+// matching a row is a walk over a flat array of nodes with no lookups.
+class Predicate {
+public:
+    // A comparison with its column resolved
+    struct Term {
+        int column;
+        Condition condition; // values in the column's stored form
+        // The comparison as written, before a literal that is no value of an
+        // integer column (1.5, or past its range) was rounded into condition:
+        // its operator, each value as a bound, and where each bound fell
+        // (-1 below the type's range, 1 above it, 2 not an integer at all)
+        CompareOp written = CompareOp::Eq;
+        std::string bounds[2];
+        int sides[2] = {0, 0};
+    };
+
+private:
+    struct Node {
+        ExprKind kind;
+        bool negated = false;
+        int column = -1;
+        uint32_t arg = 0;   // And/Or/Not: first entry in child_ids; leaves: index into terms/in_lists/likes
+        uint32_t count = 0; // And/Or/Not: number of children
+    };
+    std::vector<Node> nodes; // nodes[0] is the root
+    std::vector<uint32_t> child_ids;
+    std::vector<Term> terms;
+    std::vector<std::vector<std::string>> in_lists; // sorted stored values
+    std::vector<LikePattern> likes;
+    std::vector<ColumnType> like_types; // LIKE on a typed column matches its text form
+    // Values that come from ? parameters, left empty until bind() fills them in
+    struct Slot {
+        uint32_t node;
+        uint32_t item; // Compare: 0, or 1 for BETWEEN's upper bound; In: position in the list
+        uint32_t param;
+    };
+    std::vector<Slot> slots;
+    // In lists with a parameter, in written order, to sort again after each bind()
+    std::vector<std::vector<std::string>> in_sources;
+
+    int add(const Expr& expr, const std::vector<std::string>& columns, const std::vector<ColumnType>& types);
+
+    template <typename Field>
+    bool eval(uint32_t id, const Field& field) const {
+        const Node& node = nodes[id];
+        switch (node.kind) {
+            case ExprKind::And:
+                for (uint32_t i = 0; i < node.count; ++i) {
+                    if (!eval(child_ids[node.arg + i], field)) return false;
+                }
+                return true;
+            case ExprKind::Or:
+                for (uint32_t i = 0; i < node.count; ++i) {
+                    if (eval(child_ids[node.arg + i], field)) return true;
+                }
+                return false;
+            case ExprKind::Not:
+                return !eval(child_ids[node.arg], field);
+            case ExprKind::Compare:
+                return terms[node.arg].condition.matches(field(node.column));
+            case ExprKind::In:
+                return inList(node.arg, field(node.column)) != node.negated;
+            case ExprKind::Like:
+                return likeMatches(node.arg, field(node.column)) != node.negated;
+        }
+        return false;
+    }
+    bool inList(uint32_t list, std::string_view value) const;
+    bool likeMatches(uint32_t like, std::string_view value) const;
+    void selectNode(uint32_t id, const ColumnStore& store, size_t begin, size_t end, uint64_t* bits) const;
+    // A leaf on a dictionary-encoded column, tested on its codes
+    void selectEncoded(uint32_t id, const ColumnStore::Column& column, size_t begin, size_t count,
+                       uint64_t* bits) const;
+
+public:
+    // Resolve expr against a schema; reports an unknown column or a literal that
+    // is not a valid value for its column and returns false
+    bool compile(const Expr& expr, const std::vector<std::string>& columns, const std::vector<ColumnType>& types);
+    // Set the values that stand for ? parameters, converting each for its
+    // column; reports a value that is not valid for it and returns false
+    bool bind(const std::vector<std::string>& params, const std::vector<std::string>& columns,
+              const std::vector<ColumnType>& types);
+
+    // True when there is no WHERE clause: every row matches
+    bool empty() const { return nodes.empty(); }
+
+    // field(column) returns the stored value of that column in the row being tested
+    template <typename Field>
+    bool matches(const Field& field) const {
+        return nodes.empty() || eval(0, field);
+    }
+
+    // Selection bitmap of rows [begin, end) of a columnar table: bit i is set when
+    // row begin + i matches. Comparisons on INT, BIGINT and DOUBLE columns run as
+    // SIMD kernels over the column's array, as do = and != on dictionary-encoded
+    // TEXT (over its codes); other tests on an encoded column run once per
+    // distinct value, the rest row by row. AND, OR and NOT combine bitmap words.
+    void select(const ColumnStore& store, size_t begin, size_t end, uint64_t* bits) const;
+
+    // The predicate when it is a single comparison, else nullptr
+    const Term* single() const;
+    // Comparisons every matching row satisfies (the predicate itself, or the
+    // comparisons directly under a top-level AND) that an index could answer
+    std::vector<const Term*> conjuncts() const;
+};
+
+#endif // PREDICATE_HPP
@@ -0,0 +1,149 @@
+// Protocol.cpp
+#include "Protocol.hpp"
+#include "Diagnostics.hpp"
+#include <arpa/inet.h>
+#include <cassert>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+void appendFrame(std::string& out, std::string_view payload) {
+    assert(payload.size() <= MAX_FRAME_BYTES);
+    uint32_t length = htonl(static_cast<uint32_t>(payload.size()));
+    out.append(reinterpret_cast<const char*>(&length), sizeof(length));
+    out.append(payload);
+}
+
+bool takeFrame(const std::string& buffer, size_t& offset, std::string& payload, bool& too_large) {
+    too_large = false;
+    if (buffer.size() - offset < sizeof(uint32_t)) return false;
+    uint32_t length;
+    std::memcpy(&length, buffer.data() + offset, sizeof(length));
+    length = ntohl(length);
+    if (length > MAX_FRAME_BYTES) {
+        too_large = true;
+        return false;
+    }
+    if (buffer.size() - offset - sizeof(uint32_t) < length) return false;
+    payload.assign(buffer, offset + sizeof(uint32_t), length);
+    offset += sizeof(uint32_t) + length;
+    return true;
+}
+
+// The socket address of address, which is either Unix or loopback TCP
+static bool parseAddress(const std::string& address, sockaddr_storage& storage, socklen_t& size) {
+    std::memset(&storage, 0, sizeof(storage));
+    if (address.compare(0, 5, "unix:") == 0) {
+        std::string path = address.substr(5);
+        sockaddr_un* un = reinterpret_cast<sockaddr_un*>(&storage);
+        if (path.empty() || path.size() >= sizeof(un->sun_path)) {
+            errorStream() << "Error: Invalid socket path '" << path << "'.\n";
+            return false;
+        }
+        un->sun_family = AF_UNIX;
+        std::memcpy(un->sun_path, path.c_str(), path.size() + 1);
+        size = sizeof(sockaddr_un);
+        return true;
+    }
+    std::string host = "127.0.0.1";
+    std::string port = address;
+    size_t colon = address.rfind(':');
+    if (colon != std::string::npos) {
+        host = address.substr(0, colon);
+        port = address.substr(colon + 1);
+        if (host == "localhost") host = "127.0.0.1";
+    }
+    sockaddr_in* in = reinterpret_cast<sockaddr_in*>(&storage);
+    in->sin_family = AF_INET;
+    char* end = nullptr;
+    unsigned long number = std::strtoul(port.c_str(), &end, 10);
+    // Only the loopback network: the server has no authentication
+    if (port.empty() || *end != '\0' || number == 0 || number > 65535 ||
+        inet_pton(AF_INET, host.c_str(), &in->sin_addr) != 1 || (ntohl(in->sin_addr.s_addr) >> 24) != 127) {
+        errorStream() << "Error: Invalid address '" << address << "'. Use unix:PATH or a loopback [HOST:]PORT.\n";
+        return false;
+    }
+    in->sin_port = htons(static_cast<uint16_t>(number));
+    size = sizeof(sockaddr_in);
+    return true;
+}
+
+int listenOn(const std::string& address) {
+    sockaddr_storage storage;
+    socklen_t size;
+    if (!parseAddress(address, storage, size)) return -1;
+    int fd = socket(storage.ss_family, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        errorStream() << "Error: Unable to create a socket: " << std::strerror(errno) << "\n";
+        return -1;
+    }
+    if (storage.ss_family == AF_UNIX) {
+        // A socket left behind by a server that is gone
+        std::error_code ec;
+        std::filesystem::path path(reinterpret_cast<sockaddr_un*>(&storage)->sun_path);
+        if (std::filesystem::is_socket(path, ec)) std::filesystem::remove(path, ec);
+    } else {
+        int on = 1;
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    }
+    if (bind(fd, reinterpret_cast<sockaddr*>(&storage), size) < 0 || listen(fd, SOMAXCONN) < 0) {
+        errorStream() << "Error: Unable to listen on " << address << ": " << std::strerror(errno) << "\n";
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+int connectTo(const std::string& address) {
+    sockaddr_storage storage;
+    socklen_t size;
+    if (!parseAddress(address, storage, size)) return -1;
+    int fd = socket(storage.ss_family, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0 || connect(fd, reinterpret_cast<sockaddr*>(&storage), size) < 0) {
+        errorStream() << "Error: Unable to connect to " << address << ": " << std::strerror(errno) << "\n";
+        if (fd >= 0) close(fd);
+        return -1;
+    }
+    if (storage.ss_family == AF_INET) {
+        int on = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+    }
+    return fd;
+}
+
+bool sendAll(int fd, std::string_view data) {
+    while (!data.empty()) {
+        ssize_t sent = send(fd, data.data(), data.size(), MSG_NOSIGNAL);
+        if (sent < 0 && errno == EINTR) continue;
+        if (sent <= 0) return false;
+        data.remove_prefix(static_cast<size_t>(sent));
+    }
+    return true;
+}
+
+// Read exactly size bytes
+static bool readAll(int fd, char* data, size_t size) {
+    while (size > 0) {
+        ssize_t got = read(fd, data, size);
+        if (got < 0 && errno == EINTR) continue;
+        if (got <= 0) return false;
+        data += got;
+        size -= static_cast<size_t>(got);
+    }
+    return true;
+}
+
+bool readFrame(int fd, std::string& payload) {
+    uint32_t length;
+    if (!readAll(fd, reinterpret_cast<char*>(&length), sizeof(length))) return false;
+    length = ntohl(length);
+    if (length > MAX_FRAME_BYTES) return false;
+    payload.resize(length);
+    return readAll(fd, payload.data(), length);
+}
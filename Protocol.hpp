@@ -0,0 +1,39 @@
+// Protocol.hpp
+#ifndef PROTOCOL_HPP
+#define PROTOCOL_HPP
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// Wire format of the server. Every message is a frame: a 4-byte big-endian
+// length, then that many bytes. A request frame holds one SQL statement. The
+// response frame starts with a status byte, then the text the REPL would
+// print for the statement (errors, messages and rows); a result that would
+// not fit in MAX_FRAME_BYTES is answered with an error instead. A client may
+// send several requests before reading; responses come back in request order.
+const uint32_t MAX_FRAME_BYTES = 64u << 20;
+
+enum class ResponseStatus : uint8_t {
+    Ok = 0,
+    Error = 1 // the statement reported an error
+};
+
+// Append payload, at most MAX_FRAME_BYTES, to out as one frame
+void appendFrame(std::string& out, std::string_view payload);
+// Take the frame starting at offset of buffer into payload and move offset
+// past it; false if it has not fully arrived yet. too_large is set instead for
+// a frame longer than MAX_FRAME_BYTES.
+bool takeFrame(const std::string& buffer, size_t& offset, std::string& payload, bool& too_large);
+
+// Sockets. An address is "unix:PATH" for a Unix domain socket, or a TCP
+// port on the loopback interface: "PORT", "localhost:PORT" or "127.0.0.1:PORT".
+// Both report a bad address or a failing call and return -1.
+int listenOn(const std::string& address);
+int connectTo(const std::string& address);
+
+// Blocking I/O for clients: write all of data, read one whole frame
+bool sendAll(int fd, std::string_view data);
+bool readFrame(int fd, std::string& payload);
+
+#endif // PROTOCOL_HPP
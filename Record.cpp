@@ -1,3 +1,56 @@
 // Record.cpp
 #include "Record.hpp"
-// Currently empty as we use default implementations
\ No newline at end of file
+#include <cstring>
+
+std::string_view Record::field(size_t i) const {
+    if (!encoded) {
+        return fields[i];
+    }
+    const char* p = encoded;
+    uint32_t len;
+    for (size_t k = 0; k < i; ++k) {
+        std::memcpy(&len, p, sizeof(len));
+        p += sizeof(len) + len;
+    }
+    std::memcpy(&len, p, sizeof(len));
+    return std::string_view(p + sizeof(len), len);
+}
+
+size_t Record::encodedSize() const {
+    size_t bytes = 0;
+    if (!encoded) {
+        for (const auto& field : fields) bytes += sizeof(uint32_t) + field.size();
+        return bytes;
+    }
+    for (uint32_t k = 0; k < encoded_count; ++k) {
+        uint32_t len;
+        std::memcpy(&len, encoded + bytes, sizeof(len));
+        bytes += sizeof(len) + len;
+    }
+    return bytes;
+}
+
+void Record::setField(size_t i, const std::string& value) {
+    if (encoded) {
+        fields = materialize();
+        encoded = nullptr;
+        encoded_count = 0;
+    }
+    fields[i] = value;
+}
+
+std::vector<std::string> Record::materialize() const {
+    if (!encoded) {
+        return fields;
+    }
+    std::vector<std::string> out;
+    out.reserve(encoded_count);
+    const char* p = encoded;
+    for (uint32_t k = 0; k < encoded_count; ++k) {
+        uint32_t len;
+        std::memcpy(&len, p, sizeof(len));
+        out.emplace_back(p + sizeof(len), len);
+        p += sizeof(len) + len;
+    }
+    return out;
+}
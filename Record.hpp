@@ -2,15 +2,38 @@
 #ifndef RECORD_HPP
 #define RECORD_HPP
 
+#include <cstdint>
 #include <vector>
 #include <string>
+#include <string_view>
 
+// A row is either a view of its encoded bytes (u32 length + bytes per field)
+// inside a mapped table file or a RowArena, or, once modified, its own copy of
+// the fields.
 class Record {
-public:
+private:
+    const char* encoded = nullptr;
+    uint32_t encoded_count = 0;
     std::vector<std::string> fields;
 
+public:
     Record() = default;
     Record(const std::vector<std::string>& fields) : fields(fields) {}
+    Record(std::vector<std::string>&& fields) : fields(std::move(fields)) {}
+    // View of an encoded row; the bytes must outlive the record
+    Record(const char* encoded, uint32_t field_count) : encoded(encoded), encoded_count(field_count) {}
+
+    size_t size() const { return encoded ? encoded_count : fields.size(); }
+    std::string_view field(size_t i) const;
+    bool isMapped() const { return encoded != nullptr; }
+    // Start of a view's encoded bytes, nullptr for a row with its own fields
+    const char* data() const { return encoded; }
+    // Bytes the row takes encoded: a u32 length and the bytes per field
+    size_t encodedSize() const;
+
+    // Copies a mapped row into owned storage before changing it
+    void setField(size_t i, const std::string& value);
+    std::vector<std::string> materialize() const;
 };
 
-#endif // RECORD_HPP
\ No newline at end of file
+#endif // RECORD_HPP
@@ -0,0 +1,68 @@
+// RowArena.cpp
+#include "RowArena.hpp"
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+
+char* RowArena::allocate(size_t bytes) {
+    if (bytes > left) {
+        // A row larger than a slab gets a slab of its own size
+        size_t grown = std::min<size_t>(SLAB_BYTES, std::max<size_t>(FIRST_SLAB_BYTES, stats_.reserved));
+        size_t size = std::max(bytes, grown);
+        slabs.emplace_back(new char[size]);
+        next = slabs.back().get();
+        left = size;
+        stats_.slabs++;
+        stats_.reserved += size;
+    }
+    char* p = next;
+    next += bytes;
+    left -= bytes;
+    stats_.used += bytes;
+    return p;
+}
+
+static char* putField(char* p, std::string_view field) {
+    uint32_t len = static_cast<uint32_t>(field.size());
+    std::memcpy(p, &len, sizeof(len));
+    std::memcpy(p + sizeof(len), field.data(), field.size());
+    return p + sizeof(len) + field.size();
+}
+
+Record RowArena::append(const std::vector<std::string>& fields) {
+    size_t bytes = 0;
+    for (const auto& field : fields) bytes += sizeof(uint32_t) + field.size();
+    char* row = allocate(bytes);
+    char* p = row;
+    for (const auto& field : fields) p = putField(p, field);
+    return Record(row, static_cast<uint32_t>(fields.size()));
+}
+
+Record RowArena::append(const std::vector<std::string_view>& fields) {
+    size_t bytes = 0;
+    for (std::string_view field : fields) bytes += sizeof(uint32_t) + field.size();
+    char* row = allocate(bytes);
+    char* p = row;
+    for (std::string_view field : fields) p = putField(p, field);
+    return Record(row, static_cast<uint32_t>(fields.size()));
+}
+
+Record RowArena::append(const Record& record) {
+    char* row = allocate(record.encodedSize());
+    char* p = row;
+    for (size_t i = 0; i < record.size(); ++i) p = putField(p, record.field(i));
+    return Record(row, static_cast<uint32_t>(record.size()));
+}
+
+void RowArena::adopt(RowArena&& other) {
+    // Rows keep going into this arena's last slab; the rest of other's is left unused
+    std::move(other.slabs.begin(), other.slabs.end(), std::back_inserter(slabs));
+    stats_.slabs += other.stats_.slabs;
+    stats_.reserved += other.stats_.reserved;
+    stats_.used += other.stats_.used;
+    stats_.garbage += other.stats_.garbage;
+    other.slabs.clear();
+    other.next = nullptr;
+    other.left = 0;
+    other.stats_ = Stats();
+}
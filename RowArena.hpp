@@ -0,0 +1,56 @@
+// RowArena.hpp
+#ifndef ROW_ARENA_HPP
+#define ROW_ARENA_HPP
+
+#include "Record.hpp"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Slab storage for the rows of a row-layout table. Each row is encoded once,
+// the way a table file lays it out (a u32 length and the bytes per field), into
+// the current slab, and its Record is a view of those bytes like a row of a
+// mapped file: one allocation per slab instead of a vector and a string per
+// row. Rows never move, so views stay valid for as long as the arena lives.
+class RowArena {
+public:
+    // Slabs double from the first size to the largest as the arena grows, so a
+    // small table (or one INSERT's batch) does not hold a large slab
+    static constexpr size_t FIRST_SLAB_BYTES = 4 * 1024;
+    static constexpr size_t SLAB_BYTES = 64 * 1024;
+
+    struct Stats {
+        uint64_t slabs = 0;
+        uint64_t reserved = 0; // bytes of every slab
+        uint64_t used = 0;     // bytes of rows appended
+        uint64_t garbage = 0;  // of those, bytes of rows released since
+    };
+
+    RowArena() = default;
+    RowArena(const RowArena&) = delete;
+    RowArena& operator=(const RowArena&) = delete;
+    RowArena(RowArena&&) = default;
+    RowArena& operator=(RowArena&&) = default;
+
+    // Encode a row into the arena and return a view of it
+    Record append(const std::vector<std::string>& fields);
+    Record append(const std::vector<std::string_view>& fields);
+    Record append(const Record& record);
+    // Take over other's slabs; its rows stay where they are, so views of them stay valid
+    void adopt(RowArena&& other);
+    // Note that a row of the arena is no longer referenced
+    void release(const Record& record) { stats_.garbage += record.encodedSize(); }
+    const Stats& stats() const { return stats_; }
+
+private:
+    std::vector<std::unique_ptr<char[]>> slabs;
+    char* next = nullptr; // free space of the last slab
+    size_t left = 0;
+    Stats stats_;
+
+    char* allocate(size_t bytes);
+};
+
+#endif // ROW_ARENA_HPP
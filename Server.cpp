@@ -0,0 +1,328 @@
+// Server.cpp
+#include "Server.hpp"
+#include "Diagnostics.hpp"
+#include "Protocol.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sstream>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+// A connection is not read from while more than this much of its output is
+// unwritten, so a client that sends without reading cannot grow it unbounded
+const size_t MAX_PENDING_OUTPUT = 16u << 20;
+
+Server::Server(Database& db, size_t worker_count) : db(db) {
+    epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.fd = wake_fd;
+    epoll_ctl(epoll_fd, EPOLL_CTL_ADD, wake_fd, &event);
+    for (size_t i = 0; i < std::max<size_t>(1, worker_count); ++i) {
+        workers.emplace_back([this]() { workerLoop(); });
+    }
+}
+
+Server::~Server() {
+    {
+        std::lock_guard<std::mutex> lock(task_mutex);
+        stop_workers = true;
+    }
+    task_ready.notify_all();
+    for (auto& worker : workers) worker.join();
+    for (auto& pair : connections) close(pair.first);
+    if (listen_fd >= 0) close(listen_fd);
+    close(wake_fd);
+    close(epoll_fd);
+}
+
+bool Server::listen(const std::string& address) {
+    listen_fd = listenOn(address);
+    if (listen_fd < 0) return false;
+    fcntl(listen_fd, F_SETFL, O_NONBLOCK);
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.fd = listen_fd;
+    epoll_ctl(epoll_fd, EPOLL_CTL_ADD, listen_fd, &event);
+    return true;
+}
+
+void Server::stop() {
+    stopping = true;
+    uint64_t one = 1;
+    ssize_t ignored = write(wake_fd, &one, sizeof(one));
+    (void)ignored;
+}
+
+void Server::run() {
+    const int MAX_EVENTS = 64;
+    epoll_event events[MAX_EVENTS];
+    while (!stopping) {
+        int count = epoll_wait(epoll_fd, events, MAX_EVENTS, -1);
+        if (count < 0) {
+            if (errno == EINTR) continue;
+            errorStream() << "Error: epoll_wait failed: " << std::strerror(errno) << "\n";
+            break;
+        }
+        for (int i = 0; i < count; ++i) {
+            int fd = events[i].data.fd;
+            if (fd == listen_fd) {
+                acceptConnections();
+                continue;
+            }
+            if (fd == wake_fd) {
+                uint64_t value;
+                ssize_t ignored = read(wake_fd, &value, sizeof(value));
+                (void)ignored;
+                std::vector<std::shared_ptr<Connection>> writable;
+                {
+                    std::lock_guard<std::mutex> lock(ready_mutex);
+                    writable.swap(ready);
+                }
+                for (const auto& connection : writable) writeResponses(connection);
+                continue;
+            }
+            auto it = connections.find(fd);
+            if (it == connections.end()) continue;
+            std::shared_ptr<Connection> connection = it->second;
+            if (events[i].events & EPOLLOUT) writeResponses(connection);
+            // Writing may have finished, and so closed, the connection
+            it = connections.find(fd);
+            if (it == connections.end() || it->second != connection) continue;
+            if (connection->read_closed && (events[i].events & (EPOLLHUP | EPOLLERR))) {
+                // Nothing more can be written to a client that is gone
+                closeConnection(connection);
+            } else if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+                readRequests(connection);
+            }
+        }
+    }
+    // Sessions of connections still open are ended by the workers
+    std::vector<std::shared_ptr<Connection>> open;
+    for (auto& pair : connections) open.push_back(pair.second);
+    for (const auto& connection : open) closeConnection(connection);
+}
+
+void Server::acceptConnections() {
+    while (true) {
+        int fd = accept4(listen_fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno == EINTR) continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                errorStream() << "Error: accept failed: " << std::strerror(errno) << "\n";
+            }
+            return;
+        }
+        int on = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on)); // fails harmlessly on Unix sockets
+        auto connection = std::make_shared<Connection>(fd);
+        connections[fd] = connection;
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.fd = fd;
+        epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event);
+        connection->watched = EPOLLIN;
+    }
+}
+
+void Server::readRequests(const std::shared_ptr<Connection>& connection) {
+    char buffer[65536];
+    bool open = true;
+    bool eof = false;
+    while (true) {
+        ssize_t got = read(connection->fd, buffer, sizeof(buffer));
+        if (got > 0) {
+            connection->input.append(buffer, static_cast<size_t>(got));
+            continue;
+        }
+        if (got < 0 && errno == EINTR) continue;
+        eof = got == 0;
+        open = eof || errno == EAGAIN || errno == EWOULDBLOCK;
+        break;
+    }
+
+    // Every complete frame is queued, so a pipelining client's requests are
+    // all waiting when the worker finishes the one before
+    std::vector<std::string> requests;
+    std::string payload;
+    size_t offset = 0;
+    bool too_large = false;
+    while (takeFrame(connection->input, offset, payload, too_large)) requests.push_back(std::move(payload));
+    connection->input.erase(0, offset);
+    if (!requests.empty()) {
+        std::lock_guard<std::mutex> lock(connection->mutex);
+        for (auto& request : requests) connection->requests.push_back(std::move(request));
+        schedule(connection);
+    }
+    if (too_large) {
+        errorStream() << "Error: A client sent a request larger than " << MAX_FRAME_BYTES << " bytes.\n";
+        open = false;
+    }
+    // A client that is gone gets no responses; requests it sent still run
+    if (!open) {
+        closeConnection(connection);
+        return;
+    }
+    if (eof) {
+        // The client may still be reading: the connection stays open until
+        // the responses to everything it sent are written
+        connection->read_closed = true;
+        bool finished;
+        {
+            std::lock_guard<std::mutex> lock(connection->mutex);
+            finished = !connection->busy && connection->requests.empty() &&
+                       connection->output.size() == connection->written;
+        }
+        if (finished) {
+            closeConnection(connection);
+        } else {
+            watch(*connection);
+        }
+    }
+}
+
+void Server::writeResponses(const std::shared_ptr<Connection>& connection) {
+    std::unique_lock<std::mutex> lock(connection->mutex);
+    connection->write_queued = false;
+    if (connection->closed) return;
+    std::string& output = connection->output;
+    bool blocked = false;
+    bool gone = false;
+    while (connection->written < output.size()) {
+        ssize_t sent = send(connection->fd, output.data() + connection->written, output.size() - connection->written,
+                            MSG_NOSIGNAL);
+        if (sent > 0) {
+            connection->written += static_cast<size_t>(sent);
+            continue;
+        }
+        if (sent < 0 && errno == EINTR) continue;
+        blocked = sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK);
+        gone = !blocked;
+        break;
+    }
+    if (!blocked) {
+        // All written, or the client went away; unless it already sent EOF,
+        // its connection is closed once the read side sees that
+        output.clear();
+        connection->written = 0;
+    }
+    connection->writable_wait = blocked;
+    connection->read_paused = output.size() - connection->written > MAX_PENDING_OUTPUT;
+    // Requests held back by serve() while the output was over the limit
+    if (!connection->read_paused && !connection->requests.empty()) schedule(connection);
+    bool finished = connection->read_closed &&
+                    (gone || (!connection->busy && connection->requests.empty() && output.empty()));
+    lock.unlock();
+    if (finished) {
+        closeConnection(connection);
+    } else {
+        watch(*connection);
+    }
+}
+
+void Server::watch(Connection& connection) {
+    uint32_t events = 0;
+    if (!connection.read_closed && !connection.read_paused) events |= EPOLLIN;
+    if (connection.writable_wait) events |= EPOLLOUT;
+    if (events == connection.watched) return;
+    connection.watched = events;
+    epoll_event event{};
+    event.events = events;
+    event.data.fd = connection.fd;
+    epoll_ctl(epoll_fd, EPOLL_CTL_MOD, connection.fd, &event);
+}
+
+void Server::closeConnection(const std::shared_ptr<Connection>& connection) {
+    if (connections.erase(connection->fd) == 0) return;
+    epoll_ctl(epoll_fd, EPOLL_CTL_DEL, connection->fd, nullptr);
+    close(connection->fd);
+    std::lock_guard<std::mutex> lock(connection->mutex);
+    connection->closed = true;
+    schedule(connection);
+}
+
+void Server::schedule(const std::shared_ptr<Connection>& connection) {
+    if (connection->busy) return;
+    connection->busy = true;
+    {
+        std::lock_guard<std::mutex> lock(task_mutex);
+        tasks.push_back(connection);
+    }
+    task_ready.notify_one();
+}
+
+void Server::workerLoop() {
+    std::unique_lock<std::mutex> lock(task_mutex);
+    while (true) {
+        task_ready.wait(lock, [this]() { return stop_workers || !tasks.empty(); });
+        // Queued work is finished first, so every closed session is ended
+        if (tasks.empty()) return;
+        std::shared_ptr<Connection> connection = std::move(tasks.front());
+        tasks.pop_front();
+        lock.unlock();
+        serve(connection);
+        lock.lock();
+    }
+}
+
+void Server::serve(const std::shared_ptr<Connection>& connection) {
+    std::unique_lock<std::mutex> lock(connection->mutex);
+    // Once the output is over the limit the rest waits for writeResponses() to
+    // drain it; a closed connection's requests run without adding any
+    while (!connection->requests.empty() &&
+           (connection->closed || connection->output.size() - connection->written <= MAX_PENDING_OUTPUT)) {
+        std::string sql = std::move(connection->requests.front());
+        connection->requests.pop_front();
+        lock.unlock();
+        std::string response = runStatement(connection->session, sql);
+        lock.lock();
+        if (connection->closed) continue;
+        appendFrame(connection->output, response);
+        if (!connection->write_queued) {
+            connection->write_queued = true;
+            {
+                std::lock_guard<std::mutex> ready_lock(ready_mutex);
+                ready.push_back(connection);
+            }
+            uint64_t one = 1;
+            ssize_t ignored = write(wake_fd, &one, sizeof(one));
+            (void)ignored;
+        }
+    }
+    // Checked under the same lock that closeConnection() sets it under, so a
+    // close after the last request is never missed
+    bool closed = connection->closed;
+    connection->busy = false;
+    lock.unlock();
+    if (closed) {
+        OutputCapture discard; // a rolled back transaction has no one to tell
+        db.endSession(connection->session);
+    }
+}
+
+std::string Server::runStatement(Session& session, const std::string& sql) {
+    QueryResult result = db.execute(sql, session);
+    std::string response(1, static_cast<char>(result.ok ? ResponseStatus::Ok : ResponseStatus::Error));
+    response += result.error;
+    response += result.message;
+    // Rows are formatted only while they still fit in one frame
+    bool fits = response.size() <= MAX_FRAME_BYTES;
+    if (result.cursor && fits) {
+        std::ostringstream rows;
+        fits = printCursor(*result.cursor, rows, MAX_FRAME_BYTES - response.size());
+        if (fits) response += rows.str();
+    }
+    if (!fits) {
+        response.assign(1, static_cast<char>(ResponseStatus::Error));
+        response += "Error: The result is larger than the " + std::to_string(MAX_FRAME_BYTES >> 20) +
+                    " MiB a response may hold; narrow it with WHERE or LIMIT.\n";
+    }
+    return response;
+}
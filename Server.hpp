@@ -0,0 +1,95 @@
+// Server.hpp
+#ifndef SERVER_HPP
+#define SERVER_HPP
+
+#include "Database.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// Serves a database to clients speaking the protocol of Protocol.hpp. One
+// thread runs an epoll loop that accepts connections, reads request frames
+// and writes responses; worker threads run the statements. Each connection
+// is a session of its own, and its requests run one after another, in order,
+// however many the client sends before reading, while different connections'
+// requests go to different workers.
+// A client that closes its sending side still gets the responses to what it
+// sent, and one that stops reading is not read from until it catches up.
+class Server {
+private:
+    struct Connection {
+        int fd;
+        std::string input; // bytes read but not yet taken as frames (loop thread only)
+        std::mutex mutex;  // guards the fields below
+        std::deque<std::string> requests;
+        std::string output; // response frames not yet written
+        size_t written = 0; // of output
+        bool busy = false;  // a worker has (or is about to take) the connection
+        bool closed = false;
+        // Loop thread only
+        bool writable_wait = false; // waiting for EPOLLOUT
+        bool read_closed = false;   // the client sent EOF; closed once its responses are written
+        bool read_paused = false;   // more than MAX_PENDING_OUTPUT unwritten
+        uint32_t watched = 0;       // epoll events registered
+        bool write_queued = false;  // in ready
+        Session session;            // used by one worker at a time
+
+        explicit Connection(int fd) : fd(fd) {}
+    };
+
+    Database& db;
+    int listen_fd = -1;
+    int epoll_fd = -1;
+    int wake_fd = -1; // eventfd: responses are ready, or stop() was called
+    std::atomic<bool> stopping{false};
+    std::unordered_map<int, std::shared_ptr<Connection>> connections; // loop thread only
+
+    // Connections with responses to write, handed from workers to the loop
+    std::mutex ready_mutex;
+    std::vector<std::shared_ptr<Connection>> ready;
+
+    // Connections with requests (or a session to end), for the workers
+    std::vector<std::thread> workers;
+    std::mutex task_mutex;
+    std::condition_variable task_ready;
+    std::deque<std::shared_ptr<Connection>> tasks;
+    bool stop_workers = false;
+
+    void acceptConnections();
+    // Read what has arrived and queue the complete requests
+    void readRequests(const std::shared_ptr<Connection>& connection);
+    // Write as much pending output as the socket takes
+    void writeResponses(const std::shared_ptr<Connection>& connection);
+    void closeConnection(const std::shared_ptr<Connection>& connection);
+    // Register the events the connection's state calls for
+    void watch(Connection& connection);
+    // Hand the connection to a worker unless one has it; connection.mutex must be held
+    void schedule(const std::shared_ptr<Connection>& connection);
+    void workerLoop();
+    // Run the connection's queued requests; end its session once it is closed
+    void serve(const std::shared_ptr<Connection>& connection);
+    // Run one statement and build its response payload
+    std::string runStatement(Session& session, const std::string& sql);
+
+public:
+    // workers: threads running statements, at least 1
+    Server(Database& db, size_t workers);
+    ~Server();
+    Server(const Server&) = delete;
+    Server& operator=(const Server&) = delete;
+
+    // Listen on an address of Protocol.hpp; reports and returns false if it cannot
+    bool listen(const std::string& address);
+    // Serve clients until stop(), then close every connection, ending its session
+    void run();
+    // Make run() return; safe to call from a signal handler
+    void stop();
+};
+
+#endif // SERVER_HPP
@@ -0,0 +1,35 @@
+// Snapshot.hpp
+#ifndef SNAPSHOT_HPP
+#define SNAPSHOT_HPP
+
+#include <cstdint>
+
+// Row versions are stamped with the commit timestamp that created and the one
+// that deleted them. While a transaction is open its changes carry its id,
+// tagged with IN_FLIGHT, and are visible to that transaction alone.
+const uint64_t IN_FLIGHT = uint64_t(1) << 63;
+const uint64_t NEVER = UINT64_MAX; // deleted stamp of a live version
+
+struct RowStamp {
+    uint64_t created = 0; // 0: committed before every snapshot still open
+    uint64_t deleted = NEVER;
+};
+
+// What one statement or transaction reads: every version committed at or
+// before read_ts, plus the changes of its own transaction. The default sees
+// everything committed, and writes made under it are not versioned at all.
+struct Snapshot {
+    uint64_t read_ts = NEVER & ~IN_FLIGHT;
+    uint64_t txn = 0; // transaction id of a writer, 0 for none
+
+    uint64_t ownStamp() const { return IN_FLIGHT | txn; }
+
+    bool sees(uint64_t stamp) const {
+        return stamp == ownStamp() || (!(stamp & IN_FLIGHT) && stamp <= read_ts);
+    }
+    bool sees(const RowStamp& stamp) const {
+        return sees(stamp.created) && !sees(stamp.deleted);
+    }
+};
+
+#endif // SNAPSHOT_HPP
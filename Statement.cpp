@@ -0,0 +1,397 @@
+// Statement.cpp
+#include "Statement.hpp"
+#include "Diagnostics.hpp"
+#include <cctype>
+#include <iostream>
+
+namespace {
+
+class StatementParser {
+private:
+    Lexer& lexer;
+    bool failed = false;
+
+    const Token& current() const { return lexer.peek(); }
+    void advance() { lexer.advance(); }
+    bool at(TokenType type) const { return current().type == type; }
+
+    // Report a syntax error once; message carries its own punctuation
+    bool fail(const std::string& message) {
+        if (!failed) {
+            errorStream() << "Error: " << (at(TokenType::Invalid) ? "Unterminated string." : message) << "\n";
+        }
+        failed = true;
+        return false;
+    }
+
+    bool word(std::string& out) {
+        if (!at(TokenType::Word)) return false;
+        out = current().text;
+        advance();
+        return true;
+    }
+
+    // A quoted string, a ? parameter, or unquoted text up to the next ',' or ')'
+    // (words and operators, kept as written)
+    bool listValue(Literal& out) {
+        out = Literal();
+        if (at(TokenType::String)) {
+            out.text = current().text;
+            advance();
+            return true;
+        }
+        if (at(TokenType::Param)) {
+            out.param = static_cast<int>(current().param);
+            advance();
+            return true;
+        }
+        size_t start = current().start, end = start;
+        while (at(TokenType::Word) || at(TokenType::Op)) {
+            end = current().end;
+            advance();
+        }
+        if (end == start) return false;
+        out.text = lexer.source().substr(start, end - start);
+        return true;
+    }
+
+    // ( value, ... ) as in INSERT and EXECUTE
+    bool valueList(std::vector<Literal>& values) {
+        if (!at(TokenType::LParen)) return false;
+        advance();
+        while (true) {
+            Literal value;
+            if (!listValue(value)) return false;
+            values.push_back(std::move(value));
+            if (at(TokenType::RParen)) {
+                advance();
+                return true;
+            }
+            if (!at(TokenType::Comma)) return false;
+            advance();
+        }
+    }
+
+    bool where(Statement& statement) {
+        statement.where = parseWhere(lexer);
+        failed = failed || !statement.where;
+        return statement.where != nullptr;
+    }
+
+    bool createTable(Statement& statement) {
+        statement.kind = StatementKind::CreateTable;
+        if (!word(statement.table) || !at(TokenType::LParen)) return fail("Invalid syntax for CREATE TABLE.");
+        advance();
+        // Each column is "name [type]"; columns without a type are TEXT
+        while (true) {
+            std::string column, type_name;
+            if (!word(column)) return fail("Invalid syntax for CREATE TABLE.");
+            ColumnType type = ColumnType::Text;
+            if (word(type_name) && !parseColumnType(type_name, type)) {
+                return fail("Unknown type '" + type_name + "' for column " + column +
+                            ". Use INT, BIGINT, DOUBLE, TEXT or BOOL.");
+            }
+            statement.columns.push_back(column);
+            statement.types.push_back(type);
+            if (at(TokenType::RParen)) break;
+            if (!at(TokenType::Comma)) {
+                if (at(TokenType::End)) return fail("Invalid syntax for CREATE TABLE.");
+                return fail("Unexpected '" + current().text + "' after column " + column + ".");
+            }
+            advance();
+        }
+        advance();
+        // Optional storage layout after the column list: USING ROW | USING COLUMNAR
+        if (lexer.accept("USING")) {
+            if (lexer.accept("COLUMNAR")) {
+                statement.storage = StorageKind::Column;
+            } else if (!lexer.accept("ROW")) {
+                return fail("Invalid syntax. Use 'CREATE TABLE name (column [type], ...) [USING ROW|COLUMNAR]'.");
+            }
+        }
+        if (!at(TokenType::End)) {
+            return fail("Invalid syntax. Use 'CREATE TABLE name (column [type], ...) [USING ROW|COLUMNAR]'.");
+        }
+        return true;
+    }
+
+    bool createIndex(Statement& statement) {
+        // CREATE INDEX name ON table(column) [USING HASH|BTREE]
+        const char* usage = "Invalid syntax. Use 'CREATE INDEX name ON table(column) [USING HASH|BTREE]'.";
+        statement.kind = StatementKind::CreateIndex;
+        if (!word(statement.name) || !lexer.accept("ON") || !word(statement.table) || !at(TokenType::LParen)) {
+            return fail(usage);
+        }
+        advance();
+        if (!word(statement.column) || !at(TokenType::RParen)) return fail(usage);
+        advance();
+        if (lexer.accept("USING")) {
+            if (lexer.accept("BTREE")) {
+                statement.index_kind = IndexKind::BTree;
+            } else if (!lexer.accept("HASH")) {
+                return fail(usage);
+            }
+        }
+        return at(TokenType::End) || fail(usage);
+    }
+
+    bool insert(Statement& statement) {
+        statement.kind = StatementKind::Insert;
+        if (!lexer.accept("INTO") || !word(statement.table) || !lexer.accept("VALUES")) {
+            return fail("Invalid syntax. Use 'INSERT INTO table_name VALUES (...)'");
+        }
+        // Any number of rows: VALUES (...), (...), ...
+        while (true) {
+            statement.rows.emplace_back();
+            if (!valueList(statement.rows.back())) return fail("Invalid syntax for INSERT.");
+            if (!at(TokenType::Comma)) break;
+            advance();
+        }
+        return at(TokenType::End) || fail("Invalid syntax for INSERT.");
+    }
+
+    bool count(const std::string& keyword, size_t& out) {
+        const std::string& text = current().text;
+        if (!at(TokenType::Word) || text.find_first_not_of("0123456789") != std::string::npos || text.size() > 18) {
+            return fail(keyword + " expects a non-negative integer.");
+        }
+        out = std::stoull(text);
+        advance();
+        return true;
+    }
+
+    bool select(Statement& statement) {
+        statement.kind = StatementKind::Select;
+        // Listed columns and aggregates, up to FROM; commas between them are optional
+        while (!lexer.is("FROM")) {
+            std::string item;
+            if (at(TokenType::Comma)) {
+                advance();
+                continue;
+            }
+            if (!word(item)) return fail("Invalid syntax. Missing 'FROM'.");
+            if (!at(TokenType::LParen)) {
+                statement.columns.push_back(item);
+                continue;
+            }
+            // FUNC(arg), where arg may be DISTINCT column
+            advance();
+            std::string arg, part;
+            while (word(part)) arg += (arg.empty() ? "" : " ") + part;
+            if (!at(TokenType::RParen)) return fail("Invalid syntax. Missing 'FROM'.");
+            advance();
+            Aggregate aggregate;
+            if (!parseAggregate(item, arg, aggregate)) {
+                failed = true;
+                return false;
+            }
+            statement.aggregates.push_back(aggregate);
+        }
+        advance();
+        if (!word(statement.table)) return fail("Missing table name after 'FROM'.");
+        // '*' alone selects every column
+        if (statement.columns.size() == 1 && statement.columns[0] == "*") statement.columns.clear();
+
+        while (!at(TokenType::End)) {
+            if (lexer.accept("WHERE")) {
+                if (!where(statement)) return false;
+            } else if (lexer.accept("ORDER")) {
+                if (!lexer.accept("BY")) return fail("Invalid syntax after 'ORDER'. Did you mean 'ORDER BY'? ");
+                while (true) {
+                    std::string column;
+                    if (!word(column)) return fail("Invalid syntax after 'ORDER BY'. Expected a column.");
+                    std::string direction = "ASC";
+                    if (lexer.accept("DESC")) {
+                        direction = "DESC";
+                    } else {
+                        lexer.accept("ASC");
+                    }
+                    statement.order_by.emplace_back(column, direction);
+                    if (!at(TokenType::Comma)) break;
+                    advance();
+                }
+            } else if (lexer.accept("GROUP")) {
+                if (!lexer.accept("BY")) return fail("Invalid syntax after 'GROUP'. Did you mean 'GROUP BY'? ");
+                while (true) {
+                    std::string column;
+                    if (!word(column)) return fail("Invalid syntax after 'GROUP BY'. Expected a column.");
+                    statement.group_by.push_back(column);
+                    if (!at(TokenType::Comma)) break;
+                    advance();
+                }
+            } else if (lexer.accept("LIMIT")) {
+                if (!count("LIMIT", statement.limit)) return false;
+            } else if (lexer.accept("OFFSET")) {
+                if (!count("OFFSET", statement.offset)) return false;
+            } else {
+                return fail("Unrecognized clause '" + current().text + "'.");
+            }
+        }
+        return true;
+    }
+
+    bool update(Statement& statement) {
+        statement.kind = StatementKind::Update;
+        if (!word(statement.table) || !lexer.accept("SET")) return fail("Invalid syntax. Did you mean 'SET'? ");
+        if (!word(statement.column) || !at(TokenType::Op) || current().text != "=") {
+            return fail("Invalid syntax for SET. Expected '='.");
+        }
+        advance();
+        if (at(TokenType::String) || at(TokenType::Word)) {
+            statement.value.text = current().text;
+        } else if (at(TokenType::Param)) {
+            statement.value.param = static_cast<int>(current().param);
+        } else {
+            return fail("Invalid syntax for SET. Expected a value after '='.");
+        }
+        advance();
+        if (at(TokenType::End)) return true;
+        if (!lexer.accept("WHERE")) return fail("Unrecognized clause '" + current().text + "' in UPDATE.");
+        return where(statement) && (at(TokenType::End) || fail("Unexpected '" + current().text + "' in UPDATE."));
+    }
+
+    bool deleteFrom(Statement& statement) {
+        statement.kind = StatementKind::Delete;
+        if (!lexer.accept("FROM") || !word(statement.table)) {
+            return fail("Invalid syntax. Did you mean 'DELETE FROM'? ");
+        }
+        if (at(TokenType::End)) return true;
+        if (!lexer.accept("WHERE")) return fail("Unrecognized clause '" + current().text + "' in DELETE.");
+        return where(statement) && (at(TokenType::End) || fail("Unexpected '" + current().text + "' in DELETE."));
+    }
+
+    bool copy(Statement& statement) {
+        // COPY table FROM 'file.csv' [HEADER]
+        const char* usage = "Invalid syntax. Use 'COPY table FROM 'file.csv' [HEADER]'.";
+        statement.kind = StatementKind::Copy;
+        if (!word(statement.table) || !lexer.accept("FROM") || !at(TokenType::String)) return fail(usage);
+        statement.value.text = current().text;
+        advance();
+        statement.header = lexer.accept("HEADER");
+        return at(TokenType::End) || fail(usage);
+    }
+
+    bool prepare(Statement& statement) {
+        // PREPARE name AS statement, with ? for each parameter
+        statement.kind = StatementKind::Prepare;
+        if (!word(statement.name) || !lexer.accept("AS")) {
+            return fail("Invalid syntax. Use 'PREPARE name AS statement'.");
+        }
+        statement.body = std::make_unique<Statement>();
+        if (!parse(*statement.body)) return false;
+        StatementKind kind = statement.body->kind;
+        if (kind != StatementKind::Select && kind != StatementKind::Insert && kind != StatementKind::Update &&
+            kind != StatementKind::Delete) {
+            return fail("Only SELECT, INSERT, UPDATE and DELETE statements can be prepared.");
+        }
+        return true;
+    }
+
+    bool explain(Statement& statement) {
+        // EXPLAIN [ANALYZE] SELECT ... or EXECUTE name(...) of a prepared SELECT
+        statement.kind = StatementKind::Explain;
+        statement.analyze = lexer.accept("ANALYZE");
+        statement.body = std::make_unique<Statement>();
+        if (!parse(*statement.body)) return false;
+        StatementKind kind = statement.body->kind;
+        if (kind != StatementKind::Select && kind != StatementKind::Execute) {
+            return fail("Only SELECT statements can be explained.");
+        }
+        return true;
+    }
+
+    bool execute(Statement& statement) {
+        // EXECUTE name [(value, ...)]
+        statement.kind = StatementKind::Execute;
+        const char* usage = "Invalid syntax. Use 'EXECUTE name(value, ...)'.";
+        if (!word(statement.name)) return fail(usage);
+        if (at(TokenType::LParen)) {
+            std::vector<Literal> values;
+            if (!valueList(values)) return fail(usage);
+            for (const auto& value : values) {
+                if (value.param >= 0) return fail(usage);
+                statement.args.push_back(value.text);
+            }
+        }
+        return at(TokenType::End) || fail(usage);
+    }
+
+    // The end of a statement, optionally after a noise word (COMMIT TRANSACTION)
+    bool bare(Statement& statement, StatementKind kind, const char* noise = nullptr) {
+        statement.kind = kind;
+        if (noise) lexer.accept(noise);
+        return at(TokenType::End) || fail("Unexpected '" + current().text + "'.");
+    }
+
+public:
+    explicit StatementParser(Lexer& lexer) : lexer(lexer) {}
+
+    bool parse(Statement& statement) {
+        std::string command;
+        if (!word(command)) return fail("Unrecognized command.");
+        for (auto& c : command) c = static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+        if (command == "CREATE") {
+            if (lexer.accept("INDEX")) return createIndex(statement);
+            if (lexer.accept("TABLE")) return createTable(statement);
+            return fail("Invalid syntax. Did you mean 'CREATE TABLE'? ");
+        }
+        if (command == "INSERT") return insert(statement);
+        if (command == "SELECT") return select(statement);
+        if (command == "UPDATE") return update(statement);
+        if (command == "DELETE") return deleteFrom(statement);
+        if (command == "COPY") return copy(statement);
+        if (command == "SHOW") {
+            statement.kind = StatementKind::Show;
+            if (!word(statement.name)) return fail("Invalid syntax. Use 'SHOW TABLES', 'SHOW STATS' or 'SHOW table'.");
+            return bare(statement, StatementKind::Show);
+        }
+        if (command == "DESCRIBE") {
+            statement.kind = StatementKind::Describe;
+            if (!word(statement.table)) return fail("Missing table name for DESCRIBE.");
+            return bare(statement, StatementKind::Describe);
+        }
+        if (command == "BEGIN") {
+            if (!lexer.accept("TRANSACTION")) return fail("Invalid syntax. Use 'BEGIN TRANSACTION'.");
+            return bare(statement, StatementKind::Begin);
+        }
+        if (command == "COMMIT") return bare(statement, StatementKind::Commit, "TRANSACTION");
+        if (command == "ROLLBACK") return bare(statement, StatementKind::Rollback, "TRANSACTION");
+        if (command == "CHECKPOINT") return bare(statement, StatementKind::Checkpoint);
+        if (command == "SET") {
+            // SET setting value; the executor checks both
+            statement.kind = StatementKind::Set;
+            word(statement.name);
+            if (at(TokenType::Word) || at(TokenType::String)) {
+                statement.value.text = current().text;
+                advance();
+            }
+            return bare(statement, StatementKind::Set);
+        }
+        if (command == "PREPARE") return prepare(statement);
+        if (command == "EXECUTE") return execute(statement);
+        if (command == "EXPLAIN") return explain(statement);
+        if (command == "DEALLOCATE") {
+            statement.kind = StatementKind::Deallocate;
+            lexer.accept("PREPARE");
+            if (!word(statement.name)) return fail("Invalid syntax. Use 'DEALLOCATE name'.");
+            return bare(statement, StatementKind::Deallocate);
+        }
+        return fail("Unrecognized command.");
+    }
+};
+
+} // namespace
+
+bool parseStatement(const std::string& text, Statement& statement) {
+    statement = Statement();
+    Lexer lexer(text);
+    StatementParser parser(lexer);
+    if (!parser.parse(statement)) return false;
+    statement.param_count = lexer.parameterCount();
+    if (statement.body) statement.body->param_count = statement.param_count;
+    if (statement.param_count > 0 && statement.kind != StatementKind::Prepare) {
+        errorStream() << "Error: Parameters (?) are only allowed in a PREPARE statement.\n";
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,73 @@
+// Statement.hpp
+#ifndef STATEMENT_HPP
+#define STATEMENT_HPP
+
+#include "Aggregate.hpp"
+#include "Expression.hpp"
+#include "Index.hpp"
+#include "TableFile.hpp"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+enum class StatementKind {
+    CreateTable,
+    CreateIndex,
+    Insert,
+    Select,
+    Update,
+    Delete,
+    Copy,
+    Show,
+    Describe,
+    Begin,
+    Commit,
+    Rollback,
+    Checkpoint,
+    Set,
+    Prepare,
+    Execute,
+    Deallocate,
+    Explain
+};
+
+// A value as written, or the ? parameter that stands for it
+struct Literal {
+    std::string text;
+    int param = -1;
+};
+
+// One parsed statement. Like Expr it is a single node type whose fields are
+// used according to its kind; names are as written and resolved by the planner.
+struct Statement {
+    StatementKind kind = StatementKind::Select;
+    std::string table;
+    std::string name;                  // CREATE INDEX, PREPARE, EXECUTE, DEALLOCATE: the name;
+                                       // SHOW: TABLES, STATS or a table; SET: the setting
+    std::vector<std::string> columns;  // CREATE TABLE: the columns; SELECT: the listed columns
+    std::vector<ColumnType> types;     // CREATE TABLE
+    StorageKind storage = StorageKind::Row;
+    std::string column;                // CREATE INDEX: the indexed column; UPDATE: the SET column
+    IndexKind index_kind = IndexKind::Hash;
+    std::vector<std::vector<Literal>> rows; // INSERT
+    std::vector<Aggregate> aggregates;      // SELECT
+    std::vector<std::pair<std::string, std::string>> order_by; // column, ASC or DESC
+    std::vector<std::string> group_by;
+    size_t limit = SIZE_MAX;
+    size_t offset = 0;
+    ExprPtr where;                     // SELECT, UPDATE, DELETE; null for none
+    Literal value;                     // UPDATE: the SET value; SET: the value; COPY: the file
+    bool header = false;               // COPY ... HEADER
+    std::vector<std::string> args;     // EXECUTE: the parameter values
+    std::unique_ptr<Statement> body;   // PREPARE, EXPLAIN: the statement
+    bool analyze = false;              // EXPLAIN ANALYZE
+    size_t param_count = 0;            // ? placeholders in the statement
+};
+
+// Parse one statement (a trailing ';' is optional). Keywords are case-insensitive.
+// Reports a syntax error and returns false.
+bool parseStatement(const std::string& text, Statement& statement);
+
+#endif // STATEMENT_HPP
@@ -1,451 +1,1145 @@
 // Table.cpp
 #include "Table.hpp"
-#include <sstream>
+#include "BTreeIndex.hpp"
+#include "Diagnostics.hpp"
+#include "FilterKernels.hpp"
+#include "HashIndex.hpp"
+#include "MemoryStats.hpp"
+#include "ThreadPool.hpp"
+#include "WriteAheadLog.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
 #include <algorithm>
-#include <map>
+#include <iterator>
+#include <unordered_map>
 #include <iomanip>
+#include <sstream>
 
-// Initialize DATA_DIR as a constant
-const std::string DATA_DIR = "data/";
 
-Table::Table(const std::string& name, const std::vector<std::string>& columns) : name(name), columns(columns) {
-    filepath = DATA_DIR + name + ".tbl";
+Table::Table(const std::string& name, const std::vector<std::string>& columns, const std::vector<ColumnType>& types,
+             StorageKind storage, const std::string& dir)
+    : name(name), columns(columns), types(types), data_dir(dir), storage(storage), column_store(types) {
+    filepath = data_dir + name + ".tbl";
     save(); // Save table schema
 }
 
-Table::Table(const std::string& name) : name(name) {
-    filepath = DATA_DIR + name + ".tbl";
+Table::Table(const std::string& name, const std::string& dir) : name(name), data_dir(dir) {
+    filepath = data_dir + name + ".tbl";
     load();
 }
 
-void Table::insert(const std::vector<std::string>& fields) {
-    if (fields.size() != columns.size()) {
-        std::cerr << "Error: Field count doesn't match column count.\n";
+static std::unique_ptr<Index> makeIndex(IndexKind kind, const std::string& name, int column, ColumnType type) {
+    if (kind == IndexKind::BTree) return std::make_unique<BTreeIndex>(name, column, type);
+    return std::make_unique<HashIndex>(name, column);
+}
+
+int Table::columnIndex(const std::string& column) const {
+    auto it = std::find(columns.begin(), columns.end(), column);
+    return it == columns.end() ? -1 : static_cast<int>(std::distance(columns.begin(), it));
+}
+
+Index* Table::findIndex(int column, IndexKind kind) const {
+    for (const auto& index : indexes) {
+        if (index->getColumn() == column && index->kind() == kind) return index.get();
+    }
+    return nullptr;
+}
+
+Index* Table::indexOn(int column, IndexKind kind) {
+    Index* index = findIndex(column, kind);
+    if (!index || index->isBuilt()) return index;
+    std::lock_guard<std::mutex> lock(lazy_mutex);
+    if (!index->isBuilt()) {
+        ensureRowIndexLocked();
+        index->build(rowCount(), [&](size_t row) { return fieldAt(row, column); });
+    }
+    return index;
+}
+
+bool Table::encodeField(size_t col, const std::string& text, std::string& out) const {
+    if (encodeValue(types[col], text, out)) return true;
+    errorStream() << "Error: Invalid " << columnTypeName(types[col]) << " value '" << text << "' for column "
+              << columns[col] << ".\n";
+    return false;
+}
+
+bool Table::compileWhere(const Expr* where, Predicate& predicate) const {
+    predicate = Predicate();
+    return !where || predicate.compile(*where, columns, types);
+}
+
+std::vector<size_t> Table::hiddenRows(const Snapshot& snapshot) const {
+    std::vector<size_t> hidden;
+    for (const auto& entry : stamps) {
+        if (!snapshot.sees(entry.second)) hidden.push_back(entry.first);
+    }
+    std::sort(hidden.begin(), hidden.end());
+    return hidden;
+}
+
+void Table::prepareScan(const Predicate& where, const Snapshot& snapshot, Scan& scan) const {
+    scan.where = &where;
+    scan.hidden = hiddenRows(snapshot);
+}
+
+// Bounds of a condition as BTreeIndex::range() takes them
+static void conditionBounds(const Condition& where, const std::string*& lo, bool& lo_inclusive,
+                            const std::string*& hi, bool& hi_inclusive) {
+    lo = hi = nullptr;
+    lo_inclusive = hi_inclusive = true;
+    switch (where.op) {
+        case CompareOp::Eq: lo = hi = &where.value; break;
+        case CompareOp::Lt: hi = &where.value; hi_inclusive = false; break;
+        case CompareOp::Le: hi = &where.value; break;
+        case CompareOp::Gt: lo = &where.value; lo_inclusive = false; break;
+        case CompareOp::Ge: lo = &where.value; break;
+        case CompareOp::Between: lo = &where.value; hi = &where.value2; break;
+        case CompareOp::Ne: break; // never passed in: not a range
+    }
+}
+
+const Predicate::Term* Table::indexTerm(const Predicate& where, IndexKind& kind) const {
+    std::vector<const Predicate::Term*> terms = where.conjuncts();
+    for (const Predicate::Term* term : terms) {
+        if (term->condition.op == CompareOp::Eq && findIndex(term->column, IndexKind::Hash)) {
+            kind = IndexKind::Hash;
+            return term;
+        }
+    }
+    for (const Predicate::Term* term : terms) {
+        if (findIndex(term->column, IndexKind::BTree)) {
+            kind = IndexKind::BTree;
+            return term;
+        }
+    }
+    return nullptr;
+}
+
+void Table::indexLookup(const Predicate::Term& term, IndexKind kind, std::vector<size_t>& rows) {
+    Index* index = indexOn(term.column, kind);
+    if (kind == IndexKind::Hash) {
+        rows = index->lookup(term.condition.value);
         return;
     }
-    records.emplace_back(fields);
+    const std::string *lo, *hi;
+    bool lo_inclusive, hi_inclusive;
+    conditionBounds(term.condition, lo, lo_inclusive, hi, hi_inclusive);
+    rows.clear();
+    static_cast<BTreeIndex*>(index)->range(lo, lo_inclusive, hi, hi_inclusive, false, [&](size_t row) {
+        rows.push_back(row);
+        return true;
+    });
+    // Index order is value order; callers expect scan order
+    std::sort(rows.begin(), rows.end());
 }
 
-void Table::select(const std::vector<std::string>& select_columns, 
-                  const std::vector<std::pair<std::string, std::string>>& aggregates,
-                  const std::string& where_column, 
-                  const std::string& where_value,
+void Table::indexOrder(int column, bool descending, const Predicate::Term* bound, const std::vector<size_t>& hidden,
+                       size_t limit, std::vector<size_t>& rows) {
+    // Rows come out of the index already ordered, so there is nothing to sort
+    const std::string *lo = nullptr, *hi = nullptr;
+    bool lo_inclusive = true, hi_inclusive = true;
+    if (bound) conditionBounds(bound->condition, lo, lo_inclusive, hi, hi_inclusive);
+    rows.clear();
+    if (limit == 0) return;
+    auto* btree = static_cast<BTreeIndex*>(indexOn(column, IndexKind::BTree));
+    btree->range(lo, lo_inclusive, hi, hi_inclusive, descending, [&](size_t row) {
+        if (hidden.empty() || !std::binary_search(hidden.begin(), hidden.end(), row)) rows.push_back(row);
+        return rows.size() < limit;
+    });
+}
+
+bool Table::indexMatches(const Scan& scan, std::vector<size_t>& rows) {
+    const Predicate& where = *scan.where;
+    IndexKind kind;
+    const Predicate::Term* term = indexTerm(where, kind);
+    if (!term) return false;
+    indexLookup(*term, kind, rows);
+    if (!where.single()) {
+        // The index answered one comparison; the rest of the predicate still applies
+        size_t kept = 0;
+        for (size_t row : rows) {
+            if (where.matches([&](int col) { return fieldAt(row, col); })) rows[kept++] = row;
+        }
+        rows.resize(kept);
+    }
+    dropHidden(scan.hidden, rows, 0);
+    return true;
+}
+
+void Table::filterRange(const Scan& scan, size_t begin, size_t end, std::vector<size_t>& rows) const {
+    const Predicate& where = *scan.where;
+    size_t first = rows.size();
+    const Predicate::Term* term = where.single();
+    if (where.empty()) {
+        for (size_t r = begin; r < end; ++r) rows.push_back(r);
+    } else if (storage == StorageKind::Column) {
+        // Reads only the referenced columns: a selection bitmap per term, from SIMD
+        // kernels on fixed-width columns, combined word by word
+        std::vector<uint64_t> bits(bitmapWords(end - begin));
+        where.select(column_store, begin, end, bits.data());
+        appendSelectedRows(bits.data(), end - begin, begin, rows);
+    } else if (term) {
+        for (size_t r = begin; r < end; ++r) {
+            if (term->condition.matches(records[r].field(term->column))) rows.push_back(r);
+        }
+    } else {
+        for (size_t r = begin; r < end; ++r) {
+            const Record& record = records[r];
+            if (where.matches([&](int col) { return record.field(col); })) rows.push_back(r);
+        }
+    }
+    dropHidden(scan.hidden, rows, first);
+}
+
+std::vector<size_t> Table::matchRows(const Scan& scan, size_t limit) {
+    std::vector<size_t> rows;
+    if (scan.where->empty() && scan.hidden.empty()) {
+        rows.resize(std::min(limit, rowCount()));
+        for (size_t r = 0; r < rows.size(); ++r) rows[r] = r;
+        return rows;
+    }
+    if (!scan.where->empty() && indexMatches(scan, rows)) {
+        if (rows.size() > limit) rows.resize(limit);
+        return rows;
+    }
+    // Each morsel is filtered on its own thread; concatenating in row order keeps
+    // ids ascending. Once the rows in hand reach the limit, morsels not yet
+    // started are skipped.
+    std::atomic<bool> enough{false};
+    ThreadPool::shared().parallelForOrdered<std::vector<size_t>>(morselCount(rowCount()), [&](size_t morsel) {
+        std::vector<size_t> part;
+        if (enough.load(std::memory_order_relaxed)) return part;
+        size_t begin = morsel * MORSEL_ROWS;
+        filterRange(scan, begin, std::min(rowCount(), begin + MORSEL_ROWS), part);
+        return part;
+    }, [&](std::vector<size_t>& part) {
+        if (rows.size() >= limit) return;
+        rows.insert(rows.end(), part.begin(), part.end());
+        if (rows.size() >= limit) enough = true;
+    });
+    if (rows.size() > limit) rows.resize(limit);
+    return rows;
+}
+
+bool Table::insert(const std::vector<std::string>& fields, const Snapshot& snapshot) {
+    // The strings keep their capacity, so copying a row costs no allocation here
+    scratch.assign(fields.begin(), fields.end());
+    return insertValues(scratch, snapshot);
+}
+
+bool Table::insert(std::vector<std::string>&& fields, const Snapshot& snapshot) {
+    return insertValues(fields, snapshot);
+}
+
+bool Table::insertValues(std::vector<std::string>& values, const Snapshot& snapshot) {
+    if (values.size() != columns.size()) {
+        errorStream() << "Error: Field count doesn't match column count.\n";
+        return false;
+    }
+    // Validated and converted once here; everything downstream works on stored
+    // values. A TEXT value is stored as it is; the others fit a string's inline buffer.
+    std::string converted;
+    for (size_t c = 0; c < values.size(); ++c) {
+        if (types[c] == ColumnType::Text) continue;
+        if (!encodeField(c, values[c], converted)) return false;
+        values[c].swap(converted);
+    }
+    if (!ensureRowIndex()) return false;
+    if (recording_undo && (undo_log.empty() || undo_log.back().kind != UndoEntry::Kind::Insert)) {
+        // One entry covers a run of inserts: they all sit at the end of the table
+        UndoEntry entry;
+        entry.kind = UndoEntry::Kind::Insert;
+        entry.row_count = rowCount();
+        undo_log.push_back(std::move(entry));
+    }
+    for (auto& index : indexes) {
+        if (index->isBuilt()) index->insert(values[index->getColumn()], rowCount());
+    }
+    if (snapshot.txn != 0) {
+        // Seen only by its own transaction until that commits
+        RowStamp& stamp = stamps[rowCount()];
+        stamp.created = snapshot.ownStamp();
+    }
+    if (storage == StorageKind::Column) {
+        column_store.append(values);
+    } else {
+        records.push_back(row_arena.append(values));
+    }
+    dirty = true;
+    return true;
+}
+
+bool Table::insertRows(const std::vector<std::vector<std::string>>& rows, const Snapshot& snapshot) {
+    std::vector<RowBatch> batches(1);
+    RowBatch& batch = batches.front();
+    if (storage == StorageKind::Column) {
+        batch.columns = ColumnStore(types);
+        batch.columns.reserve(rows.size());
+    } else {
+        batch.records.reserve(rows.size());
+    }
+    std::vector<std::string> values(columns.size());
+    for (size_t r = 0; r < rows.size(); ++r) {
+        // Errors name the row only when there is more than one
+        std::string in_row = rows.size() > 1 ? " in row " + std::to_string(r + 1) : "";
+        if (rows[r].size() != columns.size()) {
+            errorStream() << "Error: Field count doesn't match column count" << in_row << ".\n";
+            return false;
+        }
+        for (size_t c = 0; c < columns.size(); ++c) {
+            if (!encodeValue(types[c], rows[r][c], values[c])) {
+                errorStream() << "Error: Invalid " << columnTypeName(types[c]) << " value '" << rows[r][c]
+                          << "' for column " << columns[c] << in_row << ".\n";
+                return false;
+            }
+        }
+        if (storage == StorageKind::Column) {
+            batch.columns.append(values);
+        } else {
+            batch.records.push_back(batch.arena.append(values));
+        }
+    }
+    appendRows(batches, snapshot);
+    return true;
+}
+
+size_t Table::appendRows(std::vector<RowBatch>& batches, const Snapshot& snapshot) {
+    size_t added = 0;
+    for (const auto& batch : batches) added += batch.size();
+    if (added == 0 || !ensureRowIndex()) return 0;
+    if (recording_undo && (undo_log.empty() || undo_log.back().kind != UndoEntry::Kind::Insert)) {
+        UndoEntry entry;
+        entry.kind = UndoEntry::Kind::Insert;
+        entry.row_count = rowCount();
+        undo_log.push_back(std::move(entry));
+    }
+    size_t first = rowCount();
+    if (storage == StorageKind::Column) {
+        column_store.reserve(first + added);
+        for (const auto& batch : batches) column_store.append(batch.columns);
+    } else {
+        // Grown geometrically, since single-row INSERTs come through here too
+        if (records.capacity() < first + added) records.reserve(std::max(first + added, records.capacity() * 2));
+        for (auto& batch : batches) {
+            if (batch.arena.stats().used < RowArena::SLAB_BYTES) {
+                // A small batch is copied in rather than keep a mostly empty slab of its own
+                for (const auto& record : batch.records) records.push_back(row_arena.append(record));
+                continue;
+            }
+            std::move(batch.records.begin(), batch.records.end(), std::back_inserter(records));
+            row_arena.adopt(std::move(batch.arena));
+        }
+    }
+    batches.clear();
+    for (auto& index : indexes) {
+        if (!index->isBuilt()) continue;
+        for (size_t row = first; row < rowCount(); ++row) index->insert(fieldAt(row, index->getColumn()), row);
+    }
+    if (snapshot.txn != 0) {
+        for (size_t row = first; row < rowCount(); ++row) stamps[row].created = snapshot.ownStamp();
+    }
+    dirty = true;
+    return added;
+}
+
+bool Table::createIndex(const std::string& index_name, const std::string& column, IndexKind kind) {
+    if (!ensureRowIndex()) return false;
+    int col = columnIndex(column);
+    if (col < 0) {
+        errorStream() << "Error: Column " << column << " does not exist.\n";
+        return false;
+    }
+    for (const auto& index : indexes) {
+        if (index->getName() == index_name) {
+            errorStream() << "Error: Index " << index_name << " already exists on " << name << ".\n";
+            return false;
+        }
+        if (index->getColumn() == col && index->kind() == kind) {
+            errorStream() << "Error: Column " << column << " is already indexed by " << index->getName() << ".\n";
+            return false;
+        }
+    }
+    indexes.push_back(makeIndex(kind, index_name, col, types[col]));
+    indexOn(col, kind);
+    dirty = true;
+    return true;
+}
+
+std::unique_ptr<Cursor> Table::select(const std::vector<std::string>& select_columns,
+                  const std::vector<Aggregate>& aggregates,
+                  const Expr* where,
                   const std::vector<std::pair<std::string, std::string>>& order_by,
-                  const std::vector<std::string>& group_by) {
-    // Determine columns to display
-    std::vector<int> col_indices;
+                  const std::vector<std::string>& group_by,
+                  size_t limit, size_t offset, const Snapshot& snapshot) {
+    SelectQuery query;
+    if (!planSelect(select_columns, aggregates, where, order_by, group_by, limit, offset, query)) return nullptr;
+    return select(query, snapshot);
+}
+
+bool Table::planSelect(const std::vector<std::string>& select_columns, const std::vector<Aggregate>& aggregates,
+                       const Expr* where, const std::vector<std::pair<std::string, std::string>>& order_by,
+                       const std::vector<std::string>& group_by, size_t limit, size_t offset,
+                       SelectQuery& query) const {
+    query = SelectQuery();
     // If selected_columns is empty (SELECT *), use all columns
     if (select_columns.empty()) {
-        col_indices.resize(columns.size());
+        query.columns.resize(columns.size());
         for (size_t i = 0; i < columns.size(); ++i) {
-            col_indices[i] = i;
+            query.columns[i] = i;
         }
     } else {
         for (const auto& col : select_columns) {
-            auto it = std::find(columns.begin(), columns.end(), col);
-            if (it != columns.end()) {
-                col_indices.push_back(std::distance(columns.begin(), it));
-            } else {
-                std::cerr << "Error: Column " << col << " does not exist.\n";
-                return;
+            int idx = columnIndex(col);
+            if (idx < 0) {
+                errorStream() << "Error: Column " << col << " does not exist.\n";
+                return false;
             }
+            query.columns.push_back(idx);
         }
     }
 
-    // Handle GROUP BY
-    if (!group_by.empty()) {
-        // Ensure all group_by columns exist
-        std::vector<int> group_indices;
-        for (const auto& gb_col : group_by) {
-            auto it = std::find(columns.begin(), columns.end(), gb_col);
-            if (it != columns.end()) {
-                group_indices.push_back(std::distance(columns.begin(), it));
-            } else {
-                std::cerr << "Error: GROUP BY column " << gb_col << " does not exist.\n";
-                return;
-            }
+    // Resolve WHERE columns and convert its literals once instead of per row
+    if (!compileWhere(where, query.where)) return false;
+    if (where) query.where_text = exprToString(*where);
+
+    // Resolve aggregate targets once; -1 stands for COUNT(*)
+    for (const auto& agg : aggregates) {
+        int idx = agg.column == "*" ? -1 : columnIndex(agg.column);
+        if (idx < 0 && agg.column != "*") {
+            errorStream() << "Error: Column " << agg.column << " in " << agg.label() << " does not exist.\n";
+            return false;
         }
+        query.agg_columns.push_back(idx);
+    }
+    query.aggregates = aggregates;
 
-        // Prepare aggregate functions
-        std::vector<std::pair<std::string, int>> agg_functions; // function name and column index (-1 for COUNT(*))
-        for (const auto& agg : aggregates) {
-            std::string func = agg.first;
-            std::string target = agg.second;
-            std::transform(func.begin(), func.end(), func.begin(), ::toupper);
-            if (func == "COUNT") {
-                if (target == "*" ) {
-                    agg_functions.emplace_back(func, -1);
-                } else {
-                    auto it = std::find(columns.begin(), columns.end(), target);
-                    if (it != columns.end()) {
-                        agg_functions.emplace_back(func, std::distance(columns.begin(), it));
-                    } else {
-                        std::cerr << "Error: COUNT target column " << target << " does not exist.\n";
-                        return;
-                    }
-                }
-            }
-            else {
-                std::cerr << "Error: Unsupported aggregate function '" << func << "'.\n";
-                return;
+    for (const auto& gb_col : group_by) {
+        int idx = columnIndex(gb_col);
+        if (idx < 0) {
+            errorStream() << "Error: GROUP BY column " << gb_col << " does not exist.\n";
+            return false;
+        }
+        query.group_by.push_back(idx);
+    }
+    // Grouped output is listed in group order, so ORDER BY only applies without GROUP BY
+    if (group_by.empty()) {
+        for (const auto& ob : order_by) {
+            int idx = columnIndex(ob.first);
+            if (idx < 0) {
+                errorStream() << "Error: ORDER BY column " << ob.first << " does not exist.\n";
+                return false;
             }
+            query.order_by.emplace_back(idx, ob.second == "DESC");
         }
+    }
+    query.limit = limit;
+    query.offset = offset;
+    return true;
+}
 
-        // Group records
-        std::map<std::string, std::vector<Record>> grouped_records;
-        for (const auto& record : records) {
-            bool match = true;
-            if (!where_column.empty()) {
-                auto it = std::find(columns.begin(), columns.end(), where_column);
-                if (it != columns.end()) {
-                    int idx = std::distance(columns.begin(), it);
-                    if (record.fields[idx] != where_value) {
-                        match = false;
-                    }
-                } else {
-                    std::cerr << "Error: WHERE column " << where_column << " does not exist.\n";
-                    return;
-                }
-            }
-            if (match) {
-                std::string key;
-                for (const auto& idx : group_indices) {
-                    key += record.fields[idx] + "_";
-                }
-                grouped_records[key].emplace_back(record);
-            }
+std::vector<std::unique_ptr<Operator>> Table::planOperators(const SelectQuery& query, const Snapshot& snapshot,
+                                                            Cursor& cursor) {
+    const Predicate& where = query.where;
+    bool grouped = !query.group_by.empty();
+    // Result rows up to the end of the LIMIT window (SIZE_MAX without one)
+    size_t wanted = query.limit > SIZE_MAX - query.offset ? SIZE_MAX : query.offset + query.limit;
+    // Totals of aggregates cover every matching row, so only a plain listing can
+    // stop at the end of the LIMIT window
+    size_t fetch = query.aggregates.empty() && !grouped ? wanted : SIZE_MAX;
+
+    std::vector<std::unique_ptr<Operator>> operators;
+    bool filtered = where.empty();
+    bool ordered = query.order_by.empty();
+    IndexKind kind = IndexKind::Hash;
+    const Predicate::Term* term = where.empty() ? nullptr : indexTerm(where, kind);
+    // A B+tree on the only ORDER BY column hands out rows already sorted, unless
+    // another index narrows down the WHERE
+    if (!ordered && query.order_by.size() == 1 && findIndex(query.order_by[0].first, IndexKind::BTree)) {
+        int column = query.order_by[0].first;
+        const Predicate::Term* single = where.single();
+        const Predicate::Term* bound =
+            single && single->column == column && single->condition.op != CompareOp::Ne ? single : nullptr;
+        if (filtered || bound || !term) {
+            auto scan = std::make_unique<ScanOp>(*this, snapshot, ScanOp::Mode::IndexOrder);
+            scan->useOrder(column, query.order_by[0].second, bound, filtered || bound ? fetch : SIZE_MAX);
+            operators.push_back(std::move(scan));
+            filtered = filtered || bound;
+            ordered = true;
         }
+    }
+    if (operators.empty() && term) {
+        auto scan = std::make_unique<ScanOp>(*this, snapshot, ScanOp::Mode::Index);
+        scan->useIndex(term, kind);
+        operators.push_back(std::move(scan));
+        // The index answers the whole WHERE when it is that one comparison
+        filtered = where.single() != nullptr;
+    } else if (operators.empty()) {
+        operators.push_back(std::make_unique<ScanOp>(*this, snapshot, ScanOp::Mode::Sequential));
+    }
+    if (!filtered) {
+        operators.push_back(std::make_unique<FilterOp>(*this, where, query.where_text, ordered ? fetch : SIZE_MAX));
+    }
+
+    if (grouped) {
+        // Grouped output is listed in order of the group values
+        std::vector<std::pair<int, bool>> group_order;
+        for (int idx : query.group_by) group_order.emplace_back(idx, false);
+        operators.push_back(std::make_unique<AggregateOp>(*this, query.group_by, query.aggregates, query.agg_columns));
+        operators.push_back(std::make_unique<SortOp>(*this, std::move(group_order), wanted));
+    } else if (!ordered) {
+        operators.push_back(std::make_unique<SortOp>(*this, query.order_by, fetch));
+    }
 
-        // Print header
-        for (size_t i = 0; i < group_by.size(); ++i) {
-            std::cout << std::left << std::setw(15) << group_by[i];
-            if (i != group_by.size() - 1 || !agg_functions.empty()) std::cout << " | ";
+    operators.push_back(std::make_unique<ProjectOp>(*this, query, cursor));
+    operators.push_back(std::make_unique<OutputOp>());
+    return operators;
+}
+
+std::unique_ptr<Cursor> Table::select(const SelectQuery& query, const Snapshot& snapshot) {
+    std::unique_ptr<Cursor> cursor(new Cursor(*this, query, snapshot));
+    cursor->operators = planOperators(*cursor->query, cursor->snapshot, *cursor);
+    // The output is the client reading the cursor
+    for (size_t i = 0; i + 1 < cursor->operators.size(); ++i) cursor->operators[i]->execute(cursor->flow, false);
+    cursor->fetch();
+    return cursor;
+}
+
+void Table::explain(const SelectQuery& query, bool analyze, const Snapshot& snapshot) {
+    std::unique_ptr<Cursor> cursor(new Cursor(*this, query, snapshot));
+    std::vector<std::unique_ptr<Operator>>& operators = cursor->operators;
+    operators = planOperators(*cursor->query, cursor->snapshot, *cursor);
+    double total = 0;
+    if (analyze) {
+        RowFlow& flow = cursor->flow;
+        flow.row_count = rowCount();
+        for (size_t i = 0; i + 1 < operators.size(); ++i) operators[i]->execute(flow, true);
+        // Read the result the way the REPL prints it
+        OperatorStats output;
+        output.rows_in = flow.size();
+        auto start = std::chrono::steady_clock::now();
+        uint64_t bytes = allocatedBytes();
+        cursor->fetch();
+        while (cursor->next()) {
+            for (size_t col = 0; col < cursor->columnCount(); ++col) cursor->getText(col);
+            ++output.rows_out;
         }
-        for (size_t i = 0; i < agg_functions.size(); ++i) {
-            std::cout << std::left << std::setw(15) << (agg_functions[i].second == -1 ? "COUNT(*)" : "COUNT(" + columns[agg_functions[i].second] + ")");
-            if (i != agg_functions.size() - 1) std::cout << " | ";
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        output.seconds = elapsed.count();
+        output.bytes = allocatedBytes() - bytes;
+        static_cast<OutputOp&>(*operators.back()).record(output);
+        for (const auto& op : operators) total += op->stats().seconds;
+    }
+    // Like the plan of a tree: the operator producing the result first
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(3);
+    for (size_t i = operators.size(); i-- > 0;) {
+        size_t depth = operators.size() - 1 - i;
+        out << std::string(depth * 2, ' ') << (depth ? "-> " : "") << operators[i]->describe();
+        if (analyze) {
+            const OperatorStats& stats = operators[i]->stats();
+            out << "  (time=" << stats.seconds * 1000 << " ms, rows in=" << stats.rows_in
+                << ", out=" << stats.rows_out;
+            if (allocationsCounted()) out << ", allocated=" << stats.bytes << " bytes";
+            out << ")";
         }
-        std::cout << "\n";
+        out << "\n";
+    }
+    if (analyze) {
+        out << "Execution time: " << total * 1000 << " ms\n";
+        if (allocationsCounted()) out << "Allocated bytes are process-wide: other sessions' allocations count too\n";
+    }
+    messageStream() << out.str();
+}
 
-        // Print separator
-        for (size_t i = 0; i < group_by.size(); ++i) {
-            std::cout << "---------------";
-            if (i != group_by.size() - 1 || !agg_functions.empty()) std::cout << "+";
-        }
-        for (size_t i = 0; i < agg_functions.size(); ++i) {
-            std::cout << "---------------";
-            if (i != agg_functions.size() - 1) std::cout << "+";
+bool Table::checkWritable(const std::vector<size_t>& rows) const {
+    if (stamps.empty()) return true;
+    for (size_t row : rows) {
+        auto stamp = stamps.find(row);
+        // Visible to the writer, yet deleted or replaced by someone else
+        if (stamp != stamps.end() && stamp->second.deleted != NEVER) {
+            errorStream() << "Error: A row of " << name << " was changed by a concurrent transaction.\n";
+            return false;
         }
-        std::cout << "\n";
+    }
+    return true;
+}
 
-        // Print grouped records with aggregates
-        for (const auto& pair : grouped_records) {
-            std::stringstream ss(pair.first);
-            std::string value;
-            size_t idx = 0;
-            while (std::getline(ss, value, '_')) {
-                if (idx < group_by.size()) {
-                    std::cout << std::left << std::setw(15) << value;
-                    if (idx != group_by.size() - 1 || !agg_functions.empty()) std::cout << " | ";
-                }
-                idx++;
+void Table::rowImages(const std::vector<size_t>& rows, std::vector<std::string>& images) const {
+    images.reserve(images.size() + rows.size() * columns.size());
+    for (size_t row : rows) {
+        for (size_t col = 0; col < columns.size(); ++col) images.emplace_back(fieldAt(row, col));
+    }
+}
+
+// A row's stored fields as one string, each with its length in front
+static void appendImageField(std::string& key, std::string_view field) {
+    uint32_t length = static_cast<uint32_t>(field.size());
+    key.append(reinterpret_cast<const char*>(&length), sizeof(length));
+    key.append(field);
+}
+
+bool Table::findImages(const std::vector<std::string>& args, size_t first, std::vector<size_t>& rows) const {
+    size_t width = columns.size();
+    if (width == 0 || first > args.size() || (args.size() - first) % width != 0) return false;
+    // Identical rows are interchangeable, so an image only says how many of them to take
+    std::unordered_map<std::string, size_t> wanted;
+    std::string key;
+    for (size_t i = first; i < args.size(); i += width) {
+        key.clear();
+        for (size_t col = 0; col < width; ++col) appendImageField(key, args[i + col]);
+        wanted[key]++;
+    }
+    size_t missing = (args.size() - first) / width;
+    rows.clear();
+    for (size_t row = 0; row < rowCount() && missing > 0; ++row) {
+        key.clear();
+        for (size_t col = 0; col < width; ++col) appendImageField(key, fieldAt(row, col));
+        auto it = wanted.find(key);
+        if (it == wanted.end() || it->second == 0) continue;
+        it->second--;
+        missing--;
+        rows.push_back(row);
+    }
+    if (missing > 0) {
+        errorStream() << "Error: The log changes " << missing << " row(s) of " << name
+                      << " that are not there; the change is skipped.\n";
+        return false;
+    }
+    return true;
+}
+
+int Table::update(const std::string& set_column, const std::string& set_value, const Expr* where,
+                  const Snapshot& snapshot) {
+    UpdateQuery query;
+    if (!planUpdate(set_column, &set_value, where, query)) return -1;
+    return update(query, snapshot);
+}
+
+bool Table::planUpdate(const std::string& set_column, const std::string* set_value, const Expr* where,
+                       UpdateQuery& query) const {
+    query = UpdateQuery();
+    query.column = columnIndex(set_column);
+    if (query.column < 0) {
+        errorStream() << "Error: SET column " << set_column << " does not exist.\n";
+        return false;
+    }
+    if (set_value && !encodeField(query.column, *set_value, query.value)) return false;
+    return compileWhere(where, query.where);
+}
+
+int Table::update(const UpdateQuery& query, const Snapshot& snapshot, std::vector<std::string>* images) {
+    Scan scan;
+    prepareScan(query.where, snapshot, scan);
+    if (!ensureRowIndex()) return -1;
+
+    std::vector<size_t> rows = matchRows(scan);
+    if (snapshot.txn != 0 && !checkWritable(rows)) return -1;
+    if (images) rowImages(rows, *images);
+    return updateRows(rows, query.column, query.value, snapshot);
+}
+
+int Table::updateRows(const std::vector<size_t>& rows, int set_idx, const std::string& stored_value,
+                      const Snapshot& snapshot) {
+    size_t row_count = rowCount();
+    std::vector<size_t> copies;
+    if (snapshot.txn != 0) {
+        // Each row keeps its id as the new version; the old version is copied to
+        // the end of the table, where snapshots taken earlier still find it. A
+        // version this transaction wrote itself is just overwritten.
+        copies.assign(rows.size(), SIZE_MAX);
+        for (size_t i = 0; i < rows.size(); ++i) {
+            size_t row = rows[i];
+            auto found = stamps.find(row);
+            RowStamp old = found == stamps.end() ? RowStamp() : found->second;
+            if (old.created == snapshot.ownStamp()) continue;
+            size_t copy = rowCount();
+            if (storage == StorageKind::Column) {
+                column_store.append(column_store.row(row));
+            } else {
+                Record old_version = records[row];
+                records.push_back(std::move(old_version));
             }
-            for (size_t i = 0; i < agg_functions.size(); ++i) {
-                if (agg_functions[i].first == "COUNT") {
-                    if (agg_functions[i].second == -1) {
-                        std::cout << std::left << std::setw(15) << pair.second.size();
-                    }
-                    else {
-                        // Count non-empty values in the specified column
-                        int count = 0;
-                        for (const auto& rec : pair.second) {
-                            if (!rec.fields[agg_functions[i].second].empty()) {
-                                count++;
-                            }
-                        }
-                        std::cout << std::left << std::setw(15) << count;
-                    }
-                }
-                if (i != agg_functions.size() - 1) std::cout << " | ";
+            for (auto& index : indexes) {
+                if (index->isBuilt()) index->insert(fieldAt(copy, index->getColumn()), copy);
             }
-            std::cout << "\n";
+            stamps[copy] = {old.created, snapshot.ownStamp()};
+            stamps[row] = {snapshot.ownStamp(), NEVER};
+            copies[i] = copy;
         }
-        return;
     }
-
-    // Filter records based on WHERE clause
-    std::vector<Record> filtered_records;
-    for (const auto& record : records) {
-        bool match = true;
-        if (!where_column.empty()) {
-            auto it = std::find(columns.begin(), columns.end(), where_column);
-            if (it != columns.end()) {
-                int idx = std::distance(columns.begin(), it);
-                if (record.fields[idx] != where_value) {
-                    match = false;
-                }
-            } else {
-                std::cerr << "Error: WHERE column " << where_column << " does not exist.\n";
-                return;
+    if (recording_undo && !rows.empty()) {
+        UndoEntry entry;
+        entry.kind = UndoEntry::Kind::Update;
+        entry.row_count = row_count;
+        entry.column = set_idx;
+        entry.values.reserve(rows.size());
+        for (size_t row : rows) entry.values.emplace_back(fieldAt(row, set_idx));
+        entry.rows = rows;
+        entry.copies = std::move(copies);
+        undo_log.push_back(std::move(entry));
+    }
+    std::vector<Index*> set_indexes;
+    for (auto& index : indexes) {
+        if (index->getColumn() == set_idx && index->isBuilt()) set_indexes.push_back(index.get());
+    }
+    auto set_row = [&](size_t row) {
+        if (storage == StorageKind::Column) {
+            column_store.set(row, set_idx, stored_value);
+        } else {
+            records[row].setField(set_idx, stored_value);
+        }
+    };
+    // With the value in the column's dictionary up front, setting a code touches only its row
+    if (storage == StorageKind::Column) column_store.intern(set_idx, stored_value);
+    if (storage == StorageKind::Row) {
+        // Updated rows get their own fields; where no old version was copied
+        // (autocommit, or a version this transaction wrote), their arena bytes are garbage
+        for (size_t i = 0; i < rows.size(); ++i) {
+            if (!copies.empty() && copies[i] != SIZE_MAX) continue;
+            if (inArena(records[rows[i]])) row_arena.release(records[rows[i]]);
+        }
+    }
+    if (set_indexes.empty() && (storage == StorageKind::Row || column_store.column(set_idx).width != 0)) {
+        // Each row (or fixed-width slot) is written independently, so morsels can run in parallel
+        ThreadPool::shared().parallelFor(morselCount(rows.size()), [&](size_t morsel) {
+            size_t end = std::min(rows.size(), (morsel + 1) * MORSEL_ROWS);
+            for (size_t r = morsel * MORSEL_ROWS; r < end; ++r) set_row(rows[r]);
+        });
+    } else {
+        for (size_t row : rows) {
+            for (Index* index : set_indexes) {
+                index->erase(fieldAt(row, set_idx), row);
+                index->insert(stored_value, row);
             }
+            set_row(row);
         }
-        if (match) {
-            filtered_records.emplace_back(record);
+    }
+    if (storage == StorageKind::Row) reclaimArena();
+    dirty = dirty || !rows.empty();
+    return static_cast<int>(rows.size());
+}
+
+int Table::deleteRecords(const Expr* where, const Snapshot& snapshot) {
+    Predicate predicate;
+    if (!compileWhere(where, predicate)) return -1;
+    return deleteRecords(predicate, snapshot);
+}
+
+int Table::deleteRecords(const Predicate& where, const Snapshot& snapshot, std::vector<std::string>* images) {
+    Scan scan;
+    prepareScan(where, snapshot, scan);
+    if (!ensureRowIndex()) return -1;
+
+    std::vector<size_t> rows = matchRows(scan);
+    if (rows.empty()) return 0;
+    if (snapshot.txn != 0 && !checkWritable(rows)) return -1;
+    if (images) rowImages(rows, *images);
+    return deleteRows(rows, snapshot);
+}
+
+int Table::deleteRows(const std::vector<size_t>& rows, const Snapshot& snapshot) {
+    if (rows.empty()) return 0;
+    if (snapshot.txn != 0) {
+        // The rows stay until no snapshot can see them; collectGarbage() removes them
+        for (size_t row : rows) stamps[row].deleted = snapshot.ownStamp();
+        if (recording_undo) {
+            UndoEntry entry;
+            entry.kind = UndoEntry::Kind::Delete;
+            entry.rows = rows;
+            undo_log.push_back(std::move(entry));
         }
+        dirty = true;
+        return static_cast<int>(rows.size());
     }
+    if (recording_undo) {
+        UndoEntry entry;
+        entry.kind = UndoEntry::Kind::Delete;
+        entry.removed.reserve(rows.size());
+        for (size_t row : rows) {
+            entry.removed.push_back(storage == StorageKind::Column ? column_store.row(row) : records[row]);
+        }
+        entry.rows = rows;
+        undo_log.push_back(std::move(entry));
+    }
+    removeRows(rows);
+    dirty = true;
+    return static_cast<int>(rows.size());
+}
 
-    // Handle ORDER BY
-    if (!order_by.empty()) {
-        // Check if order_by columns exist
-        std::vector<int> order_indices;
-        std::vector<std::string> order_directions;
-        for (const auto& ob : order_by) {
-            auto it = std::find(columns.begin(), columns.end(), ob.first);
-            if (it != columns.end()) {
-                order_indices.push_back(std::distance(columns.begin(), it));
-                order_directions.push_back(ob.second);
-            } else {
-                std::cerr << "Error: ORDER BY column " << ob.first << " does not exist.\n";
-                return;
+void Table::removeRows(const std::vector<size_t>& rows) {
+    std::vector<bool> remove(rowCount(), false);
+    for (size_t row : rows) remove[row] = true;
+    if (storage == StorageKind::Column) {
+        column_store.erase(remove);
+    } else {
+        size_t kept = 0;
+        for (size_t r = 0; r < records.size(); ++r) {
+            if (remove[r]) {
+                if (inArena(records[r])) row_arena.release(records[r]);
+                continue;
             }
+            if (kept != r) records[kept] = std::move(records[r]);
+            kept++;
         }
-        // Sort the filtered_records
-        std::sort(filtered_records.begin(), filtered_records.end(),
-            [&](const Record& a, const Record& b) -> bool {
-                for (size_t i = 0; i < order_indices.size(); ++i) {
-                    int idx = order_indices[i];
-                    if (a.fields[idx] < b.fields[idx]) {
-                        return order_directions[i] == "ASC";
-                    }
-                    else if (a.fields[idx] > b.fields[idx]) {
-                        return order_directions[i] == "DESC";
-                    }
-                }
-                return false;
-            }
-        );
+        records.resize(kept);
+        reclaimArena();
+    }
+    // Surviving rows moved down; renumber them in the indexes instead of rebuilding
+    std::vector<size_t> new_ids(remove.size());
+    size_t next_id = 0;
+    for (size_t r = 0; r < remove.size(); ++r) {
+        new_ids[r] = remove[r] ? SIZE_MAX : next_id++;
+    }
+    for (auto& index : indexes) {
+        if (index->isBuilt()) index->remap(new_ids);
+    }
+    if (!stamps.empty()) {
+        std::unordered_map<size_t, RowStamp> renumbered;
+        for (const auto& entry : stamps) {
+            if (!remove[entry.first]) renumbered.emplace(new_ids[entry.first], entry.second);
+        }
+        stamps = std::move(renumbered);
     }
+}
 
-    // Print header
-    if (select_columns.empty()) {
-        // For SELECT *
-        for (size_t i = 0; i < columns.size(); ++i) {
-            std::cout << std::left << std::setw(15) << columns[i];
-            if (i != columns.size() - 1 || !aggregates.empty()) std::cout << " | ";
+void Table::truncateRows(size_t n) {
+    for (auto& index : indexes) {
+        if (!index->isBuilt()) continue;
+        for (size_t row = n; row < rowCount(); ++row) {
+            index->erase(fieldAt(row, index->getColumn()), row);
         }
+    }
+    if (storage == StorageKind::Column) {
+        column_store.truncate(n);
     } else {
-        for (size_t i = 0; i < select_columns.size(); ++i) {
-            std::cout << std::left << std::setw(15) << select_columns[i];
-            if (i != select_columns.size() - 1 || !aggregates.empty()) std::cout << " | ";
+        for (size_t row = n; row < records.size(); ++row) {
+            if (inArena(records[row])) row_arena.release(records[row]);
         }
+        records.resize(n);
+        reclaimArena();
     }
-    for (size_t i = 0; i < aggregates.size(); ++i) {
-        std::cout << std::left << std::setw(15) << (aggregates[i].first + "(" + aggregates[i].second + ")");
-        if (i != aggregates.size() - 1) std::cout << " | ";
+    for (auto it = stamps.begin(); it != stamps.end();) {
+        it = it->first >= n ? stamps.erase(it) : std::next(it);
+    }
+}
+
+void Table::reclaimArena() {
+    if (recording_undo || !undo_log.empty()) return;
+    const RowArena::Stats& stats = row_arena.stats();
+    if (stats.garbage < RowArena::SLAB_BYTES || stats.garbage * 2 < stats.used) return;
+    RowArena packed;
+    for (auto& record : records) {
+        if (inArena(record)) record = packed.append(record);
     }
-    std::cout << "\n";
+    row_arena = std::move(packed);
+}
+
+void Table::beginUndo() {
+    undo_log.clear();
+    recording_undo = true;
+    dirty_before_undo = dirty;
+}
+
+void Table::commitUndo() {
+    undo_log.clear();
+    recording_undo = false;
+}
 
-    // Print separator
-    size_t total_columns = select_columns.empty() ? columns.size() : select_columns.size();
-    for (size_t i = 0; i < total_columns; ++i) {
-        std::cout << "---------------";
-        if (i != total_columns - 1 || !aggregates.empty()) std::cout << "+";
+void Table::rollbackUndo() {
+    for (auto it = undo_log.rbegin(); it != undo_log.rend(); ++it) {
+        undo(*it);
     }
-    for (size_t i = 0; i < aggregates.size(); ++i) {
-        std::cout << "---------------";
-        if (i != aggregates.size() - 1) std::cout << "+";
+    undo_log.clear();
+    recording_undo = false;
+    // Every change since beginUndo() is gone, so the table is as clean as it was then
+    dirty = dirty_before_undo;
+}
+
+void Table::commitVersions(const Snapshot& snapshot, uint64_t commit_ts) {
+    uint64_t own = snapshot.ownStamp();
+    for (auto& entry : stamps) {
+        if (entry.second.created == own) entry.second.created = commit_ts;
+        if (entry.second.deleted == own) entry.second.deleted = commit_ts;
     }
-    std::cout << "\n";
+}
 
-    // Print records
-    for (const auto& record : filtered_records) {
-        for (size_t i = 0; i < col_indices.size(); ++i) {
-            std::cout << std::left << std::setw(15) << record.fields[col_indices[i]];
-            if (i != col_indices.size() - 1 || !aggregates.empty()) std::cout << " | ";
+size_t Table::collectGarbage(uint64_t horizon) {
+    // Undo entries refer to rows by id, so nothing moves under an open transaction
+    if (recording_undo || stamps.empty()) return 0;
+    auto committed = [&](uint64_t stamp) { return !(stamp & IN_FLIGHT) && stamp <= horizon; };
+    std::vector<size_t> dead;
+    for (auto it = stamps.begin(); it != stamps.end();) {
+        if (committed(it->second.deleted)) {
+            dead.push_back(it->first);
+        } else if (committed(it->second.created) && it->second.deleted == NEVER) {
+            // Every open and future snapshot sees this version: it needs no stamp
+            it = stamps.erase(it);
+            continue;
         }
-        // Handle aggregates (if any without GROUP BY)
-        for (size_t i = 0; i < aggregates.size(); ++i) {
-            if (aggregates[i].first == "COUNT") {
-                if (aggregates[i].second == "*") {
-                    std::cout << std::left << std::setw(15) << "1"; // Each record counts as 1
-                }
-                else {
-                    // Count non-empty values in the specified column
-                    auto it = std::find(columns.begin(), columns.end(), aggregates[i].second);
-                    if (it != columns.end()) {
-                        int idx = std::distance(columns.begin(), it);
-                        int count = !record.fields[idx].empty() ? 1 : 0;
-                        std::cout << std::left << std::setw(15) << count;
-                    }
-                    else {
-                        std::cout << std::left << std::setw(15) << "0";
+        ++it;
+    }
+    if (dead.empty()) return 0;
+    std::sort(dead.begin(), dead.end());
+    // Old versions of updated rows sit at the end, and cutting them off is cheap
+    size_t tail = rowCount();
+    while (!dead.empty() && dead.back() == tail - 1) {
+        dead.pop_back();
+        tail--;
+    }
+    size_t removed = rowCount() - tail;
+    truncateRows(tail);
+    if (!dead.empty()) removeRows(dead);
+    return removed + dead.size();
+}
+
+void Table::undo(UndoEntry& entry) {
+    switch (entry.kind) {
+        case UndoEntry::Kind::Insert:
+            truncateRows(entry.row_count);
+            break;
+        case UndoEntry::Kind::Update:
+            for (size_t i = 0; i < entry.rows.size(); ++i) {
+                size_t row = entry.rows[i];
+                if (!entry.copies.empty() && entry.copies[i] != SIZE_MAX) {
+                    // The row is once more the version its copy preserved
+                    uint64_t created = stamps[entry.copies[i]].created;
+                    if (created == 0) {
+                        stamps.erase(row);
+                    } else {
+                        stamps[row] = {created, NEVER};
                     }
                 }
+                for (auto& index : indexes) {
+                    if (index->getColumn() != entry.column || !index->isBuilt()) continue;
+                    index->erase(fieldAt(row, entry.column), row);
+                    index->insert(entry.values[i], row);
+                }
+                if (storage == StorageKind::Column) {
+                    column_store.set(row, entry.column, entry.values[i]);
+                } else {
+                    records[row].setField(entry.column, entry.values[i]);
+                }
             }
-            // Future aggregate functions can be handled here
-            if (i != aggregates.size() - 1) std::cout << " | ";
-        }
-        std::cout << "\n";
-    }
-
-    // Handle global aggregates without GROUP BY
-    if (!aggregates.empty() && group_by.empty()) {
-        std::cout << "\n";
-        // Print aggregate results
-        for (size_t i = 0; i < aggregates.size(); ++i) {
-            if (aggregates[i].first == "COUNT") {
-                if (aggregates[i].second == "*") {
-                    std::cout << "COUNT(*) = " << filtered_records.size() << "\n";
+            truncateRows(entry.row_count);
+            break;
+        case UndoEntry::Kind::Delete: {
+            if (entry.removed.empty()) {
+                // The rows were only stamped as deleted
+                for (size_t row : entry.rows) {
+                    RowStamp& stamp = stamps[row];
+                    stamp.deleted = NEVER;
+                    if (stamp.created == 0) stamps.erase(row);
                 }
-                else {
-                    // Count non-empty values in the specified column
-                    auto it = std::find(columns.begin(), columns.end(), aggregates[i].second);
-                    if (it != columns.end()) {
-                        int idx = std::distance(columns.begin(), it);
-                        int count = 0;
-                        for (const auto& rec : filtered_records) {
-                            if (!rec.fields[idx].empty()) {
-                                count++;
-                            }
-                        }
-                        std::cout << "COUNT(" << aggregates[i].second << ") = " << count << "\n";
-                    }
-                    else {
-                        std::cout << "COUNT(" << aggregates[i].second << ") = 0\n";
-                    }
+                break;
+            }
+            // Merge the deleted rows back in at their old ids, moving the survivors up
+            size_t total = rowCount() + entry.rows.size();
+            std::vector<size_t> new_ids(rowCount());
+            std::vector<Record> restored_rows;
+            ColumnStore restored_columns(types);
+            if (storage == StorageKind::Column) {
+                restored_columns.reserve(total);
+            } else {
+                restored_rows.reserve(total);
+            }
+            size_t next_removed = 0, next_kept = 0;
+            for (size_t id = 0; id < total; ++id) {
+                bool was_removed = next_removed < entry.rows.size() && entry.rows[next_removed] == id;
+                if (!was_removed) new_ids[next_kept] = id;
+                if (storage == StorageKind::Column) {
+                    restored_columns.append(was_removed ? entry.removed[next_removed] : column_store.row(next_kept));
+                } else {
+                    restored_rows.push_back(was_removed ? std::move(entry.removed[next_removed])
+                                                        : std::move(records[next_kept]));
+                }
+                if (was_removed) {
+                    next_removed++;
+                } else {
+                    next_kept++;
                 }
             }
-            // Future aggregate functions can be handled here
+            if (storage == StorageKind::Column) {
+                column_store = std::move(restored_columns);
+            } else {
+                records = std::move(restored_rows);
+            }
+            for (auto& index : indexes) {
+                if (!index->isBuilt()) continue;
+                index->remap(new_ids);
+                for (size_t row : entry.rows) index->insert(fieldAt(row, index->getColumn()), row);
+            }
+            break;
         }
     }
 }
 
-void Table::update(const std::string& set_column, const std::string& set_value, 
-                  const std::string& where_column, 
-                  const std::string& where_value) {
-    auto it = std::find(columns.begin(), columns.end(), set_column);
-    if (it == columns.end()) {
-        std::cerr << "Error: SET column " << set_column << " does not exist.\n";
-        return;
+bool Table::ensureRowIndex() {
+    if (!rows_indexed) {
+        std::lock_guard<std::mutex> lock(lazy_mutex);
+        ensureRowIndexLocked();
     }
-    int set_idx = std::distance(columns.begin(), it);
-    int updated_count = 0;
+    if (unreadable) {
+        errorStream() << "Error: Table " << name << " could not be read.\n";
+        return false;
+    }
+    return true;
+}
 
-    for (auto& record : records) {
-        bool match = true;
-        if (!where_column.empty()) {
-            auto where_it = std::find(columns.begin(), columns.end(), where_column);
-            if (where_it != columns.end()) {
-                int where_idx = std::distance(columns.begin(), where_it);
-                if (record.fields[where_idx] != where_value) {
-                    match = false;
-                }
-            }
-            else {
-                std::cerr << "Error: WHERE column " << where_column << " does not exist.\n";
-                return;
-            }
-        }
-        if (match) {
-            record.fields[set_idx] = set_value;
-            updated_count++;
-        }
+void Table::ensureRowIndexLocked() {
+    if (rows_indexed) return;
+    // Every row at once: the first statement faults in every data page, even one reading a few rows
+    TableData data;
+    data.mapping = mapping;
+    if (indexTableRows(filepath, data)) {
+        records = std::move(data.records);
+    } else {
+        unreadable = true;
     }
-    std::cout << "Updated " << updated_count << " record(s) in " << name << ".\n";
+    rows_indexed = true;
 }
 
-void Table::deleteRecords(const std::string& where_column, const std::string& where_value) {
-    if (!where_column.empty()) {
-        auto it = std::find(columns.begin(), columns.end(), where_column);
-        if (it == columns.end()) {
-            std::cerr << "Error: WHERE column " << where_column << " does not exist.\n";
-            return;
-        }
+TableData Table::metadata() const {
+    TableData meta;
+    meta.columns = columns;
+    meta.types = types;
+    meta.checkpoint_lsn = checkpoint_lsn;
+    meta.row_count = saved_rows;
+    meta.storage = storage;
+    for (const auto& index : indexes) {
+        meta.indexes.push_back({index->getName(), static_cast<uint32_t>(index->getColumn()), index->kind()});
     }
-    auto initial_size = records.size();
-    records.erase(
-        std::remove_if(records.begin(), records.end(),
-            [&](const Record& record) -> bool {
-                if (where_column.empty()) {
-                    return true; // Delete all
-                }
-                auto it = std::find(columns.begin(), columns.end(), where_column);
-                if (it != columns.end()) {
-                    int idx = std::distance(columns.begin(), it);
-                    return record.fields[idx] == where_value;
-                }
-                return false;
-            }),
-        records.end()
-    );
-    auto deleted_count = initial_size - records.size();
-    std::cout << "Deleted " << deleted_count << " record(s) from " << name << ".\n";
+    return meta;
 }
 
 void Table::save() {
-    std::ofstream ofs(filepath, std::ios::trunc);
-    if (!ofs) {
-        std::cerr << "Error: Unable to open file " << filepath << " for writing.\n";
-        return;
+    if (!ensureRowIndex()) return;
+    TableData meta = metadata();
+    // Only committed data is written: versions some snapshot still holds are left out
+    std::vector<size_t> visible;
+    if (!stamps.empty()) {
+        Snapshot committed;
+        for (size_t row = 0; row < rowCount(); ++row) {
+            auto stamp = stamps.find(row);
+            if (stamp == stamps.end() || committed.sees(stamp->second)) visible.push_back(row);
+        }
     }
-    // First line: column headers
-    for (size_t i = 0; i < columns.size(); ++i) {
-        ofs << columns[i];
-        if (i != columns.size() - 1) ofs << ",";
+    size_t count = stamps.empty() ? rowCount() : visible.size();
+    if (storage == StorageKind::Column) {
+        // Encoded columns are written as their codes, with the dictionary in the header
+        meta.dictionaries.resize(columns.size());
+        for (size_t c = 0; c < columns.size(); ++c) {
+            const ColumnStore::Column& column = column_store.column(c);
+            const auto& values = column.dictionary.values;
+            if (column.encoded) meta.dictionaries[c].assign(values.begin(), values.end());
+        }
     }
-    ofs << "\n";
+    bool written = writeTableFile(filepath, meta, count, [&](size_t row, size_t col) {
+        size_t id = visible.empty() ? row : visible[row];
+        return storage == StorageKind::Column ? column_store.stored(id, col) : fieldAt(id, col);
+    });
+    if (written) {
+        dirty = false;
+        saved_rows = count;
+    }
+}
 
-    // Records
-    for (const auto& record : records) {
-        for (size_t i = 0; i < record.fields.size(); ++i) {
-            // Escape commas in fields
-            std::string field = record.fields[i];
-            if (field.find(',') != std::string::npos) {
-                field = "\"" + field + "\"";
-            }
-            ofs << field;
-            if (i != record.fields.size() - 1) ofs << ",";
-        }
-        ofs << "\n";
+// WHERE clause of a logged UPDATE/DELETE, starting at args[first]: its text (empty for
+// none), or from older logs a "column value" pair or a four-argument comparison
+static bool whereFromArgs(const std::vector<std::string>& args, size_t first, ExprPtr& where) {
+    size_t count = args.size() - first;
+    if (count == 1) {
+        if (!args[first].empty()) where = parseWhere(args[first]);
+        return args[first].empty() || where != nullptr;
     }
-    ofs.close();
+    Condition cond;
+    if (count == 2) {
+        cond.column = args[first];
+        cond.value = args[first + 1];
+    } else if (!conditionFromArgs(args, first, cond)) {
+        return false;
+    }
+    // Those forms logged a statement without WHERE as an empty column
+    if (!cond.empty()) where = makeComparison(cond.column, cond.op, cond.value, cond.value2);
+    return true;
 }
 
 void Table::load() {
-    std::ifstream ifs(filepath);
-    if (!ifs) {
-        std::cerr << "Error: Unable to open file " << filepath << " for reading.\n";
-        return;
+    TableData data;
+    if (isBinaryTableFile(filepath)) {
+        // Only the header is decoded now; rows are indexed on first use
+        if (!openTableFile(filepath, data)) {
+            return;
+        }
+        storage = data.storage;
+        if (storage == StorageKind::Column) {
+            // The file is row-major, so a columnar table is transposed up front
+            column_store = ColumnStore(data.types);
+            if (!indexTableRows(filepath, data)) {
+                unreadable = true;
+            } else if (!column_store.load(data.records, data.dictionaries)) {
+                errorStream() << "Error: " << filepath << " has a row with an unknown dictionary code.\n";
+                column_store = ColumnStore(data.types);
+                unreadable = true;
+            }
+        } else {
+            mapping = std::move(data.mapping);
+            rows_indexed = false;
+        }
+    } else {
+        // Legacy CSV tables are rewritten in the binary format at the next checkpoint
+        if (!readCsvTable(filepath, data)) {
+            return;
+        }
+        data.row_count = data.records.size();
+        records = std::move(data.records);
+    }
+    columns = std::move(data.columns);
+    types = std::move(data.types);
+    types.resize(columns.size(), ColumnType::Text);
+    checkpoint_lsn = data.checkpoint_lsn;
+    saved_rows = data.row_count;
+    for (const auto& def : data.indexes) {
+        if (def.column < columns.size()) {
+            indexes.push_back(makeIndex(def.kind, def.name, static_cast<int>(def.column), types[def.column]));
+        }
     }
-    std::string line;
-    bool is_header = true;
-    while (std::getline(ifs, line)) {
-        std::stringstream ss(line);
-        std::string field;
-        std::vector<std::string> fields;
-        bool in_quotes = false;
-        std::string current_field;
-        for (size_t i = 0; i < line.size(); ++i) {
-            char c = line[i];
-            if (c == '"' ) {
-                in_quotes = !in_quotes;
+
+    // Re-apply mutations committed since the last checkpoint
+    WriteAheadLog::replay(data_dir + WAL_FILE, name, checkpoint_lsn, [this](WalEntry& entry) {
+        switch (entry.op) {
+            case WalOp::Insert:
+                insert(std::move(entry.args));
+                break;
+            case WalOp::Update: {
+                if (entry.args.size() < 2) break;
+                ExprPtr where;
+                if (!whereFromArgs(entry.args, 2, where)) break;
+                update(entry.args[0], entry.args[1], where.get());
+                break;
             }
-            else if (c == ',' && !in_quotes) {
-                fields.push_back(current_field);
-                current_field.clear();
+            case WalOp::Delete: {
+                ExprPtr where;
+                if (!whereFromArgs(entry.args, 0, where)) break;
+                deleteRecords(where.get());
+                break;
             }
-            else {
-                current_field += c;
+            case WalOp::UpdateRows: {
+                if (entry.args.size() < 2) break;
+                int column = columnIndex(entry.args[0]);
+                std::string value;
+                std::vector<size_t> rows;
+                if (column < 0 || !encodeField(column, entry.args[1], value) || !findImages(entry.args, 2, rows)) {
+                    break;
+                }
+                updateRows(rows, column, value, Snapshot());
+                break;
+            }
+            case WalOp::DeleteRows: {
+                std::vector<size_t> rows;
+                if (findImages(entry.args, 0, rows)) deleteRows(rows, Snapshot());
+                break;
             }
         }
-        fields.push_back(current_field);
-
-        if (is_header) {
-            columns = fields;
-            is_header = false;
-        } else {
-            records.emplace_back(fields);
-        }
-    }
-    ifs.close();
-}
\ No newline at end of file
+    });
+}
@@ -2,44 +2,287 @@
 #ifndef TABLE_HPP
 #define TABLE_HPP
 
+#include "Aggregate.hpp"
+#include "ColumnStore.hpp"
+#include "Cursor.hpp"
+#include "Expression.hpp"
+#include "Index.hpp"
+#include "Latch.hpp"
+#include "MappedFile.hpp"
+#include "Operator.hpp"
+#include "Predicate.hpp"
 #include "Record.hpp"
+#include "RowArena.hpp"
+#include "Snapshot.hpp"
+#include "TableFile.hpp"
+#include <cstdint>
+#include <memory>
 #include <string>
+#include <string_view>
+#include <unordered_map>
 #include <vector>
 #include <fstream>
 #include <iostream>
 #include <algorithm>
+#include <atomic>
 #include <functional>
+#include <mutex>
+
+// Directory of the tables (and log and catalog) when none is given
+inline const std::string DATA_DIR = "data/";
+
+// Rows converted to stored values ahead of time (by a bulk load), laid out
+// like the table they are for, to be added with Table::appendRows()
+struct RowBatch {
+    ColumnStore columns;         // column layout
+    std::vector<Record> records; // row layout: views into arena
+    RowArena arena;
+
+    size_t size() const { return records.empty() ? columns.size() : records.size(); }
+};
+
+// A SELECT resolved against one table's schema: names are column positions and
+// the WHERE is compiled, so it can run any number of times without lookups
+struct SelectQuery {
+    std::vector<int> columns; // listed columns
+    std::vector<Aggregate> aggregates;
+    std::vector<int> agg_columns; // column of each aggregate, -1 for COUNT(*)
+    Predicate where;
+    std::string where_text; // as EXPLAIN shows it
+    std::vector<int> group_by;
+    std::vector<std::pair<int, bool>> order_by; // column, descending
+    size_t limit = SIZE_MAX;
+    size_t offset = 0;
+};
+
+// An UPDATE resolved the same way
+struct UpdateQuery {
+    int column = -1;
+    std::string value; // stored form
+    Predicate where;
+};
 
 class Table {
 private:
     std::string name;
     std::vector<std::string> columns;
-    std::vector<Record> records;
+    std::vector<ColumnType> types; // stored form of each column's values
+    std::string data_dir; // with a trailing '/'
     std::string filepath;
+    uint64_t checkpoint_lsn = 0; // last log frame reflected in the table file
+    uint64_t saved_rows = 0;     // rows in the table file
+    StorageKind storage = StorageKind::Row;
+    // Row layout: one Record per row, a view into the mapped file or row_arena
+    // unless an update gave it its own fields
+    std::vector<Record> records;
+    RowArena row_arena;
+    std::vector<std::string> scratch; // insert()'s copy of a row, reused across rows
+    // Column layout: one contiguous buffer per column
+    ColumnStore column_store;
+    // Records of a freshly opened table are views into this mapping, and the
+    // row index itself is only built when a statement first touches the rows
+    std::shared_ptr<MappedFile> mapping;
+    std::atomic<bool> rows_indexed{true};
+    // The rows in the file could not be read: every statement on the table
+    // fails, so the file is never overwritten with what little was read
+    std::atomic<bool> unreadable{false};
+    bool dirty = false; // changed since the last save()
+    std::vector<std::unique_ptr<Index>> indexes;
+    // Versions of rows written by transactions that some snapshot may not see
+    // yet (or may still see). Rows without a stamp are visible to everyone, so a
+    // table nobody is writing has none and scans skip visibility checks.
+    std::unordered_map<size_t, RowStamp> stamps;
+    // Changes made by the open transaction, oldest first, so that rolling back
+    // reverses exactly those changes without a copy of the table
+    struct UndoEntry {
+        enum class Kind { Insert, Update, Delete } kind = Kind::Insert;
+        size_t row_count = 0;            // Insert, Update: rows before the entry appended any
+        int column = -1;                 // Update: the SET column
+        std::vector<size_t> rows;        // Update, Delete: affected ids, ascending
+        std::vector<std::string> values; // Update: the values they held before
+        std::vector<size_t> copies;      // Update: id of each row's old version, SIZE_MAX for none
+        std::vector<Record> removed;     // Delete: the deleted rows, empty if they were only stamped
+    };
+    std::vector<UndoEntry> undo_log;
+    bool recording_undo = false;
+    bool dirty_before_undo = false;
+    // Statements reading the table share the latch; writers hold it alone
+    mutable Latch statement_latch;
+    // Readers sharing the latch may each be first to need the row index or an
+    // index that is not built yet: one builds it while the others wait
+    std::mutex lazy_mutex;
+
+    void undo(UndoEntry& entry);
+    // Drop rows from id n on, with their index entries and stamps
+    void truncateRows(size_t n);
+    // Compact away the given rows (ascending) and renumber indexes and stamps
+    void removeRows(const std::vector<size_t>& rows);
+    // True for a record viewing bytes in row_arena
+    bool inArena(const Record& record) const {
+        const char* bytes = record.data();
+        return bytes && (!mapping || bytes < mapping->data() || bytes >= mapping->data() + mapping->size());
+    }
+    // Copy the live rows of row_arena into a new one once most of it is
+    // garbage; not while undo entries may still view released rows
+    void reclaimArena();
+    void ensureRowIndexLocked(); // with lazy_mutex held
+    // insert() of a row whose fields may be converted in place
+    bool insertValues(std::vector<std::string>& fields, const Snapshot& snapshot);
+    size_t rowCount() const { return storage == StorageKind::Column ? column_store.size() : records.size(); }
+    std::string_view fieldAt(size_t row, size_t col) const {
+        return storage == StorageKind::Column ? column_store.field(row, col) : records[row].field(col);
+    }
+    int columnIndex(const std::string& column) const;
+    // Index of the given kind on the column, or nullptr if it has none
+    Index* findIndex(int column, IndexKind kind) const;
+    // The same, built first if it has not been yet
+    Index* indexOn(int column, IndexKind kind);
+    // What one statement scans: its compiled WHERE and the rows its snapshot cannot see
+    struct Scan {
+        const Predicate* where = nullptr;
+        std::vector<size_t> hidden; // ascending; empty when every row is visible
+    };
+    // Ascending ids of the rows the snapshot cannot see
+    std::vector<size_t> hiddenRows(const Snapshot& snapshot) const;
+    // Collect the rows the snapshot cannot see for a scan filtered by where
+    void prepareScan(const Predicate& where, const Snapshot& snapshot, Scan& scan) const;
+    // False (and reported) if another transaction deleted or replaced one of the rows
+    bool checkWritable(const std::vector<size_t>& rows) const;
+    // The second half of update() and deleteRecords(), on rows already matched (ascending)
+    int updateRows(const std::vector<size_t>& rows, int set_idx, const std::string& stored_value,
+                   const Snapshot& snapshot);
+    int deleteRows(const std::vector<size_t>& rows, const Snapshot& snapshot);
+    // Append the stored fields of each row to images
+    void rowImages(const std::vector<size_t>& rows, std::vector<std::string>& images) const;
+    // Ascending ids of rows whose stored fields are the images in args from
+    // first on, each row matched once; false (and reported) if one is missing
+    bool findImages(const std::vector<std::string>& args, size_t first, std::vector<size_t>& rows) const;
+
+    // The comparison of where an index can answer (a hash lookup on an equality
+    // is the narrowest, then any B+tree range) and that index's kind, or nullptr
+    const Predicate::Term* indexTerm(const Predicate& where, IndexKind& kind) const;
+    // Ascending ids of the rows matching term, from the index of the given kind
+    void indexLookup(const Predicate::Term& term, IndexKind kind, std::vector<size_t>& rows);
+    // Ids of the rows not in hidden in the order of the B+tree on column, within
+    // bound's range if it is set, stopping after limit rows
+    void indexOrder(int column, bool descending, const Predicate::Term* bound, const std::vector<size_t>& hidden,
+                    size_t limit, std::vector<size_t>& rows);
+    // Ascending ids of the rows matching where, if an index fits one of its comparisons
+    bool indexMatches(const Scan& scan, std::vector<size_t>& rows);
+    // Append the ids in [begin, end) matching where, reading only the columns it references
+    void filterRange(const Scan& scan, size_t begin, size_t end, std::vector<size_t>& rows) const;
+    // Ascending ids of the first limit rows matching where; a scan stops taking
+    // new morsels once it has them
+    std::vector<size_t> matchRows(const Scan& scan, size_t limit = SIZE_MAX);
+
+    // The operators of query in the order they run, leaving the result to
+    // cursor; the last one stands for the client reading it
+    std::vector<std::unique_ptr<Operator>> planOperators(const SelectQuery& query, const Snapshot& snapshot,
+                                                         Cursor& cursor);
+    friend class ScanOp;
+    friend class FilterOp;
+    friend class AggregateOp;
+    friend class SortOp;
+    friend class ProjectOp;
+    friend class Cursor;
 
 public:
-    Table(const std::string& name, const std::vector<std::string>& columns);
-    Table(const std::string& name); // Load existing table
-
-    void insert(const std::vector<std::string>& fields);
-    void select(const std::vector<std::string>& select_columns, 
-               const std::vector<std::pair<std::string, std::string>>& aggregates,
-               const std::string& where_column = "", 
-               const std::string& where_value = "",
+    Table(const std::string& name, const std::vector<std::string>& columns, const std::vector<ColumnType>& types,
+          StorageKind storage = StorageKind::Row, const std::string& dir = DATA_DIR);
+    Table(const std::string& name, const std::string& dir = DATA_DIR); // Load existing table
+
+    // Reads see the rows visible to snapshot. Writes under a writer's snapshot
+    // create versions that only it sees until commitVersions(); writes under the
+    // default snapshot (loading, log replay) change rows in place.
+    bool insert(const std::vector<std::string>& fields, const Snapshot& snapshot = Snapshot());
+    // The same for a row the caller is done with: its fields are converted in
+    // place, without a copy, and TEXT values go to storage as they are
+    bool insert(std::vector<std::string>&& fields, const Snapshot& snapshot = Snapshot());
+    // Insert several rows as one statement: all are validated first, so a bad
+    // row leaves the table unchanged, then they are appended in one batch
+    bool insertRows(const std::vector<std::vector<std::string>>& rows, const Snapshot& snapshot = Snapshot());
+    // Append batches of already converted rows in order, reserving room for all
+    // of them at once; returns the number of rows added
+    size_t appendRows(std::vector<RowBatch>& batches, const Snapshot& snapshot = Snapshot());
+    // Run a SELECT and return a cursor over its result, or nullptr (reported)
+    // for an unknown column or invalid literal
+    std::unique_ptr<Cursor> select(const std::vector<std::string>& select_columns,
+               const std::vector<Aggregate>& aggregates,
+               const Expr* where = nullptr,
                const std::vector<std::pair<std::string, std::string>>& order_by = {},
-               const std::vector<std::string>& group_by = {});
-    void update(const std::string& set_column, const std::string& set_value, 
-               const std::string& where_column = "", 
-               const std::string& where_value = "");
-    void deleteRecords(const std::string& where_column = "", const std::string& where_value = "");
+               const std::vector<std::string>& group_by = {},
+               size_t limit = SIZE_MAX, size_t offset = 0, const Snapshot& snapshot = Snapshot());
+    // select() in two steps: resolve the names and compile the WHERE (reporting
+    // an unknown column or invalid literal), then run the query
+    bool planSelect(const std::vector<std::string>& select_columns, const std::vector<Aggregate>& aggregates,
+                    const Expr* where, const std::vector<std::pair<std::string, std::string>>& order_by,
+                    const std::vector<std::string>& group_by, size_t limit, size_t offset,
+                    SelectQuery& query) const;
+    std::unique_ptr<Cursor> select(const SelectQuery& query, const Snapshot& snapshot = Snapshot());
+    // Print the operators select() runs for query, last first. With analyze,
+    // run them, read the whole result as a client would, and report each
+    // one's time, rows in and out, and bytes allocated.
+    void explain(const SelectQuery& query, bool analyze, const Snapshot& snapshot = Snapshot());
+    // Values and WHERE literals are passed as text and converted to each column's type;
+    // a null where matches every row. update() and deleteRecords() return the number
+    // of affected records, or -1 on error (including a row another transaction changed)
+    int update(const std::string& set_column, const std::string& set_value, const Expr* where = nullptr,
+               const Snapshot& snapshot = Snapshot());
+    int deleteRecords(const Expr* where = nullptr, const Snapshot& snapshot = Snapshot());
+    // update() in two steps; a null set_value leaves query.value to be set
+    // later with encodeField()
+    bool planUpdate(const std::string& set_column, const std::string* set_value, const Expr* where,
+                    UpdateQuery& query) const;
+    // With images set, the stored fields each changed row held before are
+    // appended to it, a row after another (see WalOp::UpdateRows)
+    int update(const UpdateQuery& query, const Snapshot& snapshot = Snapshot(),
+               std::vector<std::string>* images = nullptr);
+    // deleteRecords() in two steps: compile the WHERE (null for none), then delete
+    bool compileWhere(const Expr* where, Predicate& predicate) const;
+    int deleteRecords(const Predicate& where, const Snapshot& snapshot = Snapshot(),
+                      std::vector<std::string>* images = nullptr);
+    // Convert a literal for column col, reporting it if it is not a valid value
+    bool encodeField(size_t col, const std::string& text, std::string& out) const;
+    bool createIndex(const std::string& index_name, const std::string& column, IndexKind kind = IndexKind::Hash);
+
+    // Transactions: between beginUndo() and commitUndo() or rollbackUndo() every
+    // change is recorded, and rollbackUndo() puts back what those changes replaced
+    void beginUndo();
+    void commitUndo();
+    void rollbackUndo();
+    bool recordingUndo() const { return recording_undo; }
+
+    // Callers hold this latch around every other method except the schema
+    // getters: shared to read the table, alone to change it
+    Latch& latch() const { return statement_latch; }
+
+    // Stamp the versions written under snapshot with commit_ts
+    void commitVersions(const Snapshot& snapshot, uint64_t commit_ts);
+    // Remove versions deleted at or before horizon and unstamp rows every snapshot
+    // sees; returns the number of rows removed. Skipped while recording undo.
+    size_t collectGarbage(uint64_t horizon);
+    size_t versionCount() const { return stamps.size(); }
 
     void save();
     void load();
+    void setCheckpointLsn(uint64_t lsn) { checkpoint_lsn = lsn; }
+    // Header fields of the table file as of the last save() or load()
+    TableData metadata() const;
+    bool isDirty() const { return dirty; }
+    // Index the rows if no statement has yet; false, with an error, if the file could not be read
+    bool ensureRowIndex();
+    bool isUnreadable() const { return unreadable; }
     const std::string& getName() const { return name; }
     const std::vector<std::string>& getColumns() const { return columns; }
-
-    // For transaction backup
-    Table(const Table& other) : name(other.name), columns(other.columns), records(other.records), filepath(other.filepath) {}
+    const std::vector<ColumnType>& getTypes() const { return types; }
+    StorageKind getStorage() const { return storage; }
+    const RowArena::Stats& arenaStats() const { return row_arena.stats(); }
+    // The dictionary of a column kept as codes (columnar TEXT), else nullptr
+    const ColumnStore::Dictionary* dictionary(size_t col) const {
+        if (storage != StorageKind::Column || !column_store.column(col).encoded) return nullptr;
+        return &column_store.column(col).dictionary;
+    }
+    const std::vector<std::unique_ptr<Index>>& getIndexes() const { return indexes; }
 };
 
-#endif // TABLE_HPP
\ No newline at end of file
+#endif // TABLE_HPP
@@ -0,0 +1,402 @@
+// TableFile.cpp
+#include "TableFile.hpp"
+#include "Diagnostics.hpp"
+#include <cstddef>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+static const char TABLE_MAGIC[8] = {'M', 'D', 'B', 'T', 'A', 'B', 'L', 'E'};
+
+struct FileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t page_size;
+    uint32_t header_pages;
+    uint32_t column_count;
+    uint64_t row_count;
+    uint64_t data_pages;
+    uint64_t checkpoint_lsn;
+    // Added in version 2
+    uint32_t storage;
+    uint32_t reserved;
+};
+
+// Version 1 headers end before the storage field
+static const size_t FILE_HEADER_V1_SIZE = offsetof(FileHeader, storage);
+
+static size_t headerSize(uint32_t version) {
+    return version == 1 ? FILE_HEADER_V1_SIZE : sizeof(FileHeader);
+}
+
+static const size_t PAGE_PAYLOAD = TABLE_PAGE_SIZE - sizeof(PageHeader);
+
+static void appendField(std::string& buf, std::string_view field) {
+    uint32_t len = static_cast<uint32_t>(field.size());
+    buf.append(reinterpret_cast<const char*>(&len), sizeof(len));
+    buf.append(field);
+}
+
+bool isBinaryTableFile(const std::string& filepath) {
+    std::ifstream ifs(filepath, std::ios::binary);
+    char magic[sizeof(TABLE_MAGIC)];
+    return ifs.read(magic, sizeof(magic)) && std::memcmp(magic, TABLE_MAGIC, sizeof(magic)) == 0;
+}
+
+// Force a written file (or a directory's entries) to disk
+static bool syncPath(const std::string& path) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    bool ok = ::fsync(fd) == 0;
+    ::close(fd);
+    return ok;
+}
+
+bool writeTableFile(const std::string& filepath, const TableData& meta, size_t row_count, const FieldReader& field) {
+    // Write to a sibling file and rename, so a crash never leaves half a table
+    std::string tmp_path = filepath + ".tmp";
+    std::ofstream ofs(tmp_path, std::ios::binary | std::ios::trunc);
+    if (!ofs) {
+        errorStream() << "Error: Unable to open file " << tmp_path << " for writing.\n";
+        return false;
+    }
+
+    std::string header(sizeof(FileHeader), '\0');
+    for (const auto& col : meta.columns) {
+        appendField(header, col);
+    }
+    for (size_t c = 0; c < meta.columns.size(); ++c) {
+        header.push_back(static_cast<char>(c < meta.types.size() ? meta.types[c] : ColumnType::Text));
+    }
+    uint32_t index_count = static_cast<uint32_t>(meta.indexes.size());
+    header.append(reinterpret_cast<const char*>(&index_count), sizeof(index_count));
+    for (const auto& index : meta.indexes) {
+        appendField(header, index.name);
+        header.append(reinterpret_cast<const char*>(&index.column), sizeof(index.column));
+        header.push_back(static_cast<char>(index.kind));
+    }
+    for (size_t c = 0; c < meta.columns.size(); ++c) {
+        static const std::vector<std::string> none;
+        const auto& values = c < meta.dictionaries.size() ? meta.dictionaries[c] : none;
+        uint32_t value_count = static_cast<uint32_t>(values.size());
+        header.append(reinterpret_cast<const char*>(&value_count), sizeof(value_count));
+        for (const auto& value : values) appendField(header, value);
+    }
+    uint32_t header_pages = static_cast<uint32_t>((header.size() + TABLE_PAGE_SIZE - 1) / TABLE_PAGE_SIZE);
+    header.resize(static_cast<size_t>(header_pages) * TABLE_PAGE_SIZE, '\0');
+    ofs.write(header.data(), header.size()); // patched below once the page count is known
+
+    uint64_t data_pages = 0;
+    std::string page;
+    page.reserve(TABLE_PAGE_SIZE);
+    PageHeader ph{0, 0, 1, 0};
+    auto flush_page = [&]() {
+        if (ph.row_count == 0) return;
+        ph.used_bytes = static_cast<uint32_t>(page.size());
+        size_t padded = static_cast<size_t>(ph.span_pages) * TABLE_PAGE_SIZE - sizeof(PageHeader);
+        page.resize(padded, '\0');
+        ofs.write(reinterpret_cast<const char*>(&ph), sizeof(ph));
+        ofs.write(page.data(), page.size());
+        data_pages += ph.span_pages;
+        page.clear();
+        ph = PageHeader{0, 0, 1, 0};
+    };
+
+    size_t column_count = meta.columns.size();
+    for (size_t r = 0; r < row_count; ++r) {
+        size_t size = 0;
+        for (size_t c = 0; c < column_count; ++c) {
+            size += sizeof(uint32_t) + field(r, c).size();
+        }
+        if (page.size() + size > PAGE_PAYLOAD) {
+            flush_page();
+        }
+        if (size > PAGE_PAYLOAD) {
+            ph.span_pages = static_cast<uint32_t>((size + sizeof(PageHeader) + TABLE_PAGE_SIZE - 1) / TABLE_PAGE_SIZE);
+        }
+        for (size_t c = 0; c < column_count; ++c) {
+            appendField(page, field(r, c));
+        }
+        ph.row_count++;
+        if (ph.span_pages > 1) {
+            flush_page();
+        }
+    }
+    flush_page();
+
+    FileHeader fh;
+    std::memcpy(fh.magic, TABLE_MAGIC, sizeof(TABLE_MAGIC));
+    fh.version = TABLE_FILE_VERSION;
+    fh.page_size = TABLE_PAGE_SIZE;
+    fh.header_pages = header_pages;
+    fh.column_count = static_cast<uint32_t>(column_count);
+    fh.row_count = row_count;
+    fh.data_pages = data_pages;
+    fh.checkpoint_lsn = meta.checkpoint_lsn;
+    fh.storage = static_cast<uint32_t>(meta.storage);
+    fh.reserved = 0;
+    ofs.seekp(0);
+    ofs.write(reinterpret_cast<const char*>(&fh), sizeof(fh));
+    ofs.close();
+    // The data must be on disk before the rename makes it the table
+    if (!ofs || !syncPath(tmp_path)) {
+        errorStream() << "Error: Failed writing " << tmp_path << ".\n";
+        return false;
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(tmp_path, filepath, ec);
+    if (ec) {
+        errorStream() << "Error: Unable to replace " << filepath << ": " << ec.message() << "\n";
+        return false;
+    }
+    std::string dir = std::filesystem::path(filepath).parent_path().string();
+    syncPath(dir.empty() ? "." : dir);
+    return true;
+}
+
+bool writeTableFile(const std::string& filepath, const TableData& data) {
+    return writeTableFile(filepath, data, data.records.size(), [&](size_t row, size_t col) {
+        return data.records[row].field(col);
+    });
+}
+
+// Header pages are the only part of the file read when a table is opened
+static bool decodeHeader(const std::string& filepath, const MappedFile& file, FileHeader& fh,
+                         TableData& data) {
+    if (file.size() < FILE_HEADER_V1_SIZE) {
+        errorStream() << "Error: " << filepath << " is truncated.\n";
+        return false;
+    }
+    fh = FileHeader();
+    std::memcpy(&fh, file.data(), FILE_HEADER_V1_SIZE);
+    if (std::memcmp(fh.magic, TABLE_MAGIC, sizeof(TABLE_MAGIC)) != 0 ||
+        fh.version < 1 || fh.version > TABLE_FILE_VERSION || fh.page_size != TABLE_PAGE_SIZE) {
+        errorStream() << "Error: " << filepath << " has an unsupported format.\n";
+        return false;
+    }
+    std::memcpy(&fh, file.data(), headerSize(fh.version));
+    if (file.size() < (fh.header_pages + fh.data_pages) * TABLE_PAGE_SIZE) {
+        errorStream() << "Error: " << filepath << " is truncated.\n";
+        return false;
+    }
+
+    const char* p = file.data() + headerSize(fh.version);
+    const char* header_end = file.data() + static_cast<size_t>(fh.header_pages) * TABLE_PAGE_SIZE;
+    auto read_u32 = [&](uint32_t& value) {
+        if (header_end - p < static_cast<std::ptrdiff_t>(sizeof(value))) return false;
+        std::memcpy(&value, p, sizeof(value));
+        p += sizeof(value);
+        return true;
+    };
+    auto read_string = [&](std::string& value) {
+        uint32_t len;
+        if (!read_u32(len) || header_end - p < static_cast<std::ptrdiff_t>(len)) return false;
+        value.assign(p, len);
+        p += len;
+        return true;
+    };
+
+    bool intact = true;
+    data.columns.assign(fh.column_count, std::string());
+    for (auto& col : data.columns) {
+        intact = intact && read_string(col);
+    }
+    data.types.assign(fh.column_count, ColumnType::Text);
+    if (intact && fh.version >= 4) {
+        intact = header_end - p >= static_cast<std::ptrdiff_t>(fh.column_count);
+        for (uint32_t c = 0; intact && c < fh.column_count; ++c) {
+            uint8_t type = static_cast<uint8_t>(*p++);
+            intact = type <= static_cast<uint8_t>(ColumnType::Bool);
+            data.types[c] = static_cast<ColumnType>(type);
+        }
+    }
+    data.indexes.clear();
+    uint32_t index_count = 0;
+    if (intact && fh.version >= 3) {
+        intact = read_u32(index_count);
+    }
+    for (uint32_t i = 0; intact && i < index_count; ++i) {
+        IndexDefinition index;
+        intact = read_string(index.name) && read_u32(index.column) && header_end - p >= 1;
+        if (intact) {
+            index.kind = static_cast<IndexKind>(*p++);
+            data.indexes.push_back(index);
+        }
+    }
+    data.dictionaries.assign(fh.column_count, {});
+    for (uint32_t c = 0; intact && fh.version >= 5 && c < fh.column_count; ++c) {
+        uint32_t value_count = 0;
+        intact = read_u32(value_count);
+        std::vector<std::string>& values = data.dictionaries[c];
+        for (uint32_t v = 0; intact && v < value_count; ++v) {
+            values.emplace_back();
+            intact = read_string(values.back());
+        }
+    }
+    if (!intact) {
+        errorStream() << "Error: " << filepath << " has a corrupt header.\n";
+    }
+    return intact;
+}
+
+bool openTableFile(const std::string& filepath, TableData& data) {
+    auto file = std::make_shared<MappedFile>();
+    if (!file->open(filepath)) {
+        errorStream() << "Error: Unable to open file " << filepath << " for reading.\n";
+        return false;
+    }
+    FileHeader fh;
+    if (!decodeHeader(filepath, *file, fh, data)) {
+        return false;
+    }
+    data.checkpoint_lsn = fh.checkpoint_lsn;
+    data.row_count = fh.row_count;
+    data.storage = fh.storage == static_cast<uint32_t>(StorageKind::Column) ? StorageKind::Column : StorageKind::Row;
+    data.records.clear();
+    data.mapping = std::move(file);
+    return true;
+}
+
+bool indexTableRows(const std::string& filepath, TableData& data) {
+    const MappedFile& file = *data.mapping;
+    FileHeader fh;
+    std::memcpy(&fh, file.data(), FILE_HEADER_V1_SIZE);
+    uint32_t column_count = fh.column_count;
+    size_t file_pages = fh.header_pages + fh.data_pages;
+
+    data.records.clear();
+    data.records.reserve(fh.row_count);
+    size_t page_no = fh.header_pages;
+    while (page_no < file_pages) {
+        const char* page = file.data() + page_no * TABLE_PAGE_SIZE;
+        PageHeader ph;
+        std::memcpy(&ph, page, sizeof(ph));
+        if (ph.span_pages == 0 || page_no + ph.span_pages > file_pages ||
+            ph.used_bytes > ph.span_pages * TABLE_PAGE_SIZE - sizeof(ph)) {
+            errorStream() << "Error: " << filepath << " has a corrupt page " << page_no << ".\n";
+            return false;
+        }
+        // Only the length prefixes are read here; field bytes stay untouched
+        const char* row = page + sizeof(ph);
+        const char* end = row + ph.used_bytes;
+        for (uint32_t r = 0; r < ph.row_count; ++r) {
+            const char* row_start = row;
+            for (uint32_t f = 0; f < column_count; ++f) {
+                uint32_t len = 0;
+                bool intact = end - row >= static_cast<std::ptrdiff_t>(sizeof(len));
+                if (intact) {
+                    std::memcpy(&len, row, sizeof(len));
+                    row += sizeof(len);
+                    intact = end - row >= static_cast<std::ptrdiff_t>(len);
+                }
+                if (!intact) {
+                    errorStream() << "Error: " << filepath << " has a corrupt row in page " << page_no << ".\n";
+                    return false;
+                }
+                row += len;
+            }
+            data.records.emplace_back(row_start, column_count);
+        }
+        page_no += ph.span_pages;
+    }
+    return true;
+}
+
+bool readTableFile(const std::string& filepath, TableData& data) {
+    if (!openTableFile(filepath, data) || !indexTableRows(filepath, data)) {
+        return false;
+    }
+    bool coded = false;
+    for (const auto& values : data.dictionaries) coded = coded || !values.empty();
+    for (auto& record : data.records) {
+        std::vector<std::string> fields = record.materialize();
+        for (size_t c = 0; coded && c < fields.size(); ++c) {
+            const std::vector<std::string>& values = data.dictionaries[c];
+            if (values.empty()) continue;
+            uint32_t code = UINT32_MAX;
+            if (fields[c].size() == sizeof(code)) std::memcpy(&code, fields[c].data(), sizeof(code));
+            if (code >= values.size()) {
+                errorStream() << "Error: " << filepath << " has a row with an unknown dictionary code.\n";
+                return false;
+            }
+            fields[c] = values[code];
+        }
+        record = Record(std::move(fields));
+    }
+    // The records now hold the values themselves
+    data.dictionaries.assign(data.columns.size(), {});
+    data.mapping.reset();
+    return true;
+}
+
+bool readCsvTable(const std::string& filepath, TableData& data) {
+    std::ifstream ifs(filepath);
+    if (!ifs) {
+        errorStream() << "Error: Unable to open file " << filepath << " for reading.\n";
+        return false;
+    }
+    std::string line;
+    bool is_header = true;
+    while (std::getline(ifs, line)) {
+        std::vector<std::string> fields;
+        bool in_quotes = false;
+        std::string current_field;
+        for (size_t i = 0; i < line.size(); ++i) {
+            char c = line[i];
+            if (c == '"' ) {
+                in_quotes = !in_quotes;
+            }
+            else if (c == ',' && !in_quotes) {
+                fields.push_back(std::move(current_field));
+                current_field.clear();
+            }
+            else {
+                current_field += c;
+            }
+        }
+        fields.push_back(std::move(current_field));
+
+        if (is_header) {
+            data.columns = fields;
+            is_header = false;
+        } else {
+            data.records.emplace_back(std::move(fields));
+        }
+    }
+    return true;
+}
+
+bool writeCsvTable(const std::string& filepath, const TableData& data) {
+    std::ofstream ofs(filepath, std::ios::trunc);
+    if (!ofs) {
+        errorStream() << "Error: Unable to open file " << filepath << " for writing.\n";
+        return false;
+    }
+    // First line: column headers
+    for (size_t i = 0; i < data.columns.size(); ++i) {
+        ofs << data.columns[i];
+        if (i != data.columns.size() - 1) ofs << ",";
+    }
+    ofs << "\n";
+
+    // Records
+    for (const auto& record : data.records) {
+        for (size_t i = 0; i < record.size(); ++i) {
+            // Escape commas in fields
+            std::string_view field = record.field(i);
+            if (field.find(',') != std::string_view::npos) {
+                ofs << "\"" << field << "\"";
+            } else {
+                ofs << field;
+            }
+            if (i != record.size() - 1) ofs << ",";
+        }
+        ofs << "\n";
+    }
+    return static_cast<bool>(ofs);
+}
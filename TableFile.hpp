@@ -0,0 +1,89 @@
+// TableFile.hpp
+#ifndef TABLE_FILE_HPP
+#define TABLE_FILE_HPP
+
+#include "Index.hpp"
+#include "MappedFile.hpp"
+#include "Record.hpp"
+#include "Value.hpp"
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Binary table format, version 5:
+//   header page(s): magic, version, page size, row/page counts, checkpoint LSN,
+//                   storage layout, schema (names, then one type byte per column),
+//                   index definitions, then per column a u32 count and that many
+//                   dictionary values
+//   data pages:     page header followed by rows packed back to back
+// A row is its fields in column order, each as a u32 length and the stored
+// bytes (see Value.hpp: native numbers, raw TEXT). A column with a dictionary
+// stores the u32 code of each value instead, numbered in dictionary order.
+// Rows never straddle a page boundary; a row larger than one page gets a run
+// of consecutive pages to itself so its bytes stay contiguous.
+// Version 1 (no storage layout), 2 (no indexes), 3 (untyped, every column
+// TEXT) and 4 (no dictionaries) files are still read.
+const uint32_t TABLE_FILE_VERSION = 5;
+const uint32_t TABLE_PAGE_SIZE = 4096;
+
+// In-memory layout a table is loaded into; the file format is the same for both
+enum class StorageKind : uint32_t {
+    Row = 0,
+    Column = 1
+};
+
+struct PageHeader {
+    uint32_t row_count;  // rows starting in this page
+    uint32_t used_bytes; // bytes of row data after the header
+    uint32_t span_pages; // 1, or the length of an oversized row's run
+    uint32_t reserved;
+};
+
+// Only the definition is stored; index contents are rebuilt from the rows
+struct IndexDefinition {
+    std::string name;
+    uint32_t column;
+    IndexKind kind;
+};
+
+// Everything a table file holds. After openTableFile() only the header is
+// decoded; indexTableRows() then fills records with views into the mapping.
+struct TableData {
+    std::vector<std::string> columns;
+    std::vector<ColumnType> types; // parallel to columns; missing entries are TEXT
+    std::vector<Record> records;
+    uint64_t checkpoint_lsn = 0; // last log frame folded into the file
+    uint64_t row_count = 0;
+    StorageKind storage = StorageKind::Row;
+    std::vector<IndexDefinition> indexes;
+    // Per column, the values its rows store codes of; empty for columns stored
+    // as plain values. Only columnar tables write any.
+    std::vector<std::vector<std::string>> dictionaries;
+    std::shared_ptr<MappedFile> mapping;
+};
+
+// Supplies column col of row row while a table is written out
+using FieldReader = std::function<std::string_view(size_t row, size_t col)>;
+
+// Returns true if the file starts with the binary table magic
+bool isBinaryTableFile(const std::string& filepath);
+
+// Binary format: map the file and decode the header without touching data pages
+bool openTableFile(const std::string& filepath, TableData& data);
+// Walk the data pages once, recording where each row starts
+bool indexTableRows(const std::string& filepath, TableData& data);
+// open + index + copy every field out of the mapping, decoding dictionary codes
+bool readTableFile(const std::string& filepath, TableData& data);
+// Write the header fields of meta and row_count rows pulled through field
+bool writeTableFile(const std::string& filepath, const TableData& meta, size_t row_count, const FieldReader& field);
+// Write data.records
+bool writeTableFile(const std::string& filepath, const TableData& data);
+
+// Legacy comma separated format, kept for conversion and benchmarking
+bool readCsvTable(const std::string& filepath, TableData& data);
+bool writeCsvTable(const std::string& filepath, const TableData& data);
+
+#endif // TABLE_FILE_HPP
@@ -0,0 +1,81 @@
+// ThreadPool.cpp
+#include "ThreadPool.hpp"
+#include <algorithm>
+#include <cstdlib>
+
+ThreadPool::ThreadPool(size_t threads) : max_parallelism(threads) {
+    for (size_t i = 1; i < threads; ++i) {
+        workers.emplace_back([this]() { workerLoop(); });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex);
+        stopping = true;
+    }
+    queue_ready.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+ThreadPool& ThreadPool::shared() {
+    // MINIDB_THREADS overrides the pool size, e.g. to leave cores to other processes
+    static ThreadPool pool([]() -> size_t {
+        const char* env = std::getenv("MINIDB_THREADS");
+        size_t threads = env ? std::strtoul(env, nullptr, 10) : std::thread::hardware_concurrency();
+        return std::max<size_t>(1, threads);
+    }());
+    return pool;
+}
+
+void ThreadPool::setMaxParallelism(size_t dop) {
+    max_parallelism = dop == 0 ? threadCount() : std::min(dop, threadCount());
+}
+
+void ThreadPool::workerLoop() {
+    while (true) {
+        std::shared_ptr<Job> job;
+        {
+            std::unique_lock<std::mutex> lock(queue_mutex);
+            queue_ready.wait(lock, [this]() { return stopping || !queue.empty(); });
+            if (stopping && queue.empty()) return;
+            job = std::move(queue.front());
+            queue.pop_front();
+        }
+        runTasks(*job);
+    }
+}
+
+void ThreadPool::runTasks(Job& job) {
+    size_t ran = 0;
+    for (size_t task = job.next++; task < job.tasks; task = job.next++) {
+        job.body(task);
+        ran++;
+    }
+    if (ran == 0) return;
+    std::lock_guard<std::mutex> lock(job.done_mutex);
+    job.finished += ran;
+    if (job.finished == job.tasks) job.done.notify_all();
+}
+
+void ThreadPool::parallelFor(size_t tasks, const std::function<void(size_t task)>& body) {
+    size_t helpers = std::min(tasks, static_cast<size_t>(max_parallelism)) - (tasks > 0 ? 1 : 0);
+    if (helpers == 0) {
+        for (size_t task = 0; task < tasks; ++task) body(task);
+        return;
+    }
+    auto job = std::make_shared<Job>();
+    job->body = body;
+    job->tasks = tasks;
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex);
+        for (size_t i = 0; i < helpers; ++i) queue.push_back(job);
+    }
+    queue_ready.notify_all();
+    runTasks(*job);
+    // Helpers that start after every task is taken find nothing to do and only touch the shared job
+    std::unique_lock<std::mutex> lock(job->done_mutex);
+    job->done.wait(lock, [&]() { return job->finished == job->tasks; });
+}
@@ -0,0 +1,78 @@
+// ThreadPool.hpp
+#ifndef THREAD_POOL_HPP
+#define THREAD_POOL_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Worker threads shared by every statement. parallelFor() hands out task
+// numbers from a shared counter, so fast threads simply take more of them
+// (morsel-driven scheduling); the calling thread always takes part too.
+class ThreadPool {
+private:
+    struct Job {
+        std::function<void(size_t)> body;
+        size_t tasks = 0;
+        std::atomic<size_t> next{0};
+        size_t finished = 0; // guarded by done_mutex
+        std::mutex done_mutex;
+        std::condition_variable done;
+    };
+
+    std::vector<std::thread> workers;
+    std::deque<std::shared_ptr<Job>> queue; // one entry per helper a job asked for
+    std::mutex queue_mutex;
+    std::condition_variable queue_ready;
+    bool stopping = false;
+    std::atomic<size_t> max_parallelism;
+
+    void workerLoop();
+    static void runTasks(Job& job);
+
+public:
+    explicit ThreadPool(size_t threads);
+    ~ThreadPool();
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Pool sized to the machine, created on first use
+    static ThreadPool& shared();
+
+    // Threads (including the caller) one parallelFor() may use; 0 restores the default of all of them
+    void setMaxParallelism(size_t dop);
+    size_t maxParallelism() const { return max_parallelism; }
+    size_t threadCount() const { return workers.size() + 1; }
+
+    // Run body(task) for every task in [0, tasks) and return once all have finished
+    void parallelFor(size_t tasks, const std::function<void(size_t task)>& body);
+
+    // Like parallelFor(), but each task produces a Result that is handed to
+    // consume in task order, one at a time, as soon as its predecessors are
+    // done. Results are deterministic however the tasks were scheduled.
+    template <typename Result>
+    void parallelForOrdered(size_t tasks, const std::function<Result(size_t task)>& work,
+                            const std::function<void(Result&)>& consume) {
+        std::mutex mutex;
+        std::map<size_t, Result> pending;
+        size_t next = 0;
+        parallelFor(tasks, [&](size_t task) {
+            Result result = work(task);
+            std::lock_guard<std::mutex> lock(mutex);
+            pending.emplace(task, std::move(result));
+            for (auto it = pending.begin(); it != pending.end() && it->first == next; it = pending.erase(it)) {
+                consume(it->second);
+                next++;
+            }
+        });
+    }
+};
+
+#endif // THREAD_POOL_HPP
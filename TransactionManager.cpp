@@ -0,0 +1,37 @@
+// TransactionManager.cpp
+#include "TransactionManager.hpp"
+
+Snapshot TransactionManager::begin(bool writer) {
+    std::lock_guard<std::mutex> lock(mutex);
+    Snapshot snapshot;
+    snapshot.read_ts = last_commit;
+    if (writer) snapshot.txn = next_txn++;
+    open_snapshots.insert(snapshot.read_ts);
+    return snapshot;
+}
+
+void TransactionManager::end(const Snapshot& snapshot) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = open_snapshots.find(snapshot.read_ts);
+    if (it != open_snapshots.end()) open_snapshots.erase(it);
+}
+
+uint64_t TransactionManager::commitTimestamp() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return last_commit + 1;
+}
+
+void TransactionManager::publish(uint64_t commit_ts) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (commit_ts > last_commit) last_commit = commit_ts;
+}
+
+size_t TransactionManager::openCount() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return open_snapshots.size();
+}
+
+uint64_t TransactionManager::horizon() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return open_snapshots.empty() ? last_commit : *open_snapshots.begin();
+}
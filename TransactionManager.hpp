@@ -0,0 +1,33 @@
+// TransactionManager.hpp
+#ifndef TRANSACTION_MANAGER_HPP
+#define TRANSACTION_MANAGER_HPP
+
+#include "Snapshot.hpp"
+#include <cstdint>
+#include <mutex>
+#include <set>
+
+// Hands out snapshots and commit timestamps, and knows the oldest snapshot
+// still open so that versions nobody can see any more are garbage collected
+class TransactionManager {
+private:
+    std::mutex mutex;
+    uint64_t last_commit = 0;
+    uint64_t next_txn = 1;
+    std::multiset<uint64_t> open_snapshots; // read_ts of every snapshot not yet ended
+
+public:
+    // Snapshot of everything committed so far; a writer also gets a transaction id
+    Snapshot begin(bool writer);
+    void end(const Snapshot& snapshot);
+    // Timestamp for the next commit. Tables stamp the transaction's versions
+    // with it, and publish() then makes them visible to new snapshots at once.
+    uint64_t commitTimestamp();
+    void publish(uint64_t commit_ts);
+    // Versions deleted at or before this are invisible to every open and future
+    // snapshot; versions created at or before it are visible to all of them
+    uint64_t horizon();
+    size_t openCount();
+};
+
+#endif // TRANSACTION_MANAGER_HPP
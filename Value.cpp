@@ -0,0 +1,123 @@
+// Value.cpp
+#include "Value.hpp"
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+
+bool parseColumnType(const std::string& name, ColumnType& type) {
+    std::string upper = name;
+    std::transform(upper.begin(), upper.end(), upper.begin(), ::toupper);
+    if (upper == "TEXT") type = ColumnType::Text;
+    else if (upper == "INT") type = ColumnType::Int;
+    else if (upper == "BIGINT") type = ColumnType::BigInt;
+    else if (upper == "DOUBLE") type = ColumnType::Double;
+    else if (upper == "BOOL") type = ColumnType::Bool;
+    else return false;
+    return true;
+}
+
+const char* columnTypeName(ColumnType type) {
+    switch (type) {
+        case ColumnType::Text: return "TEXT";
+        case ColumnType::Int: return "INT";
+        case ColumnType::BigInt: return "BIGINT";
+        case ColumnType::Double: return "DOUBLE";
+        case ColumnType::Bool: return "BOOL";
+    }
+    return "TEXT";
+}
+
+template <typename T>
+static bool parseNumber(std::string_view text, T& value) {
+    const char* begin = text.data();
+    const char* end = text.data() + text.size();
+    if (begin != end && *begin == '+') ++begin; // from_chars rejects an explicit plus sign
+    auto result = std::from_chars(begin, end, value);
+    return result.ec == std::errc() && result.ptr == end && begin != end;
+}
+
+template <typename T>
+static void storeValue(std::string& out, T value) {
+    out.assign(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+bool encodeValue(ColumnType type, std::string_view text, std::string& out) {
+    switch (type) {
+        case ColumnType::Text:
+            out.assign(text);
+            return true;
+        case ColumnType::Int: {
+            int32_t value;
+            if (!parseNumber(text, value)) return false;
+            storeValue(out, value);
+            return true;
+        }
+        case ColumnType::BigInt: {
+            int64_t value;
+            if (!parseNumber(text, value)) return false;
+            storeValue(out, value);
+            return true;
+        }
+        case ColumnType::Double: {
+            double value;
+            if (!parseNumber(text, value) || !std::isfinite(value)) return false;
+            if (value == 0) value = 0; // -0.0 and 0.0 must store the same bytes for hashing
+            storeValue(out, value);
+            return true;
+        }
+        case ColumnType::Bool: {
+            std::string upper(text);
+            std::transform(upper.begin(), upper.end(), upper.begin(), ::toupper);
+            if (upper == "TRUE" || upper == "1") out.assign(1, '\1');
+            else if (upper == "FALSE" || upper == "0") out.assign(1, '\0');
+            else return false;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool isNumericLiteral(std::string_view text) {
+    size_t i = 0;
+    auto digits = [&]() {
+        size_t start = i;
+        while (i < text.size() && text[i] >= '0' && text[i] <= '9') ++i;
+        return i - start;
+    };
+    if (i < text.size() && (text[i] == '+' || text[i] == '-')) ++i;
+    size_t whole = digits();
+    size_t fraction = 0;
+    if (i < text.size() && text[i] == '.') {
+        ++i;
+        fraction = digits();
+    }
+    if (whole + fraction == 0) return false;
+    if (i < text.size() && (text[i] == 'e' || text[i] == 'E')) {
+        ++i;
+        if (i < text.size() && (text[i] == '+' || text[i] == '-')) ++i;
+        if (digits() == 0) return false;
+    }
+    return i == text.size();
+}
+
+std::string formatDouble(double value) {
+    char buf[32];
+    auto result = std::to_chars(buf, buf + sizeof(buf), value);
+    return std::string(buf, result.ptr);
+}
+
+std::string formatValue(ColumnType type, std::string_view stored) {
+    if (type == ColumnType::Text || stored.size() != fixedWidth(type)) {
+        return std::string(stored);
+    }
+    char buf[32];
+    std::to_chars_result result{buf, std::errc()};
+    switch (type) {
+        case ColumnType::Int: result = std::to_chars(buf, buf + sizeof(buf), loadValue<int32_t>(stored)); break;
+        case ColumnType::BigInt: result = std::to_chars(buf, buf + sizeof(buf), loadValue<int64_t>(stored)); break;
+        case ColumnType::Double: return formatDouble(loadValue<double>(stored));
+        case ColumnType::Bool: return stored[0] ? "true" : "false";
+        case ColumnType::Text: break;
+    }
+    return std::string(buf, result.ptr);
+}
@@ -0,0 +1,75 @@
+// Value.hpp
+#ifndef VALUE_HPP
+#define VALUE_HPP
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+// Declared type of a column. Values of fixed-width types are stored in their
+// native little-endian representation; TEXT is stored as the raw bytes.
+enum class ColumnType : uint8_t {
+    Text = 0,
+    Int = 1,    // int32_t
+    BigInt = 2, // int64_t
+    Double = 3, // finite double
+    Bool = 4    // one byte, 0 or 1
+};
+
+// Maps a type name (case-insensitive) to a type; returns false for anything else
+bool parseColumnType(const std::string& name, ColumnType& type);
+const char* columnTypeName(ColumnType type);
+
+// Size of every stored value of the type, or 0 for variable-length TEXT
+inline uint32_t fixedWidth(ColumnType type) {
+    switch (type) {
+        case ColumnType::Int: return sizeof(int32_t);
+        case ColumnType::BigInt: return sizeof(int64_t);
+        case ColumnType::Double: return sizeof(double);
+        case ColumnType::Bool: return 1;
+        case ColumnType::Text: break;
+    }
+    return 0;
+}
+
+// Validate a literal and convert it to the stored form; returns false if the
+// text is not a valid value of the type
+bool encodeValue(ColumnType type, std::string_view text, std::string& out);
+// Whether text is a decimal number: an optional sign, digits with an optional
+// fraction, and an optional exponent
+bool isNumericLiteral(std::string_view text);
+// Stored form back to text for display
+std::string formatValue(ColumnType type, std::string_view stored);
+// Shortest text that reads back as the same double
+std::string formatDouble(double value);
+
+template <typename T>
+inline T loadValue(std::string_view stored) {
+    T value;
+    std::memcpy(&value, stored.data(), sizeof(T));
+    return value;
+}
+
+template <typename T>
+inline int compareNumbers(T a, T b) {
+    return (a > b) - (a < b);
+}
+
+// Three-way comparison of two stored values: numbers compare numerically, TEXT bytewise
+inline int compareValues(ColumnType type, std::string_view a, std::string_view b) {
+    uint32_t width = fixedWidth(type);
+    if (width != 0 && a.size() == width && b.size() == width) {
+        switch (type) {
+            case ColumnType::Int: return compareNumbers(loadValue<int32_t>(a), loadValue<int32_t>(b));
+            case ColumnType::BigInt: return compareNumbers(loadValue<int64_t>(a), loadValue<int64_t>(b));
+            case ColumnType::Double: return compareNumbers(loadValue<double>(a), loadValue<double>(b));
+            case ColumnType::Bool: return compareNumbers(a[0], b[0]);
+            case ColumnType::Text: break;
+        }
+    }
+    int c = a.compare(b);
+    return (c > 0) - (c < 0);
+}
+
+#endif // VALUE_HPP
@@ -0,0 +1,336 @@
+// WriteAheadLog.cpp
+#include "WriteAheadLog.hpp"
+#include "Diagnostics.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+// File layout: magic, base LSN, then frames of
+// [u32 payload length][u32 checksum][u64 lsn][u32 entry count][entries...]
+static const char WAL_MAGIC[8] = {'M', 'D', 'B', 'W', 'A', 'L', '0', '1'};
+static const size_t WAL_HEADER_SIZE = sizeof(WAL_MAGIC) + sizeof(uint64_t);
+static const size_t FRAME_HEADER_SIZE = 2 * sizeof(uint32_t);
+
+static uint32_t checksum(const char* data, size_t len) {
+    // FNV-1a, enough to detect a torn or partially flushed frame
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < len; ++i) {
+        hash ^= static_cast<unsigned char>(data[i]);
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+template <typename T>
+static void putRaw(std::string& buf, T value) {
+    buf.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+static void putString(std::string& buf, const std::string& s) {
+    putRaw<uint32_t>(buf, static_cast<uint32_t>(s.size()));
+    buf.append(s);
+}
+
+template <typename T>
+static bool getRaw(const char*& p, const char* end, T& value) {
+    if (static_cast<size_t>(end - p) < sizeof(T)) return false;
+    std::memcpy(&value, p, sizeof(T));
+    p += sizeof(T);
+    return true;
+}
+
+static bool getString(const char*& p, const char* end, std::string& s) {
+    uint32_t len;
+    if (!getRaw(p, end, len) || static_cast<size_t>(end - p) < len) return false;
+    s.assign(p, len);
+    p += len;
+    return true;
+}
+
+static std::string readFile(const std::string& filepath) {
+    std::ifstream ifs(filepath, std::ios::binary);
+    if (!ifs) return "";
+    return std::string(std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>());
+}
+
+// Walk the valid frames of a log image. Returns the offset just past the last
+// intact frame; anything after it is a torn tail from an interrupted append.
+static size_t scanFrames(const std::string& image, uint64_t& base_lsn,
+                         const std::function<void(uint64_t, const char*, const char*)>& visit) {
+    if (image.size() < WAL_HEADER_SIZE || std::memcmp(image.data(), WAL_MAGIC, sizeof(WAL_MAGIC)) != 0) {
+        return 0;
+    }
+    std::memcpy(&base_lsn, image.data() + sizeof(WAL_MAGIC), sizeof(uint64_t));
+
+    size_t pos = WAL_HEADER_SIZE;
+    while (image.size() - pos >= FRAME_HEADER_SIZE) {
+        uint32_t len, sum;
+        std::memcpy(&len, image.data() + pos, sizeof(uint32_t));
+        std::memcpy(&sum, image.data() + pos + sizeof(uint32_t), sizeof(uint32_t));
+        const char* payload = image.data() + pos + FRAME_HEADER_SIZE;
+        if (image.size() - pos - FRAME_HEADER_SIZE < len || checksum(payload, len) != sum) {
+            break;
+        }
+        const char* p = payload;
+        uint64_t lsn;
+        if (!getRaw(p, payload + len, lsn)) break;
+        visit(lsn, p, payload + len);
+        pos += FRAME_HEADER_SIZE + len;
+    }
+    return pos;
+}
+
+static bool decodeEntries(const char* p, const char* end, std::vector<WalEntry>& entries) {
+    uint32_t count;
+    if (!getRaw(p, end, count)) return false;
+    for (uint32_t i = 0; i < count; ++i) {
+        uint8_t op;
+        std::string table;
+        uint32_t argc;
+        if (!getRaw(p, end, op) || !getString(p, end, table) || !getRaw(p, end, argc)) return false;
+        std::vector<std::string> args(argc);
+        for (auto& arg : args) {
+            if (!getString(p, end, arg)) return false;
+        }
+        entries.emplace_back(static_cast<WalOp>(op), table, args);
+    }
+    return true;
+}
+
+static bool writeFully(int fd, const char* data, size_t len) {
+    while (len > 0) {
+        ssize_t n = ::write(fd, data, len);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        data += n;
+        len -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+static bool writeHeader(const std::string& filepath, uint64_t base_lsn) {
+    int fd = ::open(filepath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) return false;
+    std::string header(WAL_MAGIC, sizeof(WAL_MAGIC));
+    putRaw<uint64_t>(header, base_lsn);
+    bool ok = writeFully(fd, header.data(), header.size()) && ::fdatasync(fd) == 0;
+    ::close(fd);
+    return ok;
+}
+
+const char* durabilityName(Durability durability) {
+    switch (durability) {
+        case Durability::Sync: return "sync";
+        case Durability::Async: return "async";
+        case Durability::Off: return "off";
+    }
+    return "sync";
+}
+
+bool parseDurability(const std::string& name, Durability& durability) {
+    for (Durability d : {Durability::Sync, Durability::Async, Durability::Off}) {
+        std::string candidate = durabilityName(d);
+        if (name.size() == candidate.size() &&
+            std::equal(name.begin(), name.end(), candidate.begin(),
+                       [](char a, char b) { return std::tolower(static_cast<unsigned char>(a)) == b; })) {
+            durability = d;
+            return true;
+        }
+    }
+    return false;
+}
+
+WriteAheadLog::WriteAheadLog(const std::string& filepath) : filepath(filepath) {
+    std::string image = readFile(filepath);
+    uint64_t base_lsn = 1;
+    size_t valid_end = scanFrames(image, base_lsn, [&](uint64_t lsn, const char* p, const char* end) {
+        next_lsn = lsn + 1;
+        std::vector<WalEntry> entries;
+        decodeEntries(p, end, entries);
+        for (const auto& entry : entries) logged_at_open[entry.table] = lsn;
+    });
+    if (next_lsn < base_lsn) next_lsn = base_lsn;
+
+    if (valid_end == 0) {
+        if (!image.empty()) {
+            errorStream() << "Error: " << filepath << " is not a valid log, starting a new one.\n";
+        }
+        writeHeader(filepath, next_lsn);
+        valid_end = WAL_HEADER_SIZE;
+    } else if (valid_end < image.size()) {
+        // Cut the torn tail so new frames follow the last complete commit
+        std::filesystem::resize_file(filepath, valid_end);
+    }
+    size_bytes = valid_end;
+    written_lsn = next_lsn - 1;
+    openForAppend();
+    flusher = std::thread([this]() { flushLoop(); });
+}
+
+WriteAheadLog::~WriteAheadLog() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    queued.notify_one();
+    flusher.join(); // writes whatever is still queued first
+    if (fd >= 0) {
+        ::fdatasync(fd);
+        ::close(fd);
+    }
+}
+
+bool WriteAheadLog::openForAppend() {
+    fd = ::open(filepath.c_str(), O_WRONLY | O_APPEND | O_CREAT, 0644);
+    if (fd < 0) {
+        errorStream() << "Error: Unable to open log " << filepath << " for writing.\n";
+        return false;
+    }
+    return true;
+}
+
+void WriteAheadLog::flushLoop() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        queued.wait(lock, [this]() { return stopping || !batch.empty(); });
+        if (batch.empty()) break; // stopping with nothing left to write
+        if (window.count() > 0 && !stopping) {
+            // Give other committers the window to join this batch
+            queued.wait_for(lock, window, [this]() { return stopping; });
+        }
+        std::string frames;
+        frames.swap(batch);
+        size_t commits = batch_commits;
+        bool sync = batch_needs_sync;
+        uint64_t last_lsn = next_lsn - 1;
+        bool ok = !failed && fd >= 0;
+        batch_commits = 0;
+        batch_needs_sync = false;
+
+        // Committers keep queueing the next batch while this one is written
+        lock.unlock();
+        ok = ok && writeFully(fd, frames.data(), frames.size());
+        ok = ok && (!sync || ::fdatasync(fd) == 0);
+        lock.lock();
+
+        if (!ok && !failed) {
+            errorStream() << "Error: Unable to append to log " << filepath << ".\n";
+            failed = true;
+        }
+        stats.batches++;
+        stats.syncs += sync && ok;
+        stats.largest_batch = std::max<uint64_t>(stats.largest_batch, commits);
+        written_lsn = last_lsn;
+        written.notify_all();
+    }
+}
+
+bool WriteAheadLog::append(const std::vector<WalEntry>& entries, Durability durability) {
+    if (entries.empty()) return true;
+    uint64_t lsn = queue(entries, durability);
+    if (lsn == 0) return false;
+    return durability != Durability::Sync || waitFor(lsn);
+}
+
+uint64_t WriteAheadLog::queue(const std::vector<WalEntry>& entries, Durability durability) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (failed) return 0;
+    std::string payload;
+    putRaw<uint64_t>(payload, next_lsn);
+    putRaw<uint32_t>(payload, static_cast<uint32_t>(entries.size()));
+    for (const auto& entry : entries) {
+        putRaw<uint8_t>(payload, static_cast<uint8_t>(entry.op));
+        putString(payload, entry.table);
+        putRaw<uint32_t>(payload, static_cast<uint32_t>(entry.args.size()));
+        for (const auto& arg : entry.args) {
+            putString(payload, arg);
+        }
+    }
+
+    std::string frame;
+    frame.reserve(FRAME_HEADER_SIZE + payload.size());
+    putRaw<uint32_t>(frame, static_cast<uint32_t>(payload.size()));
+    putRaw<uint32_t>(frame, checksum(payload.data(), payload.size()));
+    frame.append(payload);
+
+    uint64_t lsn = next_lsn++;
+    batch.append(frame);
+    batch_commits++;
+    batch_needs_sync = batch_needs_sync || durability != Durability::Off;
+    size_bytes += frame.size();
+    stats.commits++;
+    queued.notify_one();
+    return lsn;
+}
+
+bool WriteAheadLog::waitFor(uint64_t lsn) {
+    std::unique_lock<std::mutex> lock(mutex);
+    written.wait(lock, [&]() { return written_lsn >= lsn; });
+    return !failed;
+}
+
+void WriteAheadLog::flush() {
+    std::unique_lock<std::mutex> lock(mutex);
+    queued.notify_one();
+    written.wait(lock, [this]() { return written_lsn + 1 >= next_lsn; });
+    // Frames committed with Durability::Off were written without a sync
+    if (fd >= 0 && !failed) ::fdatasync(fd);
+}
+
+void WriteAheadLog::reset() {
+    flush();
+    std::lock_guard<std::mutex> lock(mutex);
+    if (fd >= 0) ::close(fd);
+    if (!writeHeader(filepath, next_lsn)) {
+        errorStream() << "Error: Unable to reset log " << filepath << ".\n";
+    }
+    size_bytes = WAL_HEADER_SIZE;
+    logged_at_open.clear();
+    failed = false; // the frames after a failed write are covered by the table files now
+    openForAppend();
+}
+
+uint64_t WriteAheadLog::lastLsnAtOpen(const std::string& table) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = logged_at_open.find(table);
+    return it == logged_at_open.end() ? 0 : it->second;
+}
+
+void WriteAheadLog::setCommitWindow(std::chrono::microseconds wait) {
+    std::lock_guard<std::mutex> lock(mutex);
+    window = wait;
+}
+
+std::chrono::microseconds WriteAheadLog::commitWindow() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return window;
+}
+
+WalStats WriteAheadLog::statistics() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return stats;
+}
+
+void WriteAheadLog::replay(const std::string& filepath, const std::string& table, uint64_t after_lsn,
+                           const std::function<void(WalEntry&)>& apply) {
+    std::string image = readFile(filepath);
+    uint64_t base_lsn = 1;
+    scanFrames(image, base_lsn, [&](uint64_t lsn, const char* p, const char* end) {
+        if (lsn <= after_lsn) return; // already folded into the table file
+        std::vector<WalEntry> entries;
+        if (!decodeEntries(p, end, entries)) return;
+        for (auto& entry : entries) {
+            if (entry.table == table) {
+                apply(entry);
+            }
+        }
+    });
+}
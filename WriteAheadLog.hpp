@@ -0,0 +1,131 @@
+// WriteAheadLog.hpp
+#ifndef WRITE_AHEAD_LOG_HPP
+#define WRITE_AHEAD_LOG_HPP
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// Name of the per-database log in its data directory, shared by the writer and Table::load()
+inline const std::string WAL_FILE = "minidb.wal";
+
+// Fold the log into the table files once it grows past this size
+const uint64_t WAL_CHECKPOINT_BYTES = 4 * 1024 * 1024;
+
+enum class WalOp : uint8_t {
+    Insert = 1, // args: field values
+    Update = 2, // args: set column, set value, then the WHERE text (empty for none)
+    Delete = 3, // args: the WHERE text
+    // Older logs hold a "column value" pair or a four-argument comparison
+    // instead of the WHERE text; replay accepts all of them
+    // A transaction's changes, logged at COMMIT: by then other sessions may
+    // have logged rows its snapshot did not see, which its WHERE would match
+    // on replay, so the rows it changed are logged instead
+    UpdateRows = 4, // args: set column, set value, then each row's stored fields before the update
+    DeleteRows = 5  // args: each deleted row's stored fields
+};
+
+// When a commit returns, relative to its log frame reaching the disk
+enum class Durability {
+    Sync,  // after the frame is written and synced
+    Async, // at once; the frame is synced with the next batch
+    Off    // at once; the frame is written but only synced by a checkpoint
+};
+
+const char* durabilityName(Durability durability);
+bool parseDurability(const std::string& name, Durability& durability);
+
+// Group commit counters since the log was opened
+struct WalStats {
+    uint64_t commits = 0; // frames appended
+    uint64_t batches = 0; // writes, each carrying one or more frames
+    uint64_t syncs = 0;
+    uint64_t largest_batch = 0;
+};
+
+struct WalEntry {
+    WalOp op;
+    std::string table;
+    std::vector<std::string> args;
+
+    WalEntry(WalOp op, const std::string& table, const std::vector<std::string>& args)
+        : op(op), table(table), args(args) {}
+};
+
+// Append-only log of committed mutations. Each append() queues one frame
+// holding every entry of a commit, so a torn write drops the whole commit.
+// A flusher thread writes the queued frames of all committers with a single
+// write and a single fsync (group commit): commits arriving while one batch
+// is on its way to disk, or within the commit window, share the next one.
+class WriteAheadLog {
+private:
+    std::string filepath;
+    int fd = -1;
+    // Changed under mutex; read without it by sizeBytes() and nextLsn()
+    std::atomic<uint64_t> next_lsn{1};
+    std::atomic<uint64_t> size_bytes{0}; // including queued frames
+
+    mutable std::mutex mutex;
+    std::condition_variable queued;  // wakes the flusher
+    std::condition_variable written; // wakes committers waiting for their batch
+    std::string batch;               // frames not yet handed to the flusher
+    size_t batch_commits = 0;
+    bool batch_needs_sync = false;
+    uint64_t written_lsn = 0;        // every frame up to here is written (and synced if asked)
+    bool failed = false;             // a write failed; later frames would follow a torn one
+    bool stopping = false;
+    std::chrono::microseconds window{0};
+    WalStats stats;
+    // Last LSN of each table among the frames found when the log was opened
+    std::unordered_map<std::string, uint64_t> logged_at_open;
+    std::thread flusher;
+
+    void flushLoop();
+    bool openForAppend();
+
+public:
+    explicit WriteAheadLog(const std::string& filepath);
+    ~WriteAheadLog();
+    WriteAheadLog(const WriteAheadLog&) = delete;
+    WriteAheadLog& operator=(const WriteAheadLog&) = delete;
+
+    // Append one commit; returns false if the frame could not be written. With
+    // Durability::Sync this waits until the frame is on disk.
+    bool append(const std::vector<WalEntry>& entries, Durability durability = Durability::Sync);
+    // append() in two steps, so a writer can fix its frame's place in the log
+    // while it holds its table and wait for the disk after letting go:
+    // queue() returns the frame's LSN (0 if the log cannot be written), and
+    // waitFor() returns once that frame is written and synced as it asked
+    uint64_t queue(const std::vector<WalEntry>& entries, Durability durability);
+    bool waitFor(uint64_t lsn);
+    // Write and sync every queued frame
+    void flush();
+    // Discard the log after its contents have been folded into the tables
+    void reset();
+
+    // How long the flusher waits for more commits before writing a batch
+    void setCommitWindow(std::chrono::microseconds wait);
+    std::chrono::microseconds commitWindow();
+    WalStats statistics();
+
+    // Last frame for table that was already in the log when it was opened, 0 if
+    // none; such a table must be loaded (replaying them) before the log is reset
+    uint64_t lastLsnAtOpen(const std::string& table) const;
+
+    uint64_t sizeBytes() const { return size_bytes; }
+    uint64_t nextLsn() const { return next_lsn; }
+
+    // Invoke apply for every entry of the given table logged after after_lsn,
+    // oldest first; apply may take over the entry's arguments
+    static void replay(const std::string& filepath, const std::string& table, uint64_t after_lsn,
+                       const std::function<void(WalEntry&)>& apply);
+};
+
+#endif // WRITE_AHEAD_LOG_HPP
@@ -0,0 +1,87 @@
+// bench_arena.cpp
+// Cost of keeping ingested rows two ways: a Record owning a vector of strings
+// per row (one allocation for the vector and one per field too long for the
+// string's inline buffer), and rows encoded into a RowArena that Records view.
+// Counts calls to operator new and the bytes requested, through the counting
+// operator new of CountingNew.cpp, then does the same for Table::insert on a
+// row-layout table, given rows to copy and rows to move in.
+// Usage: bench_arena [rows]   (works in a scratch directory under /tmp)
+#include "MemoryStats.hpp"
+#include "RowArena.hpp"
+#include "Table.hpp"
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+
+struct Cost {
+    double ms;
+    uint64_t allocations;
+    uint64_t bytes;
+};
+
+template <typename Fn>
+static Cost measure(Fn fn) {
+    uint64_t allocations = allocationCount();
+    uint64_t bytes = allocatedBytes();
+    auto start = std::chrono::steady_clock::now();
+    fn();
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    return {elapsed.count(), allocationCount() - allocations, allocatedBytes() - bytes};
+}
+
+static void report(const char* label, const Cost& cost, size_t rows) {
+    std::cout << label << cost.ms << " ms, " << static_cast<double>(cost.allocations) / rows << " allocations and "
+              << static_cast<double>(cost.bytes) / rows << " bytes per row\n";
+}
+
+int main(int argc, char* argv[]) {
+    size_t rows = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1000000;
+    std::vector<std::vector<std::string>> input(rows);
+    for (size_t i = 0; i < rows; ++i) {
+        input[i] = {std::to_string(i), "user" + std::to_string(i % 5000),
+                    "user" + std::to_string(i) + "@example.com", "note number " + std::to_string(i) + " for the row"};
+    }
+    std::cout << "rows: " << rows << "\n";
+    {
+        std::vector<Record> records;
+        records.reserve(rows);
+        report("owned fields: ", measure([&]() {
+            for (const auto& fields : input) records.emplace_back(fields);
+        }), rows);
+    }
+    {
+        std::vector<Record> records;
+        records.reserve(rows);
+        RowArena arena;
+        report("row arena:    ", measure([&]() {
+            for (const auto& fields : input) records.push_back(arena.append(fields));
+        }), rows);
+        const RowArena::Stats& stats = arena.stats();
+        std::cout << "              " << stats.slabs << " slabs, " << stats.used << " of " << stats.reserved
+                  << " bytes used\n";
+    }
+
+    std::filesystem::path dir = std::filesystem::temp_directory_path() / "minidb_bench_arena";
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir / "data");
+    std::filesystem::current_path(dir);
+    {
+        std::vector<ColumnType> types = {ColumnType::Int, ColumnType::Text, ColumnType::Text, ColumnType::Text};
+        Table table("users", {"id", "name", "email", "note"}, types);
+        report("Table::insert: ", measure([&]() {
+            for (const auto& fields : input) table.insert(fields);
+        }), rows);
+    }
+    {
+        // Rows the caller hands over: fields are converted in place, not copied
+        std::vector<ColumnType> types = {ColumnType::Int, ColumnType::Text, ColumnType::Text, ColumnType::Text};
+        Table table("moved", {"id", "name", "email", "note"}, types);
+        report("  moved rows:  ", measure([&]() {
+            for (auto& fields : input) table.insert(std::move(fields));
+        }), rows);
+    }
+    std::filesystem::current_path(dir.parent_path());
+    std::filesystem::remove_all(dir);
+    return 0;
+}
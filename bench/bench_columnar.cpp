@@ -0,0 +1,76 @@
+// bench_columnar.cpp
+// Compares the row store (one Record per row) with ColumnStore on the access
+// patterns of Table: row-wise insert, a one-column equality filter and COUNT(col).
+// Usage: bench_columnar [rows]
+#include "ColumnStore.hpp"
+#include "Record.hpp"
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+
+template <typename Fn>
+static double bestOf(int runs, Fn fn) {
+    double best = 1e30;
+    for (int i = 0; i < runs; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        fn();
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        best = std::min(best, elapsed.count());
+    }
+    return best;
+}
+
+int main(int argc, char* argv[]) {
+    size_t rows = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1000000;
+    const size_t column_count = 8;
+    const size_t filter_col = 3;
+    const std::string needle = "city42";
+
+    std::vector<std::vector<std::string>> input;
+    input.reserve(rows);
+    for (size_t i = 0; i < rows; ++i) {
+        std::string n = std::to_string(i);
+        input.push_back({n, "user" + n, "user" + n + "@example.com", "city" + std::to_string(i % 97),
+                         std::to_string(i % 1000), i % 5 ? "active" : "", "note for row " + n, "x"});
+    }
+
+    std::vector<Record> row_store;
+    ColumnStore column_store(column_count);
+    double row_insert = bestOf(1, [&]() {
+        row_store.reserve(rows);
+        for (const auto& fields : input) row_store.emplace_back(fields);
+    });
+    double col_insert = bestOf(1, [&]() {
+        column_store.reserve(rows);
+        for (const auto& fields : input) column_store.append(fields);
+    });
+
+    size_t row_matches = 0, col_matches = 0;
+    double row_filter = bestOf(5, [&]() {
+        row_matches = 0;
+        for (const auto& record : row_store) row_matches += record.field(filter_col) == needle;
+    });
+    double col_filter = bestOf(5, [&]() {
+        col_matches = 0;
+        const ColumnStore::Column& column = column_store.column(filter_col);
+        for (size_t r = 0; r < column_store.size(); ++r) col_matches += column.value(r) == needle;
+    });
+
+    size_t row_count = 0, col_count = 0;
+    double row_agg = bestOf(5, [&]() {
+        row_count = 0;
+        for (const auto& record : row_store) row_count += !record.field(5).empty();
+    });
+    double col_agg = bestOf(5, [&]() {
+        col_count = 0;
+        const ColumnStore::Column& column = column_store.column(5);
+        for (size_t r = 0; r < column_store.size(); ++r) col_count += column.lengths[r] != 0;
+    });
+
+    std::cout << "rows: " << rows << ", columns: " << column_count << "\n";
+    std::cout << "                 row store    column store\n";
+    std::cout << "insert (ms)      " << row_insert << "\t" << col_insert << "\n";
+    std::cout << "filter (ms)      " << row_filter << "\t" << col_filter << "\t(" << col_matches << " matches)\n";
+    std::cout << "COUNT(col) (ms)  " << row_agg << "\t" << col_agg << "\t(" << col_count << " non-empty)\n";
+    return row_matches == col_matches && row_count == col_count ? 0 : 1;
+}
@@ -0,0 +1,50 @@
+// bench_commit.cpp
+// Commit throughput of the write-ahead log: committer threads each append
+// single-row INSERT frames, under each durability mode, and the group commit
+// statistics show how many commits shared a write and an fsync.
+// Usage: bench_commit [commits per thread] [commit window in us]
+#include "WriteAheadLog.hpp"
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+
+int main(int argc, char* argv[]) {
+    size_t commits = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 2000;
+    std::chrono::microseconds window(argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 0);
+    std::filesystem::path dir = std::filesystem::temp_directory_path() / "minidb_bench_commit";
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir);
+    std::string path = (dir / "bench.wal").string();
+
+    std::cout << "commits per thread: " << commits << ", commit window: " << window.count() << " us\n";
+    std::cout << "durability  threads   commits/s   writes   syncs   commits per write (avg, max)\n";
+    for (Durability durability : {Durability::Sync, Durability::Async, Durability::Off}) {
+        for (size_t threads : {1, 4, 16}) {
+            if (durability != Durability::Sync && threads != 16) continue;
+            std::filesystem::remove(path);
+            WriteAheadLog wal(path);
+            wal.setCommitWindow(window);
+            auto start = std::chrono::steady_clock::now();
+            std::vector<std::thread> committers;
+            for (size_t t = 0; t < threads; ++t) {
+                committers.emplace_back([&, t]() {
+                    for (size_t i = 0; i < commits; ++i) {
+                        wal.append({WalEntry(WalOp::Insert, "bench", {std::to_string(t), std::to_string(i), "payload"})},
+                                   durability);
+                    }
+                });
+            }
+            for (auto& committer : committers) committer.join();
+            wal.flush();
+            std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+            WalStats stats = wal.statistics();
+            std::cout << durabilityName(durability) << "\t    " << threads << "\t      "
+                      << static_cast<uint64_t>(stats.commits / elapsed.count()) << "\t  " << stats.batches << "\t   "
+                      << stats.syncs << "\t   " << static_cast<double>(stats.commits) / stats.batches << ", "
+                      << stats.largest_batch << "\n";
+        }
+    }
+    std::filesystem::remove_all(dir);
+    return 0;
+}
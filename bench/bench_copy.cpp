@@ -0,0 +1,77 @@
+// bench_copy.cpp
+// Writes a CSV file of the given number of rows (with quoted fields, some with
+// embedded commas and newlines) and times loading it into a row and a columnar
+// table: through COPY's chunked parser and appendRows() at increasing degrees of
+// parallelism, and row by row through Table::insert() as INSERT would. The
+// insert() rows are handed over already split, so that baseline excludes parsing
+// (and the per-statement parsing and logging INSERT adds on top).
+// Usage: bench_copy [rows]   (works in a scratch directory under /tmp)
+#include "BulkLoad.hpp"
+#include "Table.hpp"
+#include "ThreadPool.hpp"
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+static double secondsSince(std::chrono::steady_clock::time_point start) {
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count();
+}
+
+int main(int argc, char* argv[]) {
+    size_t rows = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 2000000;
+    std::filesystem::path dir = std::filesystem::temp_directory_path() / "minidb_bench_copy";
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir / "data");
+    std::filesystem::current_path(dir);
+
+    std::vector<std::string> columns = {"id", "region", "qty", "price"};
+    std::vector<ColumnType> types = {ColumnType::Int, ColumnType::Text, ColumnType::Int, ColumnType::Double};
+    std::vector<std::vector<std::string>> values; // the same rows, for the insert() baseline
+    {
+        std::ofstream out("input.csv", std::ios::binary);
+        out << "id,region,qty,price\n";
+        for (size_t i = 0; i < rows; ++i) {
+            std::string region = i % 50 == 0 ? "north, \"east\"\nzone " + std::to_string(i % 200)
+                                             : "region" + std::to_string(i % 200);
+            std::string quoted;
+            for (char c : region) quoted += c == '"' ? std::string("\"\"") : std::string(1, c);
+            values.push_back({std::to_string(i), region, std::to_string(i % 1000), std::to_string((i % 997) * 0.5)});
+            out << values.back()[0] << ",\"" << quoted << "\"," << values.back()[2] << "," << values.back()[3] << "\n";
+        }
+    }
+    std::cout << "rows: " << rows << ", file: " << std::filesystem::file_size("input.csv") / (1024 * 1024)
+              << " MiB, threads available: " << ThreadPool::shared().threadCount() << "\n";
+    std::cout << "layout    method          threads   seconds   rows/s\n";
+
+    for (StorageKind storage : {StorageKind::Row, StorageKind::Column}) {
+        const char* layout = storage == StorageKind::Row ? "row   " : "column";
+        {
+            Table table("t", columns, types, storage);
+            auto start = std::chrono::steady_clock::now();
+            for (const auto& row : values) table.insert(row);
+            double seconds = secondsSince(start);
+            std::cout << layout << "    insert()        1         " << seconds << "\t" << size_t(rows / seconds) << "\n";
+        }
+        ThreadPool& pool = ThreadPool::shared();
+        for (size_t dop = 1;; dop = std::min(dop * 2, pool.threadCount())) {
+            pool.setMaxParallelism(dop);
+            Table table("t", columns, types, storage);
+            auto start = std::chrono::steady_clock::now();
+            std::vector<RowBatch> batches;
+            BulkLoadStats stats;
+            if (!parseCsvFile("input.csv", columns, types, storage, true, batches, stats)) return 1;
+            table.appendRows(batches);
+            double seconds = secondsSince(start);
+            std::cout << layout << "    COPY            " << dop << "         " << seconds << "\t"
+                      << size_t(rows / seconds) << "\n";
+            if (dop == pool.threadCount()) break;
+        }
+        pool.setMaxParallelism(0);
+    }
+    std::filesystem::current_path(dir.parent_path());
+    std::filesystem::remove_all(dir);
+    return 0;
+}
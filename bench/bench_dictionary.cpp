@@ -0,0 +1,78 @@
+// bench_dictionary.cpp
+// A low-cardinality TEXT column (region, 50 values) kept two ways in a
+// ColumnStore: plain, every value in full with an offset and length per row,
+// and dictionary-encoded, a u32 code per row and each value once. Reports the
+// bytes each takes and the time Predicate::select needs for some filters.
+// Usage: bench_dictionary [rows]
+#include "ColumnStore.hpp"
+#include "FilterKernels.hpp"
+#include "Predicate.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+
+static const std::vector<std::string> COLUMNS = {"region"};
+static const std::vector<ColumnType> TYPES = {ColumnType::Text};
+
+static size_t columnBytes(const ColumnStore::Column& column) {
+    size_t bytes = column.bytes.size() + column.starts.size() * sizeof(uint64_t) +
+                   column.lengths.size() * sizeof(uint32_t);
+    for (const auto& value : column.dictionary.values) bytes += value.size();
+    return bytes;
+}
+
+// Best of three runs of select over the whole column; matched rows in matches
+static double selectMs(const Predicate& predicate, const ColumnStore& store, size_t& matches) {
+    std::vector<uint64_t> bits(bitmapWords(store.size()));
+    double best = 1e30;
+    for (int run = 0; run < 3; ++run) {
+        auto start = std::chrono::steady_clock::now();
+        predicate.select(store, 0, store.size(), bits.data());
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        best = std::min(best, elapsed.count());
+    }
+    matches = 0;
+    for (uint64_t word : bits) matches += __builtin_popcountll(word);
+    return best;
+}
+
+int main(int argc, char* argv[]) {
+    size_t rows = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 2000000;
+    ColumnStore plain(std::vector<uint32_t>{0});
+    ColumnStore encoded(TYPES);
+    plain.reserve(rows);
+    encoded.reserve(rows);
+    std::vector<std::string> fields(1);
+    for (size_t i = 0; i < rows; ++i) {
+        fields[0] = "region-" + std::to_string(i * 7919 % 50);
+        plain.append(fields);
+        encoded.append(fields);
+    }
+
+    std::cout << "rows: " << rows << "\n";
+    std::cout << "column bytes: " << columnBytes(plain.column(0)) << " plain, " << columnBytes(encoded.column(0))
+              << " encoded (" << encoded.column(0).dictionary.size() << " values)\n";
+    std::cout << "plain (ms)   encoded (ms)   matches   clause\n";
+    const char* clauses[] = {
+        "region = 'region-7'",
+        "region != 'region-7'",
+        "region IN ('region-1', 'region-2', 'region-30')",
+        "region LIKE 'region-1%'",
+        "region >= 'region-40'",
+    };
+    for (const char* clause : clauses) {
+        ExprPtr expr = parseWhere(clause);
+        Predicate predicate;
+        if (!expr || !predicate.compile(*expr, COLUMNS, TYPES)) return 1;
+        size_t plain_matches, encoded_matches;
+        double before = selectMs(predicate, plain, plain_matches);
+        double after = selectMs(predicate, encoded, encoded_matches);
+        if (plain_matches != encoded_matches) {
+            std::cerr << "Error: layouts disagree on '" << clause << "'.\n";
+            return 1;
+        }
+        std::cout << before << "\t     " << after << "\t    " << encoded_matches << "\t      " << clause << "\n";
+    }
+    return 0;
+}
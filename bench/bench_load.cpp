@@ -0,0 +1,91 @@
+// bench_load.cpp
+// Compares load time of the legacy CSV table file against the binary format,
+// both fully decoded and through the lazily indexed mapping Table uses.
+// Usage: bench_load [rows]
+#include "TableFile.hpp"
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+
+namespace fs = std::filesystem;
+
+template <typename Fn>
+static double bestOf(int runs, Fn fn) {
+    double best = 1e30;
+    for (int i = 0; i < runs; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        fn();
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        best = std::min(best, elapsed.count());
+    }
+    return best;
+}
+
+int main(int argc, char* argv[]) {
+    size_t rows = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 500000;
+
+    std::vector<std::string> columns = {"id", "name", "email", "city", "score"};
+    std::vector<Record> records;
+    records.reserve(rows);
+    for (size_t i = 0; i < rows; ++i) {
+        std::string n = std::to_string(i);
+        records.emplace_back(std::vector<std::string>{n, "user" + n, "user" + n + "@example.com",
+                                                      "city" + std::to_string(i % 97), std::to_string(i * 7 % 1000)});
+    }
+
+    fs::path dir = fs::temp_directory_path() / "minidb_bench_load";
+    fs::create_directories(dir);
+    std::string csv_path = (dir / "bench_csv.tbl").string();
+    std::string bin_path = (dir / "bench_bin.tbl").string();
+    TableData source;
+    source.columns = columns;
+    source.records = std::move(records);
+    writeCsvTable(csv_path, source);
+    writeTableFile(bin_path, source);
+
+    size_t loaded_csv = 0, loaded_bin = 0;
+    double csv_ms = bestOf(3, [&]() {
+        TableData data;
+        readCsvTable(csv_path, data);
+        loaded_csv = data.records.size();
+    });
+    double bin_ms = bestOf(3, [&]() {
+        TableData data;
+        readTableFile(bin_path, data);
+        loaded_bin = data.records.size();
+    });
+
+    // Lazy path used by Table: map and decode the header, then index rows on first scan
+    double open_ms = bestOf(3, [&]() {
+        TableData data;
+        openTableFile(bin_path, data);
+    });
+    // The row index walks every data page, whatever the first statement reads
+    double index_ms = bestOf(3, [&]() {
+        TableData data;
+        openTableFile(bin_path, data);
+        indexTableRows(bin_path, data);
+    });
+    size_t scanned = 0;
+    double scan_ms = bestOf(3, [&]() {
+        TableData data;
+        openTableFile(bin_path, data);
+        indexTableRows(bin_path, data);
+        scanned = 0;
+        for (const auto& record : data.records) {
+            scanned += record.field(0).size() > 0;
+        }
+    });
+
+    std::cout << "rows:         " << rows << "\n";
+    std::cout << "csv:          " << csv_ms << " ms (" << fs::file_size(csv_path) << " bytes, " << loaded_csv << " rows)\n";
+    std::cout << "binary:       " << bin_ms << " ms (" << fs::file_size(bin_path) << " bytes, " << loaded_bin << " rows)\n";
+    std::cout << "mapped open:  " << open_ms << " ms\n";
+    std::cout << "row index:    " << index_ms << " ms (open + indexing every row)\n";
+    std::cout << "mapped scan:  " << scan_ms << " ms (open + first scan of one column)\n";
+    std::cout << "speedup:      " << csv_ms / bin_ms << "x binary, " << csv_ms / scan_ms << "x mapped\n";
+
+    fs::remove_all(dir);
+    return loaded_csv == rows && loaded_bin == rows && scanned == rows ? 0 : 1;
+}
@@ -0,0 +1,105 @@
+// bench_predicate.cpp
+// Per-row cost of evaluating a WHERE clause two ways over the same rows:
+//   interpreted: walk the parsed expression for every row, looking columns up
+//                by name and converting literals each time
+//   compiled:    Predicate, with columns resolved and literals converted once
+// Usage: bench_predicate [rows]
+#include "Expression.hpp"
+#include "Predicate.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+
+using Row = std::vector<std::string>; // stored values
+
+static const std::vector<std::string> COLUMNS = {"id", "name", "qty", "price"};
+static const std::vector<ColumnType> TYPES = {ColumnType::Int, ColumnType::Text, ColumnType::Int, ColumnType::Double};
+
+// What a per-row interpreter does: everything is resolved again on each call
+static bool interpret(const Expr& expr, const Row& row) {
+    switch (expr.kind) {
+        case ExprKind::And:
+            for (const auto& child : expr.children) {
+                if (!interpret(*child, row)) return false;
+            }
+            return true;
+        case ExprKind::Or:
+            for (const auto& child : expr.children) {
+                if (interpret(*child, row)) return true;
+            }
+            return false;
+        case ExprKind::Not:
+            return !interpret(*expr.children[0], row);
+        default:
+            break;
+    }
+    size_t col = std::find(COLUMNS.begin(), COLUMNS.end(), expr.column) - COLUMNS.begin();
+    ColumnType type = TYPES[col];
+    std::string literal;
+    if (expr.kind == ExprKind::In) {
+        for (const auto& value : expr.values) {
+            encodeValue(type, value, literal);
+            if (compareValues(type, row[col], literal) == 0) return !expr.negated;
+        }
+        return expr.negated;
+    }
+    if (expr.kind == ExprKind::Like) {
+        return LikePattern(expr.values[0]).matches(formatValue(type, row[col])) != expr.negated;
+    }
+    Condition cond;
+    cond.op = expr.op;
+    cond.type = type;
+    encodeValue(type, expr.values[0], cond.value);
+    if (expr.op == CompareOp::Between) encodeValue(type, expr.values[1], cond.value2);
+    return cond.matches(row[col]);
+}
+
+template <typename Fn>
+static double nsPerRow(size_t rows, size_t& matched, Fn fn) {
+    double best = 1e30;
+    for (int run = 0; run < 3; ++run) {
+        matched = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (size_t r = 0; r < rows; ++r) matched += fn(r);
+        std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+        best = std::min(best, elapsed.count() / rows);
+    }
+    return best;
+}
+
+int main(int argc, char* argv[]) {
+    size_t rows = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1000000;
+    std::vector<Row> table(rows, Row(COLUMNS.size()));
+    for (size_t i = 0; i < rows; ++i) {
+        encodeValue(ColumnType::Int, std::to_string(i), table[i][0]);
+        table[i][1] = "user" + std::to_string(i % 5000);
+        encodeValue(ColumnType::Int, std::to_string(i % 1000), table[i][2]);
+        encodeValue(ColumnType::Double, std::to_string((i % 997) * 0.5), table[i][3]);
+    }
+
+    const char* clauses[] = {
+        "qty = 7",
+        "price BETWEEN 10 AND 20",
+        "(qty < 100 AND name LIKE 'user1%') OR id IN (5, 50, 500) OR NOT price <= 490",
+    };
+    std::cout << "rows: " << rows << "\n";
+    std::cout << "interpreted (ns/row)   compiled (ns/row)   matches   clause\n";
+    for (const char* clause : clauses) {
+        ExprPtr expr = parseWhere(clause);
+        Predicate predicate;
+        if (!expr || !predicate.compile(*expr, COLUMNS, TYPES)) return 1;
+        size_t interpreted_matches, compiled_matches;
+        double before = nsPerRow(rows, interpreted_matches, [&](size_t r) { return interpret(*expr, table[r]); });
+        double after = nsPerRow(rows, compiled_matches, [&](size_t r) {
+            const Row& row = table[r];
+            return predicate.matches([&](int col) { return std::string_view(row[col]); });
+        });
+        if (interpreted_matches != compiled_matches) {
+            std::cerr << "Error: evaluations disagree on '" << clause << "'.\n";
+            return 1;
+        }
+        std::cout << before << "\t\t\t" << after << "\t\t    " << compiled_matches << "\t      " << clause << "\n";
+    }
+    return 0;
+}
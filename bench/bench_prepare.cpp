@@ -0,0 +1,80 @@
+// bench_prepare.cpp
+// Times short statements on a table with a hash index on id, run ad hoc (each
+// one lexed, parsed and planned before it runs) and through a prepared plan
+// (each run only binds its parameter), to show what the plan cache saves per
+// statement. Result rows are formatted as usual and discarded.
+// Usage: bench_prepare [statements]   (works in a scratch directory under /tmp)
+#include "Planner.hpp"
+#include "Statement.hpp"
+#include "Table.hpp"
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <sstream>
+
+static double secondsSince(std::chrono::steady_clock::time_point start) {
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count();
+}
+
+int main(int argc, char* argv[]) {
+    size_t statements = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 200000;
+    const size_t rows = 10000;
+    std::filesystem::path dir = std::filesystem::temp_directory_path() / "minidb_bench_prepare";
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir / "data");
+    std::filesystem::current_path(dir);
+    Table table("t", {"id", "name", "qty", "price"},
+                {ColumnType::Int, ColumnType::Text, ColumnType::Int, ColumnType::Double});
+    for (size_t i = 0; i < rows; ++i) {
+        table.insert({std::to_string(i), "name" + std::to_string(i % 100), std::to_string(i % 1000),
+                      std::to_string((i % 97) * 0.5)});
+    }
+    if (!table.createIndex("t_id", "id")) return 1;
+
+    const char* shapes[] = {
+        "SELECT name, price FROM t WHERE id = ?",
+        "SELECT id FROM t WHERE id = ? AND qty < 500 AND name LIKE 'name1%'",
+    };
+    std::ostringstream sink;
+    std::streambuf* out = std::cout.rdbuf(sink.rdbuf());
+    std::cerr << "statements: " << statements << " per shape, table rows: " << rows << "\n";
+    for (const char* shape : shapes) {
+        std::string text = shape;
+        size_t param = text.find('?');
+
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < statements; ++i) {
+            std::string id = std::to_string(i % rows);
+            std::string adhoc = text.substr(0, param) + id + text.substr(param + 1);
+            Statement statement;
+            Plan plan;
+            if (!parseStatement(adhoc, statement) || !planStatement(statement, table, plan)) return 1;
+            printCursor(*table.select(plan.select), sink);
+            sink.str("");
+        }
+        double adhoc_seconds = secondsSince(start);
+
+        Statement statement;
+        Plan plan;
+        if (!parseStatement("PREPARE q AS " + text, statement) || !planStatement(*statement.body, table, plan)) {
+            return 1;
+        }
+        start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < statements; ++i) {
+            if (!bindParameters(plan, table, {std::to_string(i % rows)})) return 1;
+            printCursor(*table.select(plan.select), sink);
+            sink.str("");
+        }
+        double prepared_seconds = secondsSince(start);
+
+        std::cerr << shape << "\n  ad hoc:   " << adhoc_seconds * 1e9 / statements << " ns/statement\n"
+                  << "  prepared: " << prepared_seconds * 1e9 / statements << " ns/statement ("
+                  << adhoc_seconds / prepared_seconds << "x)\n";
+    }
+    std::cout.rdbuf(out);
+    std::filesystem::current_path(dir.parent_path());
+    std::filesystem::remove_all(dir);
+    return 0;
+}
@@ -0,0 +1,70 @@
+// bench_scan.cpp
+// Times full-table scans through Table at increasing degrees of parallelism:
+// a GROUP BY with SUM/AVG/COUNT, a filtered SELECT whose rows are formatted and
+// discarded, an UPDATE matching nothing (filter only), and a "top 50" query
+// (ORDER BY ... LIMIT 50) next to a plain LIMIT 50 that stops the scan early.
+// Usage: bench_scan [rows]   (works in a scratch directory under /tmp)
+#include "Table.hpp"
+#include "ThreadPool.hpp"
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <sstream>
+
+template <typename Fn>
+static double bestOf(int runs, Fn fn) {
+    double best = 1e30;
+    for (int i = 0; i < runs; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        fn();
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        best = std::min(best, elapsed.count());
+    }
+    return best;
+}
+
+int main(int argc, char* argv[]) {
+    size_t rows = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 2000000;
+    std::filesystem::path dir = std::filesystem::temp_directory_path() / "minidb_bench_scan";
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir / "data");
+    std::filesystem::current_path(dir);
+
+    std::vector<ColumnType> types = {ColumnType::Int, ColumnType::Text, ColumnType::Int, ColumnType::Double};
+    Table table("sales", {"id", "region", "qty", "price"}, types, StorageKind::Column);
+    for (size_t i = 0; i < rows; ++i) {
+        table.insert({std::to_string(i), "region" + std::to_string(i % 200), std::to_string(i % 1000),
+                      std::to_string((i % 997) * 0.5)});
+    }
+
+    std::vector<Aggregate> aggregates(3);
+    parseAggregate("COUNT", "*", aggregates[0]);
+    parseAggregate("SUM", "qty", aggregates[1]);
+    parseAggregate("AVG", "price", aggregates[2]);
+    ExprPtr filter = makeComparison("qty", CompareOp::Lt, "10");
+    ExprPtr none = makeComparison("qty", CompareOp::Eq, "-1");
+
+    std::ostringstream sink;
+    std::streambuf* console = std::cout.rdbuf();
+    ThreadPool& pool = ThreadPool::shared();
+    std::cout << "rows: " << rows << ", threads available: " << pool.threadCount() << "\n";
+    std::cout << "threads   group by (ms)   select (ms)   update (ms)   top 50 (ms)   limit 50 (ms)\n";
+    for (size_t dop = 1;; dop = std::min(dop * 2, pool.threadCount())) {
+        pool.setMaxParallelism(dop);
+        std::cout.rdbuf(sink.rdbuf());
+        double group = bestOf(3, [&]() { printCursor(*table.select({}, aggregates, {}, {}, {"region"}), sink); });
+        double select = bestOf(3, [&]() { printCursor(*table.select({}, {}, filter.get()), sink); });
+        double update = bestOf(3, [&]() { table.update("region", "none", none.get()); });
+        double top = bestOf(3, [&]() { printCursor(*table.select({}, {}, nullptr, {{"price", "DESC"}}, {}, 50), sink); });
+        double limit = bestOf(3, [&]() { printCursor(*table.select({}, {}, filter.get(), {}, {}, 50), sink); });
+        sink.str("");
+        std::cout.rdbuf(console);
+        std::cout << dop << "\t  " << group << "\t  " << select << "\t  " << update << "\t  " << top << "\t  "
+                  << limit << "\n";
+        if (dop == pool.threadCount()) break;
+    }
+    std::filesystem::current_path(dir.parent_path());
+    std::filesystem::remove_all(dir);
+    return 0;
+}
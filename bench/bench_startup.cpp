@@ -0,0 +1,83 @@
+// bench_startup.cpp
+// Startup cost with many tables: loading every table one after another (what
+// startup did before the catalog) against reading the catalog, and the time
+// until a first query on one table can run when tables load lazily.
+// Usage: bench_startup [tables] [rows per table]   (works in a scratch directory under /tmp)
+#include "Catalog.hpp"
+#include "Table.hpp"
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <sstream>
+
+static double millisSince(std::chrono::steady_clock::time_point start) {
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count();
+}
+
+int main(int argc, char* argv[]) {
+    size_t table_count = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 200;
+    size_t rows = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 20000;
+    std::filesystem::path dir = std::filesystem::temp_directory_path() / "minidb_bench_startup";
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir / "data");
+    std::filesystem::current_path(dir);
+
+    // Half the tables columnar, which is the layout that is expensive to load
+    std::vector<CatalogEntry> entries;
+    for (size_t t = 0; t < table_count; ++t) {
+        std::string name = "t" + std::to_string(t);
+        Table table(name, {"id", "name", "qty"}, {ColumnType::Int, ColumnType::Text, ColumnType::Int},
+                    t % 2 ? StorageKind::Column : StorageKind::Row);
+        for (size_t i = 0; i < rows; ++i) {
+            table.insert({std::to_string(i), "name" + std::to_string(i % 100), std::to_string(i % 7)});
+        }
+        table.save();
+        CatalogEntry entry;
+        entry.name = name;
+        entry.meta = table.metadata();
+        tableFileStamp("data/" + name + ".tbl", entry.file_size, entry.file_mtime);
+        entries.push_back(std::move(entry));
+    }
+    writeCatalog(DATA_DIR + CATALOG_FILE, entries);
+
+    auto start = std::chrono::steady_clock::now();
+    {
+        std::vector<std::unique_ptr<Table>> loaded;
+        for (size_t t = 0; t < table_count; ++t) loaded.push_back(std::make_unique<Table>("t" + std::to_string(t)));
+    }
+    double eager = millisSince(start);
+
+    start = std::chrono::steady_clock::now();
+    std::vector<CatalogEntry> read;
+    readCatalog(DATA_DIR + CATALOG_FILE, read);
+    size_t current = 0;
+    for (const auto& entry : read) {
+        uint64_t size;
+        int64_t mtime;
+        tableFileStamp("data/" + entry.name + ".tbl", size, mtime);
+        current += size == entry.file_size && mtime == entry.file_mtime;
+    }
+    double catalog = millisSince(start);
+
+    // A first query only waits for the table it reads
+    std::ostringstream sink;
+    std::streambuf* console = std::cout.rdbuf();
+    std::cout.rdbuf(sink.rdbuf());
+    Table first("t1");
+    ExprPtr where = makeComparison("qty", CompareOp::Eq, "3");
+    printCursor(*first.select({}, {}, where.get(), {}, {}, 10), sink);
+    std::cout.rdbuf(console);
+    double first_query = millisSince(start);
+
+    std::cout << "tables: " << table_count << ", rows per table: " << rows << "\n";
+    std::cout << "load every table:        " << eager << " ms\n";
+    std::cout << "read catalog:            " << catalog << " ms (" << current << " of " << read.size()
+              << " entries current)\n";
+    std::cout << "catalog + first query:   " << first_query << " ms\n";
+
+    std::filesystem::current_path(dir.parent_path());
+    std::filesystem::remove_all(dir);
+    return current == table_count ? 0 : 1;
+}
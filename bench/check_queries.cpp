@@ -0,0 +1,138 @@
+// check_queries.cpp
+// Statements whose results have gone wrong before, run from one thread and
+// checked against the values they must give: SUM and AVG of BIGINTs near the
+// limits, COPY of malformed CSV files, and recovery of a transaction that
+// committed after another session's write. Exits non-zero after reporting
+// every mismatch.
+// Usage: check_queries   (works in a scratch directory under /tmp)
+#include "Database.hpp"
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+static size_t failures = 0;
+
+static void fail(const std::string& sql, const std::string& what) {
+    failures++;
+    std::cerr << sql << "\n  " << what;
+}
+
+// Run sql, which must succeed
+static QueryResult run(Database& db, Session& session, const std::string& sql) {
+    QueryResult result = db.execute(sql, session);
+    if (!result.ok) fail(sql, result.error);
+    return result;
+}
+
+// The value of the only aggregate of a SELECT, read from its cursor
+static void expectTotal(Database& db, Session& session, const std::string& sql, const std::string& value) {
+    QueryResult result = run(db, session, sql);
+    if (!result.cursor) return;
+    result.cursor->next();
+    const auto& totals = result.cursor->totals();
+    std::string got = totals.size() == 1 ? totals[0].second : "(no total)";
+    if (got != value) fail(sql, "got " + got + ", expected " + value + "\n");
+}
+
+// Integer sums past the range of BIGINT are not wrapped
+static void checkSums(Database& db, Session& session) {
+    run(db, session, "CREATE TABLE extremes (v BIGINT)");
+    run(db, session, "INSERT INTO extremes VALUES (9223372036854775807), (9223372036854775807)");
+    expectTotal(db, session, "SELECT SUM(v) FROM extremes LIMIT 1", "18446744073709551614");
+    expectTotal(db, session, "SELECT AVG(v) FROM extremes LIMIT 1", "9223372036854775808");
+    run(db, session,
+        "INSERT INTO extremes VALUES (-9223372036854775807), (-9223372036854775807), (-9223372036854775807)");
+    expectTotal(db, session, "SELECT SUM(v) FROM extremes LIMIT 1", "-9223372036854775807");
+}
+
+// Run sql, which must fail with an error containing message
+static void expectError(Database& db, Session& session, const std::string& sql, const std::string& message) {
+    QueryResult result = db.execute(sql, session);
+    if (result.ok) {
+        fail(sql, "succeeded, expected an error\n");
+    } else if (result.error.find(message) == std::string::npos) {
+        fail(sql, "error " + result.error + "  expected one containing '" + message + "'\n");
+    }
+}
+
+// A malformed CSV file is rejected with the line of its bad record, and nothing is loaded
+static void checkCopy(Database& db, Session& session, const std::filesystem::path& dir) {
+    run(db, session, "CREATE TABLE loaded (id INT, v TEXT)");
+    struct Case {
+        const char* csv;
+        const char* error;
+    };
+    const Case cases[] = {
+        {"1,\"abc\n2,def\n", "line 1: Unterminated quoted field."},
+        {"1,x\n2,\"a\"x\n", "line 2: Text after the closing quote of a field."},
+        {"1,\"a\" \n", "line 1: Text after the closing quote of a field."},
+        {"1,ab\"c\n", "line 1: A quote inside a field that is not quoted as a whole."},
+    };
+    for (const Case& c : cases) {
+        std::string file = (dir / "malformed.csv").string();
+        std::ofstream(file, std::ios::binary) << c.csv;
+        expectError(db, session, "COPY loaded FROM '" + file + "'", c.error);
+    }
+    expectTotal(db, session, "SELECT COUNT(*) FROM loaded LIMIT 1", "0");
+    // Well-formed quoting still loads
+    std::string file = (dir / "quoted.csv").string();
+    std::ofstream(file, std::ios::binary) << "1,\"a,\"\"b\"\"\"\r\n2,\"\"\n3,\"c\nd\"";
+    run(db, session, "COPY loaded FROM '" + file + "'");
+    expectTotal(db, session, "SELECT COUNT(*) FROM loaded WHERE v = 'a,\"b\"' LIMIT 1", "1");
+    expectTotal(db, session, "SELECT COUNT(*) FROM loaded LIMIT 1", "3");
+}
+
+// A transaction's UPDATE and DELETE replay to the rows they changed live,
+// though another session logged rows its snapshot did not see before it
+static void checkRecovery(const std::filesystem::path& dir) {
+    std::filesystem::path live = dir / "live";
+    std::filesystem::path crashed = dir / "crashed";
+    {
+        Database db(live.string());
+        db.open();
+        Session a, b;
+        run(db, a, "CREATE TABLE updated (id INT, v TEXT)");
+        run(db, a, "CREATE TABLE deleted (id INT, v TEXT)");
+        run(db, a, "INSERT INTO updated VALUES (1, 'x')");
+        run(db, a, "INSERT INTO deleted VALUES (1, 'x'), (1, 'x')");
+        run(db, a, "CHECKPOINT");
+        run(db, a, "BEGIN TRANSACTION");
+        run(db, a, "SELECT * FROM updated");
+        run(db, b, "INSERT INTO updated VALUES (2, 'x')");
+        run(db, b, "INSERT INTO deleted VALUES (2, 'x'), (1, 'x')");
+        run(db, a, "UPDATE updated SET v = 'y' WHERE v = 'x'");
+        run(db, a, "DELETE FROM deleted WHERE v = 'x'");
+        run(db, a, "COMMIT");
+        expectTotal(db, a, "SELECT COUNT(*) FROM updated WHERE v = 'x' LIMIT 1", "1");
+        expectTotal(db, a, "SELECT COUNT(*) FROM deleted LIMIT 1", "2");
+        // A crash here leaves the tables as of the checkpoint and the log after it
+        std::filesystem::copy(live, crashed, std::filesystem::copy_options::recursive);
+    }
+    Database db(crashed.string());
+    db.open();
+    Session session;
+    expectTotal(db, session, "SELECT COUNT(*) FROM updated WHERE v = 'x' LIMIT 1", "1");
+    expectTotal(db, session, "SELECT COUNT(*) FROM updated WHERE v = 'y' AND id = 1 LIMIT 1", "1");
+    expectTotal(db, session, "SELECT COUNT(*) FROM deleted LIMIT 1", "2");
+}
+
+int main() {
+    std::filesystem::path dir = std::filesystem::temp_directory_path() / "minidb_check_queries";
+    std::filesystem::remove_all(dir);
+    {
+        Database db((dir / "data").string());
+        db.open();
+        Session session;
+        checkSums(db, session);
+        checkCopy(db, session, dir);
+    }
+    checkRecovery(dir);
+    std::filesystem::remove_all(dir);
+    if (failures > 0) {
+        std::cerr << "FAILED: " << failures << " problem(s)\n";
+        return 1;
+    }
+    std::cout << "All checks passed.\n";
+    return 0;
+}
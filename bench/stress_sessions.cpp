@@ -0,0 +1,232 @@
+// stress_sessions.cpp
+// Runs many sessions of one Database on their own threads against shared
+// tables: inserts, updates, deletes, point lookups, counts, transactions that
+// commit or roll back, checkpoints and a CREATE INDEX mid-run. Every result is
+// checked as it comes back: each thread owns its rows of events and knows how
+// many it should see, and every committed transaction adds a pair of ledger
+// rows summing to zero, so a reader catching half of one sees a non-zero sum.
+// The tables are checked again after the database is closed and reopened.
+// Then it times indexed point lookups from one session and from all of them.
+// Built with -fsanitize=thread by `make stress-tsan` to catch data races.
+// Usage: stress_sessions [threads] [iterations]   (works in a scratch directory under /tmp)
+#include "Database.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+static const size_t ACCOUNTS = 1000;
+
+static std::atomic<size_t> failures{0};
+static std::mutex report_mutex;
+
+static void fail(size_t thread, const std::string& sql, const std::string& what) {
+    std::lock_guard<std::mutex> lock(report_mutex);
+    if (failures++ < 20) std::cerr << "thread " << thread << ": " << sql << "\n  " << what;
+}
+
+// What one thread may legitimately be told besides success
+static bool expectedError(const std::string& error) {
+    return error.find("uncommitted changes of another session") != std::string::npos ||
+           error.find("Cannot checkpoint while another session") != std::string::npos;
+}
+
+// The value of the only aggregate of a SELECT, read from its cursor
+static std::string total(QueryResult& result) {
+    if (!result.cursor) return "(no cursor)";
+    result.cursor->next();
+    const auto& totals = result.cursor->totals();
+    return totals.size() == 1 ? totals[0].second : "(no total)";
+}
+
+struct Client {
+    Database& db;
+    size_t id;
+    Session session;
+
+    // Run sql; false (and reported unless it is an expected error) when it fails
+    bool run(const std::string& sql, QueryResult& result) {
+        result = db.execute(sql, session);
+        if (!result.ok && !expectedError(result.error)) fail(id, sql, result.error);
+        return result.ok;
+    }
+    bool run(const std::string& sql) {
+        QueryResult result;
+        return run(sql, result);
+    }
+    void expect(const std::string& sql, const std::string& value) {
+        QueryResult result;
+        if (!run(sql, result)) return;
+        std::string got = total(result);
+        if (got != value) fail(id, sql, "got " + got + ", expected " + value + "\n");
+    }
+    void expectMessage(const std::string& sql, const std::string& message) {
+        QueryResult result;
+        if (run(sql, result) && result.message != message) {
+            fail(id, sql, "said " + result.message + "  expected " + message);
+        }
+    }
+};
+
+// One thread's share of the work on its own session, leaving the s of its
+// rows of events in mine; returns the ledger pairs it committed
+static size_t work(Database& db, size_t id, size_t threads, size_t iterations, std::set<size_t>& mine) {
+    Client client{db, id, {}};
+    std::mt19937_64 rng(id * 7919 + 1);
+    std::string t = std::to_string(id);
+    size_t next_seq = 0;
+    size_t pairs = 0;
+    for (size_t i = 0; i < iterations; ++i) {
+        if (id == 0 && i % 250 == 249) {
+            client.run("CHECKPOINT");
+            continue;
+        }
+        if (id == threads - 1 && i == iterations / 2) {
+            client.run("CREATE INDEX events_s ON events(s) USING BTREE");
+            continue;
+        }
+        size_t seq = mine.empty() ? 0 : *std::next(mine.begin(), rng() % mine.size());
+        std::string where = " WHERE t = " + t + " AND s = " + std::to_string(seq);
+        switch (rng() % 10) {
+            case 0:
+            case 1:
+            case 2: {
+                size_t s = next_seq++;
+                if (client.run("INSERT INTO events VALUES (" + t + ", " + std::to_string(s) + ", 'new')")) {
+                    mine.insert(s);
+                }
+                break;
+            }
+            case 3:
+                if (mine.empty()) break;
+                client.expectMessage("UPDATE events SET kind = 'seen'" + where, "Updated 1 record(s) in events.\n");
+                break;
+            case 4:
+                if (mine.empty()) break;
+                client.expectMessage("DELETE FROM events" + where, "Deleted 1 record(s) from events.\n");
+                mine.erase(seq);
+                break;
+            case 5:
+            case 6:
+                client.expect("SELECT COUNT(*) FROM events WHERE t = " + t + " LIMIT 1", std::to_string(mine.size()));
+                break;
+            case 7:
+                client.expect("SELECT COUNT(*) FROM accounts WHERE id = " + std::to_string(rng() % ACCOUNTS), "1");
+                break;
+            case 8: {
+                // A transfer: both rows or neither become visible
+                std::string row = " VALUES (" + t + ", " + std::to_string(i);
+                if (!client.run("BEGIN TRANSACTION")) break;
+                bool ok = client.run("INSERT INTO ledger" + row + ", 5)") &&
+                          client.run("INSERT INTO ledger" + row + ", -5)");
+                if (ok && rng() % 4 != 0) {
+                    if (client.run("COMMIT")) ++pairs;
+                } else {
+                    client.run("ROLLBACK");
+                }
+                break;
+            }
+            default:
+                client.expect("SELECT SUM(amount) FROM ledger LIMIT 1", "0");
+                break;
+        }
+    }
+    return pairs;
+}
+
+// Every thread's rows of events and the ledger as the threads left them
+static void verify(Database& db, const std::vector<std::set<size_t>>& owned, size_t pairs) {
+    Client client{db, owned.size(), {}};
+    for (size_t t = 0; t < owned.size(); ++t) {
+        client.expect("SELECT COUNT(*) FROM events WHERE t = " + std::to_string(t) + " LIMIT 1",
+                      std::to_string(owned[t].size()));
+    }
+    client.expect("SELECT SUM(amount) FROM ledger LIMIT 1", "0");
+    client.expect("SELECT COUNT(*) FROM ledger LIMIT 1", std::to_string(2 * pairs));
+}
+
+// Point lookups per second from the given number of sessions at once
+static double lookups(Database& db, size_t sessions, size_t per_session) {
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> readers;
+    for (size_t id = 0; id < sessions; ++id) {
+        readers.emplace_back([&db, id, per_session]() {
+            Client client{db, id, {}};
+            std::mt19937_64 rng(id + 1);
+            for (size_t i = 0; i < per_session; ++i) {
+                client.expect("SELECT COUNT(*) FROM accounts WHERE id = " + std::to_string(rng() % ACCOUNTS), "1");
+            }
+        });
+    }
+    for (auto& reader : readers) reader.join();
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return sessions * per_session / std::max(elapsed.count(), 1e-9);
+}
+
+int main(int argc, char* argv[]) {
+    size_t threads = argc > 1 ? std::max<size_t>(1, std::strtoull(argv[1], nullptr, 10)) : 8;
+    size_t iterations = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 2000;
+    std::filesystem::path dir = std::filesystem::temp_directory_path() / "minidb_stress_sessions";
+    std::filesystem::remove_all(dir);
+    std::string data = (dir / "data").string();
+
+    std::vector<std::set<size_t>> owned(threads);
+    size_t pairs = 1;
+    {
+        Database db(data);
+        db.open();
+        Client setup{db, threads, {}};
+        setup.run("CREATE TABLE accounts (id INT, balance INT)");
+        setup.run("CREATE INDEX accounts_id ON accounts(id)");
+        for (size_t first = 0; first < ACCOUNTS; first += 250) {
+            std::string sql = "INSERT INTO accounts VALUES ";
+            for (size_t id = first; id < first + 250 && id < ACCOUNTS; ++id) {
+                sql += (id > first ? ", (" : "(") + std::to_string(id) + ", 100)";
+            }
+            setup.run(sql);
+        }
+        setup.run("CREATE TABLE events (t INT, s INT, kind TEXT) USING COLUMNAR");
+        setup.run("CREATE TABLE ledger (t INT, n INT, amount INT)");
+        setup.run("INSERT INTO ledger VALUES (-1, 0, 1), (-1, 0, -1)");
+
+        auto start = std::chrono::steady_clock::now();
+        std::vector<size_t> committed(threads);
+        std::vector<std::thread> workers;
+        for (size_t id = 0; id < threads; ++id) {
+            workers.emplace_back([&, id]() { committed[id] = work(db, id, threads, iterations, owned[id]); });
+        }
+        for (auto& worker : workers) worker.join();
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        for (size_t count : committed) pairs += count;
+        verify(db, owned, pairs);
+        std::cout << threads << " sessions ran " << threads * iterations << " statements in " << elapsed.count()
+                  << " s (" << threads * iterations / std::max(elapsed.count(), 1e-9) << " statements/s), "
+                  << pairs - 1 << " transfers committed\n";
+
+        size_t per_session = std::max<size_t>(100, iterations);
+        double one = lookups(db, 1, per_session);
+        double all = lookups(db, threads, per_session);
+        std::cout << "Point lookups: " << static_cast<uint64_t>(one) << "/s from 1 session, "
+                  << static_cast<uint64_t>(all) << "/s from " << threads << " (" << all / one << "x)\n";
+    }
+    {
+        // Everything committed survives closing and reopening
+        Database db(data);
+        db.open();
+        verify(db, owned, pairs);
+    }
+    std::filesystem::remove_all(dir);
+    if (failures > 0) {
+        std::cerr << "FAILED: " << failures << " problem(s)\n";
+        return 1;
+    }
+    std::cout << "All checks passed.\n";
+    return 0;
+}
@@ -1,16 +1,71 @@
 // main.cpp
 #include "Database.hpp"
-#include <filesystem>
+#include "Server.hpp"
+#include <algorithm>
+#include <csignal>
+#include <cstdlib>
 #include <iostream>
+#include <thread>
 
-int main() {
-    // Create data directory if it doesn't exist
-    std::string data_dir = "data";
-    if (!std::filesystem::exists(data_dir)) {
-        std::filesystem::create_directory(data_dir);
+static Server* running_server = nullptr;
+
+static void stopServer(int) {
+    if (running_server) running_server->stop();
+}
+
+// minidb [--data DIR] [--serve ADDRESS] [--workers N]
+// Without --serve: the REPL, a client of the Database API that prints what
+// each statement reports and the rows of its cursor. With it: a server on
+// ADDRESS (unix:PATH or a loopback [HOST:]PORT) until SIGINT or SIGTERM.
+int main(int argc, char* argv[]) {
+    std::string data_dir = DATA_DIR;
+    std::string address;
+    size_t workers = std::max(2u, std::thread::hardware_concurrency());
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (i + 1 < argc && arg == "--data") {
+            data_dir = argv[++i];
+        } else if (i + 1 < argc && arg == "--serve") {
+            address = argv[++i];
+        } else if (i + 1 < argc && arg == "--workers") {
+            workers = std::strtoul(argv[++i], nullptr, 10);
+        } else {
+            std::cerr << "Usage: minidb [--data DIR] [--serve ADDRESS] [--workers N]\n";
+            return 1;
+        }
     }
 
-    Database db;
-    db.run();
+    Database db(data_dir);
+    db.open();
+
+    if (!address.empty()) {
+        Server server(db, workers);
+        if (!server.listen(address)) return 1;
+        running_server = &server;
+        std::signal(SIGINT, stopServer);
+        std::signal(SIGTERM, stopServer);
+        std::signal(SIGPIPE, SIG_IGN);
+        std::cout << "MiniDB listening on " << address << " with " << workers << " workers.\n" << std::flush;
+        server.run();
+        running_server = nullptr;
+        // Server destructor: workers finish and end the closed sessions
+    } else {
+        std::string input;
+        std::cout << "Welcome to MiniDB! Enter SQL commands or 'exit' to quit.\n";
+        while (true) {
+            std::cout << "MiniDB> ";
+            if (!std::getline(std::cin, input)) break;
+            if (input.empty()) continue;
+
+            // Exit condition
+            if (input == "exit") break;
+
+            QueryResult result = db.execute(input);
+            std::cerr << result.error;
+            std::cout << result.message;
+            if (result.cursor) printCursor(*result.cursor, std::cout);
+        }
+    }
+    db.close();
     return 0;
-}
\ No newline at end of file
+}
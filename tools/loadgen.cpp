@@ -0,0 +1,149 @@
+// loadgen.cpp
+// Load generator for the server: client connections each send a statement
+// over and over, keeping up to DEPTH requests in flight (pipelining), and the
+// run reports throughput and latency percentiles.
+// Usage: loadgen ADDRESS [-c connections] [-n requests per connection]
+//                [-d depth] [-r rows] [SQL]
+// With -r, table loadgen(id, name, qty) is created with a hash index on id
+// and filled with that many rows first. Each '?' in SQL is replaced with a
+// random id below the row count (default 1000). The default SQL looks up one
+// row by id.
+#include "Diagnostics.hpp"
+#include "Protocol.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <deque>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+// Connect, retrying for a few seconds while the server starts
+static int connectRetrying(const std::string& address) {
+    for (int attempt = 0;; ++attempt) {
+        int fd;
+        if (attempt == 50) return connectTo(address);
+        {
+            OutputCapture quiet;
+            fd = connectTo(address);
+        }
+        if (fd >= 0) return fd;
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+}
+
+// Run statements one at a time; false if one fails
+static bool runSetup(int fd, const std::vector<std::string>& statements) {
+    for (const std::string& sql : statements) {
+        std::string frame, response;
+        appendFrame(frame, sql);
+        if (!sendAll(fd, frame) || !readFrame(fd, response)) return false;
+        if (!response.empty() && response[0] != static_cast<char>(ResponseStatus::Ok)) {
+            std::cerr << response.substr(1);
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::cerr << "Usage: loadgen ADDRESS [-c connections] [-n requests] [-d depth] [-r rows] [SQL]\n";
+        return 1;
+    }
+    std::string address = argv[1];
+    size_t connections = 8, requests = 10000, depth = 16, rows = 0;
+    std::string sql = "SELECT * FROM loadgen WHERE id = ?";
+    for (int i = 2; i < argc; ++i) {
+        std::string arg = argv[i];
+        size_t* option = arg == "-c" ? &connections : arg == "-n" ? &requests : arg == "-d" ? &depth
+                       : arg == "-r" ? &rows : nullptr;
+        if (option && i + 1 < argc) *option = std::strtoull(argv[++i], nullptr, 10);
+        else sql = arg;
+    }
+    connections = std::max<size_t>(1, connections);
+    depth = std::max<size_t>(1, depth);
+    size_t keys = rows ? rows : 1000;
+
+    int setup = connectRetrying(address);
+    if (setup < 0) return 1;
+    if (rows) {
+        std::vector<std::string> statements = {"CREATE TABLE loadgen (id INT, name TEXT, qty INT)",
+                                               "CREATE INDEX loadgen_id ON loadgen(id)"};
+        for (size_t first = 0; first < rows; first += 1000) {
+            std::string insert = "INSERT INTO loadgen VALUES ";
+            for (size_t id = first; id < std::min(rows, first + 1000); ++id) {
+                insert += (id == first ? "(" : ", (") + std::to_string(id) + ", 'name" + std::to_string(id) + "', " +
+                          std::to_string(id % 100) + ")";
+            }
+            statements.push_back(insert);
+        }
+        if (!runSetup(setup, statements)) return 1;
+    }
+    close(setup);
+
+    std::vector<std::vector<double>> latencies(connections); // microseconds, per connection
+    std::vector<size_t> errors(connections, 0);
+    std::vector<std::thread> clients;
+    auto start = Clock::now();
+    for (size_t c = 0; c < connections; ++c) {
+        clients.emplace_back([&, c]() {
+            int fd = connectRetrying(address);
+            if (fd < 0) return;
+            std::mt19937_64 random(c + 1);
+            std::deque<Clock::time_point> in_flight;
+            std::string frame, response;
+            size_t sent = 0;
+            latencies[c].reserve(requests);
+            while (latencies[c].size() < requests) {
+                // Fill the pipeline, then wait for the oldest response
+                frame.clear();
+                while (sent < requests && in_flight.size() < depth) {
+                    std::string text = sql;
+                    for (size_t q = text.find('?'); q != std::string::npos; q = text.find('?', q)) {
+                        std::string id = std::to_string(random() % keys);
+                        text.replace(q, 1, id);
+                        q += id.size();
+                    }
+                    appendFrame(frame, text);
+                    in_flight.push_back(Clock::now());
+                    ++sent;
+                }
+                if (!frame.empty() && !sendAll(fd, frame)) break;
+                if (!readFrame(fd, response)) break;
+                std::chrono::duration<double, std::micro> latency = Clock::now() - in_flight.front();
+                in_flight.pop_front();
+                latencies[c].push_back(latency.count());
+                if (response.empty() || response[0] != static_cast<char>(ResponseStatus::Ok)) ++errors[c];
+            }
+            close(fd);
+        });
+    }
+    for (auto& client : clients) client.join();
+    std::chrono::duration<double> elapsed = Clock::now() - start;
+
+    std::vector<double> all;
+    size_t failed = 0;
+    for (size_t c = 0; c < connections; ++c) {
+        all.insert(all.end(), latencies[c].begin(), latencies[c].end());
+        failed += errors[c];
+    }
+    if (all.empty()) {
+        std::cerr << "Error: No responses received.\n";
+        return 1;
+    }
+    std::sort(all.begin(), all.end());
+    auto percentile = [&](double p) { return all[std::min(all.size() - 1, static_cast<size_t>(p * all.size()))]; };
+    std::cout << "statement: " << sql << "\n";
+    std::cout << "connections: " << connections << ", pipeline depth: " << depth << ", requests: " << all.size()
+              << " (" << failed << " errors)\n";
+    std::cout << "throughput: " << static_cast<size_t>(all.size() / elapsed.count()) << " statements/s\n";
+    std::cout << "latency: p50 " << percentile(0.50) << " us, p99 " << percentile(0.99) << " us, max "
+              << all.back() << " us\n";
+    return 0;
+}
@@ -0,0 +1,53 @@
+// tblconvert.cpp
+// One-shot conversion of legacy CSV .tbl files to the binary table format.
+// Usage: tblconvert [file.tbl ...]   (defaults to every table in data/)
+#include "TableFile.hpp"
+#include <filesystem>
+#include <iostream>
+
+namespace fs = std::filesystem;
+
+static bool convert(const std::string& filepath) {
+    if (isBinaryTableFile(filepath)) {
+        std::cout << filepath << ": already binary, skipped.\n";
+        return true;
+    }
+    TableData data;
+    if (!readCsvTable(filepath, data)) {
+        return false;
+    }
+    // Keep the original next to the converted table until the user removes it
+    std::string backup = filepath + ".csv.bak";
+    std::error_code ec;
+    fs::copy_file(filepath, backup, fs::copy_options::overwrite_existing, ec);
+    if (ec) {
+        std::cerr << "Error: Unable to back up " << filepath << ": " << ec.message() << "\n";
+        return false;
+    }
+    if (!writeTableFile(filepath, data)) {
+        return false;
+    }
+    std::cout << filepath << ": converted " << data.records.size() << " record(s), original kept as "
+              << backup << ".\n";
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    std::vector<std::string> files;
+    for (int i = 1; i < argc; ++i) {
+        files.emplace_back(argv[i]);
+    }
+    if (files.empty() && fs::is_directory("data")) {
+        for (const auto& entry : fs::directory_iterator("data")) {
+            if (entry.is_regular_file() && entry.path().extension() == ".tbl") {
+                files.push_back(entry.path().string());
+            }
+        }
+    }
+
+    bool ok = true;
+    for (const auto& file : files) {
+        ok = convert(file) && ok;
+    }
+    return ok ? 0 : 1;
+}